@@ -0,0 +1,489 @@
+#include "benchmark.h"
+#include "processmemory.h"
+
+#include <QNativeWebBridge>
+#include <QNativeWebPage>
+#include <QNativeWebStreamReader>
+
+#ifdef HAVE_QWEBCHANNEL
+#  include <QJsonDocument>
+#  include <QJsonObject>
+#  include <QWebChannel>
+#endif
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPointer>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QUrl>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+namespace {
+
+const int RunTimeout = 60000;
+// Calls per run of the bridge benchmarks
+const int BridgeCalls = 1000;
+
+// Runs the calls one after the other, or all at once for a burst. An API is
+// { call: function(i) returning a promise, finish: function() }.
+const char BridgeScript[] = R"JS(
+function runCalls(api, calls, burst) {
+    var done;
+    if (burst) {
+        var pending = [];
+        for (var i = 0; i < calls; ++i) {
+            pending.push(api.call(i));
+        }
+        done = Promise.all(pending);
+    } else {
+        var next = 0;
+        var step = function() {
+            return next < calls ? api.call(next++).then(step) : undefined;
+        };
+        done = Promise.resolve().then(step);
+    }
+    done.then(function() { api.finish(); });
+}
+)JS";
+
+const char NativeBridgeApi[] = R"JS(qnativewebbridge.ready.then(function(objects) {
+    var object = objects.benchmark;
+    return {
+        call: function(i) { return object.echo(i); },
+        finish: function() { object.finish(); }
+    };
+}))JS";
+
+// Bytes handed to the page per run of the postData benchmarks
+const int PostDataSize = 16 * 1024 * 1024;
+
+// The page reports each complete transfer by changing its title
+const char PostDataScript[] = R"JS(
+var received = 0;
+var transfers = 0;
+function receivedAll(size) {
+    document.title = 'received ' + size + ' ' + (++transfers);
+}
+function receiveChunk(buffer, info) {
+    received += buffer.byteLength;
+    if (info.last) {
+        receivedAll(received);
+        received = 0;
+    }
+}
+function receiveBase64(text) {
+    var binary = atob(text);
+    var bytes = new Uint8Array(binary.length);
+    for (var i = 0; i < binary.length; ++i) {
+        bytes[i] = binary.charCodeAt(i);
+    }
+    receivedAll(bytes.byteLength);
+}
+)JS";
+
+// Bytes the page streams per run of the stream benchmarks
+const int StreamSize = 32 * 1024 * 1024;
+const int StreamLine = 64 * 1024;
+
+// The same text as lines of a stream, or as one string
+const char StreamProducer[] = R"JS(function(stream) {
+    var line = 'x'.repeat(%2 - 1) + '\n';
+    var lines = %1 / %2;
+    var written = 0;
+    function next() {
+        return written++ < lines ? stream.write(line).then(next) : undefined;
+    }
+    return next();
+})JS";
+const char StreamString[] = R"JS(('x'.repeat(%2 - 1) + '\n').repeat(%1 / %2))JS";
+
+#ifdef HAVE_QWEBCHANNEL
+const char WebChannelApi[] = R"JS(Promise.resolve(window.__webchannel).then(function(objects) {
+    var object = objects.benchmark;
+    return {
+        call: function(i) {
+            return new Promise(function(resolve) { object.echo(i, resolve); });
+        },
+        finish: function() { object.finish(); }
+    };
+}))JS";
+
+// Starts the page's end of the channel over WebChannelTransport, which calls
+// finish() once it has the objects
+const char WebChannelSetup[] = R"JS(qnativewebbridge.ready.then(function(objects) {
+    var bridgeTransport = objects.webchannelTransport;
+    var transport = {
+        send: function(message) { bridgeTransport.send(message); }
+    };
+    bridgeTransport.messageToPage.connect(function(message) {
+        transport.onmessage({ data: message });
+    });
+    new QWebChannel(transport, function(channel) {
+        window.__webchannel = channel.objects;
+        channel.objects.benchmark.finish();
+    });
+}); 0)JS";
+#endif
+
+QString milliseconds(double nsecs)
+{
+    return QString::number(nsecs / 1e6, 'f', 2);
+}
+
+// Paragraphs of text up to about size bytes of markup
+QString generateDocument(int size)
+{
+    QString html = QStringLiteral("<!DOCTYPE html><html><head><title>Benchmark</title></head>"
+                                  "<body>\n");
+    html.reserve(size + 1024);
+    for (int i = 0; html.size() < size; ++i) {
+        html += QStringLiteral("<p id=\"p%1\">Paragraph %1 of the generated document, with "
+                               "<b>some</b> <i>inline</i> markup and text.</p>\n")
+                        .arg(i);
+    }
+    html += QStringLiteral("</body></html>\n");
+    return html;
+}
+
+} // namespace
+
+#ifdef HAVE_QWEBCHANNEL
+void WebChannelTransport::sendMessage(const QJsonObject &message)
+{
+    emit messageToPage(QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact)));
+}
+
+void WebChannelTransport::send(const QString &message)
+{
+    emit messageReceived(QJsonDocument::fromJson(message.toUtf8()).object(), this);
+}
+#endif
+
+Benchmark::Benchmark(const QString &name, int iterations, const QString &outputFileName,
+                     QObject *parent)
+    : QObject(parent),
+      m_name(name),
+      m_page(new QNativeWebPage(this)),
+      m_object(new BenchmarkObject(this)),
+      m_iterations(qMax(1, iterations)),
+      m_outputFileName(outputFileName)
+{
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(RunTimeout);
+    connect(&m_timeout, &QTimer::timeout, this, [this] { fail(tr("Timed out")); });
+    m_tick.setInterval(1);
+    connect(&m_tick, &QTimer::timeout, this, [this] {
+        Result &result = m_results.last();
+        result.maxStall = qMax(result.maxStall, m_lastTick.restart());
+    });
+
+    if (name == QLatin1String("source")) {
+        addSourceCases();
+    } else if (name == QLatin1String("bridge")) {
+        addBridgeCases();
+    } else if (name == QLatin1String("postdata")) {
+        addPostDataCases();
+    } else if (name == QLatin1String("stream")) {
+        addStreamCases();
+    }
+}
+
+QStringList Benchmark::names()
+{
+    return { QStringLiteral("source"), QStringLiteral("bridge"), QStringLiteral("postdata"),
+             QStringLiteral("stream") };
+}
+
+void Benchmark::start()
+{
+    m_results.clear();
+    nextStep();
+}
+
+// pageSource() against serializing the DOM of a 5 MB document
+void Benchmark::addSourceCases()
+{
+    loadPage(generateDocument(5 * 1024 * 1024));
+    measure(QStringLiteral("pageSource"), QStringLiteral("bytes"), [this](const Done &done) {
+        m_page->pageSource([done](const QByteArray &source) { done(source.size()); });
+    });
+    measure(QStringLiteral("outerHTML"), QStringLiteral("bytes"), [this](const Done &done) {
+        m_page->evaluateJavaScript(QStringLiteral("document.documentElement.outerHTML"),
+                                   [done](const QVariant &result) {
+                                       done(result.toString().toUtf8().size());
+                                   });
+    });
+}
+
+// Calls per second of QNativeWebBridge, and of QWebChannel carried over it when Qt
+// has it
+void Benchmark::addBridgeCases()
+{
+    QString html = QStringLiteral("<!DOCTYPE html><html><head><title>Benchmark</title>");
+#ifdef HAVE_QWEBCHANNEL
+    QFile webChannelScript(QStringLiteral(":/qtwebchannel/qwebchannel.js"));
+    if (webChannelScript.open(QIODevice::ReadOnly)) {
+        html += QStringLiteral("<script>%1</script>")
+                        .arg(QString::fromUtf8(webChannelScript.readAll()));
+    }
+#endif
+    html += QStringLiteral("<script>%1</script></head><body></body></html>\n")
+                    .arg(QLatin1String(BridgeScript));
+
+    // Objects are seen by the documents loaded after they are registered
+    QNativeWebBridge *bridge = new QNativeWebBridge(this);
+    bridge->registerObject(QStringLiteral("benchmark"), m_object);
+#ifdef HAVE_QWEBCHANNEL
+    WebChannelTransport *transport = new WebChannelTransport(this);
+    bridge->registerObject(QStringLiteral("webchannelTransport"), transport);
+    QWebChannel *channel = new QWebChannel(this);
+    channel->registerObject(QStringLiteral("benchmark"), m_object);
+    channel->connectTo(transport);
+#endif
+    m_page->setWebBridge(bridge);
+    loadPage(html);
+    measureCalls(QStringLiteral("bridge sequential"), QLatin1String(NativeBridgeApi), false);
+    measureCalls(QStringLiteral("bridge burst"), QLatin1String(NativeBridgeApi), true);
+
+#ifdef HAVE_QWEBCHANNEL
+    m_steps.append([this] {
+        onceFinished([this] {
+            m_timeout.stop();
+            nextStep();
+        });
+        m_timeout.start();
+        m_page->evaluateJavaScript(QLatin1String(WebChannelSetup));
+    });
+    measureCalls(QStringLiteral("webchannel sequential"), QLatin1String(WebChannelApi), false);
+    measureCalls(QStringLiteral("webchannel burst"), QLatin1String(WebChannelApi), true);
+#else
+    fprintf(stderr, "Qt WebChannel was not found, only QNativeWebBridge is measured\n");
+#endif
+}
+
+void Benchmark::measureCalls(const QString &method, const QString &api, bool burst)
+{
+    measure(method, QStringLiteral("calls"), [this, api, burst](const Done &done) {
+        onceFinished([done] { done(BridgeCalls); });
+        m_page->evaluateJavaScript(
+                QStringLiteral("%1.then(function(api) { runCalls(api, %2, %3); }); 0")
+                        .arg(api, QString::number(BridgeCalls),
+                             burst ? QStringLiteral("true") : QStringLiteral("false")));
+    });
+}
+
+// postData() against the base64 in a script it replaces, for 16 MB
+void Benchmark::addPostDataCases()
+{
+    m_data.resize(PostDataSize);
+    for (int i = 0; i < m_data.size(); ++i) {
+        m_data[i] = char(i * 31 + (i >> 8));
+    }
+
+    loadPage(QStringLiteral("<!DOCTYPE html><html><head><title>Benchmark</title>"
+                            "<script>%1</script></head><body></body></html>\n")
+                     .arg(QLatin1String(PostDataScript)));
+    m_steps.append([this] {
+        // The first postData() installs qnativewebdata in the page
+        m_page->postData(QStringLiteral("setup"), QByteArray(1, 0));
+        m_page->evaluateJavaScript(
+                QStringLiteral("qnativewebdata.addListener('benchmark', receiveChunk); 0"),
+                [this](const QVariant &) { nextStep(); });
+    });
+    measure(QStringLiteral("postData"), QStringLiteral("bytes"), [this](const Done &done) {
+        onceReceived(done);
+        m_page->postData(QStringLiteral("benchmark"), m_data);
+    });
+    measure(QStringLiteral("script"), QStringLiteral("bytes"), [this](const Done &done) {
+        onceReceived(done);
+        m_page->evaluateJavaScript(QStringLiteral("receiveBase64('%1'); 0")
+                                           .arg(QString::fromLatin1(m_data.toBase64())));
+    });
+}
+
+// streamJavaScript() against returning the whole result from a script, for
+// 32 MB of text; the stream should keep the peak memory and the stalls of the
+// event loop to those of a few chunks
+void Benchmark::addStreamCases()
+{
+    loadPage(QStringLiteral("<!DOCTYPE html><html><head><title>Benchmark</title></head>"
+                            "<body></body></html>\n"));
+    measure(QStringLiteral("streamJavaScript"), QStringLiteral("bytes"), [this](const Done &done) {
+        QNativeWebStreamReader *reader = m_page->streamJavaScript(
+                QString::fromLatin1(StreamProducer)
+                        .arg(QString::number(StreamSize), QString::number(StreamLine)));
+        auto received = std::make_shared<qint64>(0);
+        connect(reader, &QIODevice::readyRead, this,
+                [reader, received] { *received += reader->readAll().size(); });
+        connect(reader, &QNativeWebStreamReader::finished, this, [reader, received, done] {
+            *received += reader->readAll().size();
+            reader->deleteLater();
+            done(*received);
+        });
+    });
+    measure(QStringLiteral("evaluateJavaScript"), QStringLiteral("bytes"),
+            [this](const Done &done) {
+                m_page->evaluateJavaScript(
+                        QString::fromLatin1(StreamString)
+                                .arg(QString::number(StreamSize), QString::number(StreamLine)),
+                        [done](const QVariant &result) {
+                            done(result.toString().toUtf8().size());
+                        });
+            });
+}
+
+void Benchmark::onceReceived(const Done &done)
+{
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(m_page, &QNativeWebPage::titleChanged, this,
+                          [connection, done](const QString &title) {
+                              // "received <size> <transfer>"
+                              if (title.startsWith(QLatin1String("received "))) {
+                                  disconnect(*connection);
+                                  done(title.section(QLatin1Char(' '), 1, 1).toLongLong());
+                              }
+                          });
+}
+
+void Benchmark::onceFinished(const std::function<void()> &callback)
+{
+    auto connection = std::make_shared<QMetaObject::Connection>();
+    *connection = connect(m_object, &BenchmarkObject::finished, this, [connection, callback] {
+        disconnect(*connection);
+        callback();
+    });
+}
+
+void Benchmark::loadPage(const QString &html)
+{
+    m_steps.append([this, html] {
+        // Loaded from a file rather than setHtml() so the page has a main resource
+        QTemporaryFile *file =
+                new QTemporaryFile(QDir::tempPath() + QStringLiteral("/benchmark-XXXXXX.html"),
+                                   this);
+        if (!file->open() || file->write(html.toUtf8()) < 0 || !file->flush()) {
+            fail(file->errorString());
+            return;
+        }
+
+        // Backends may report a failed load more than once
+        auto connection = std::make_shared<QMetaObject::Connection>();
+        *connection = connect(m_page, &QNativeWebPage::loadFinished, this,
+                              [this, connection](bool ok) {
+                                  disconnect(*connection);
+                                  m_timeout.stop();
+                                  if (ok) {
+                                      nextStep();
+                                  } else {
+                                      fail(tr("Failed to load the benchmark page"));
+                                  }
+                              });
+        m_timeout.start();
+        m_page->load(QUrl::fromLocalFile(file->fileName()));
+    });
+}
+
+void Benchmark::measure(const QString &method, const QString &unit, const Run &run)
+{
+    m_steps.append([this, method, unit, run] {
+        Result result;
+        result.method = method;
+        result.unit = unit;
+        m_results.append(result);
+        resetPeakResidentMemory();
+        resetPeakWebProcessMemory();
+        m_lastTick.start();
+        m_tick.start();
+        iterate(run);
+    });
+}
+
+void Benchmark::iterate(const Run &run)
+{
+    Result &result = m_results.last();
+    if (result.times.size() >= m_iterations) {
+        m_tick.stop();
+        result.peakMemory = peakResidentMemory();
+        result.webProcessMemory = webProcessMemory();
+        result.webProcessPeakMemory = peakWebProcessMemory();
+        QTimer::singleShot(0, this, &Benchmark::nextStep);
+        return;
+    }
+
+    QPointer<Benchmark> self = this;
+    QElapsedTimer timer;
+    m_timeout.start();
+    timer.start();
+    run([self, run, timer](qint64 count) {
+        if (!self || !self->m_timeout.isActive()) {
+            return;
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+        self->m_timeout.stop();
+        Result &result = self->m_results.last();
+        result.times.append(elapsed);
+        result.count = count;
+        QTimer::singleShot(0, self, [self, run] { self->iterate(run); });
+    });
+}
+
+void Benchmark::nextStep()
+{
+    if (m_steps.isEmpty()) {
+        emit finished(writeReport() ? 0 : 1);
+        return;
+    }
+    m_steps.takeFirst()();
+}
+
+void Benchmark::fail(const QString &error)
+{
+    m_timeout.stop();
+    m_tick.stop();
+    m_steps.clear();
+    fprintf(stderr, "%s: %s\n", qPrintable(m_name), qPrintable(error));
+    emit finished(1);
+}
+
+bool Benchmark::writeReport()
+{
+    QFile file;
+    if (m_outputFileName.isEmpty() || m_outputFileName == QLatin1String("-")) {
+        file.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    } else {
+        file.setFileName(m_outputFileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            fprintf(stderr, "%s\n", qPrintable(file.errorString()));
+            return false;
+        }
+    }
+
+    QTextStream out(&file);
+    out << "benchmark,method,runs,min_ms,median_ms,mean_ms,max_ms,count,unit,per_second,"
+           "max_stall_ms,peak_rss_kib,web_process_kib,web_process_peak_kib\n";
+    for (const Result &result : qAsConst(m_results)) {
+        QList<qint64> times = result.times;
+        std::sort(times.begin(), times.end());
+        double sum = 0;
+        for (const qint64 time : qAsConst(times)) {
+            sum += time;
+        }
+        const double mean = sum / times.size();
+        out << m_name << ',' << result.method << ',' << times.size() << ','
+            << milliseconds(times.first()) << ',' << milliseconds(times.at(times.size() / 2))
+            << ',' << milliseconds(mean) << ',' << milliseconds(times.last()) << ','
+            << result.count << ',' << result.unit << ','
+            << QString::number(mean > 0 ? result.count / (mean / 1e9) : 0, 'f', 0) << ','
+            << result.maxStall << ','
+            << (result.peakMemory < 0 ? -1 : result.peakMemory / 1024) << ','
+            << (result.webProcessMemory < 0 ? -1 : result.webProcessMemory / 1024) << ','
+            << (result.webProcessPeakMemory < 0 ? -1 : result.webProcessPeakMemory / 1024)
+            << '\n';
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+#ifdef HAVE_QWEBCHANNEL
+#  include <QWebChannelAbstractTransport>
+#endif
+
+#include <functional>
+
+class QNativeWebPage;
+
+// Object the bridge benchmarks call from the page
+class BenchmarkObject : public QObject
+{
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+
+    Q_INVOKABLE int echo(int value) const { return value; }
+
+public slots:
+    void finish() { emit finished(); }
+
+signals:
+    void finished();
+};
+
+#ifdef HAVE_QWEBCHANNEL
+// Carries QWebChannel's messages over QNativeWebBridge, so both are measured on
+// the same script message handlers: the page calls send() and listens to
+// messageToPage()
+class WebChannelTransport : public QWebChannelAbstractTransport
+{
+    Q_OBJECT
+
+public:
+    using QWebChannelAbstractTransport::QWebChannelAbstractTransport;
+
+    void sendMessage(const QJsonObject &message) override;
+
+public slots:
+    void send(const QString &message);
+
+signals:
+    void messageToPage(const QString &message);
+};
+#endif
+
+// Times a native path of QNativeWebPage against the JavaScript one it replaces
+// and writes a CSV line per method: the time of a run, its throughput, the
+// longest the event loop was blocked and the peak memory of this process and of
+// the web processes while the method ran; -1 where it can not be measured
+class Benchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    Benchmark(const QString &name, int iterations, const QString &outputFileName,
+              QObject *parent = nullptr);
+
+    static QStringList names();
+
+public slots:
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    // Called by a run when it completes with the bytes or calls it handled
+    using Done = std::function<void(qint64 count)>;
+    using Run = std::function<void(const Done &done)>;
+
+    struct Result
+    {
+        QString method;
+        QString unit;
+        QList<qint64> times;
+        qint64 count = 0;
+        // Longest gap between two iterations of the event loop
+        qint64 maxStall = 0;
+        qint64 peakMemory = -1;
+        qint64 webProcessMemory = -1;
+        qint64 webProcessPeakMemory = -1;
+    };
+
+    void addSourceCases();
+    void addBridgeCases();
+    void measureCalls(const QString &method, const QString &api, bool burst);
+    void addPostDataCases();
+    void addStreamCases();
+
+    void loadPage(const QString &html);
+    void measure(const QString &method, const QString &unit, const Run &run);
+    void iterate(const Run &run);
+    void onceFinished(const std::function<void()> &callback);
+    void onceReceived(const Done &done);
+    void nextStep();
+    void fail(const QString &error);
+    bool writeReport();
+
+    QString m_name;
+    QNativeWebPage *m_page;
+    BenchmarkObject *m_object;
+    QByteArray m_data;
+    int m_iterations;
+    QString m_outputFileName;
+    QList<std::function<void()>> m_steps;
+    QList<Result> m_results;
+    QTimer m_timeout;
+    // Ticks while a method is measured, to see how long the event loop blocks
+    QTimer m_tick;
+    QElapsedTimer m_lastTick;
+};
+
+#endif // BENCHMARK_H
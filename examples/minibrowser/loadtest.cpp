@@ -0,0 +1,212 @@
+#include "loadtest.h"
+#include "processmemory.h"
+
+#include <QNativeWebPage>
+#include <QNativeWebView>
+
+#include <QFile>
+#include <QPointer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+const int LoadTimeout = 30000;
+
+QString milliseconds(double nsecs)
+{
+    return QString::number(nsecs / 1e6, 'f', 2);
+}
+
+qint64 totalMemory()
+{
+    return qMax<qint64>(residentMemory(), 0) + qMax<qint64>(webProcessMemory(), 0);
+}
+
+} // namespace
+
+LoadTest::LoadTest(const QList<QUrl> &urls, int iterations, const QString &outputFileName,
+                   bool inView, QObject *parent)
+    : QObject(parent),
+      m_urls(urls),
+      m_iterations(qMax(1, iterations)),
+      m_outputFileName(outputFileName),
+      m_baseMemory(totalMemory())
+{
+    if (inView) {
+        m_view = new QNativeWebView;
+        m_view->resize(1280, 800);
+        m_view->show();
+        m_page = m_view->page();
+    } else {
+        m_page = new QNativeWebPage(this);
+    }
+    connect(m_page, &QNativeWebPage::loadFinished, this, &LoadTest::loadDone);
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(LoadTimeout);
+    connect(&m_timeout, &QTimer::timeout, this, [this] {
+        if (m_evaluating) {
+            // The page loaded but does not answer scripts
+            m_evaluating = false;
+            sampleDone(Sample{ false, m_loadTimer.nsecsElapsed(), -1 });
+            return;
+        }
+        m_page->stop();
+        loadDone(false);
+    });
+}
+
+LoadTest::~LoadTest()
+{
+    delete m_view;
+}
+
+QList<QUrl> LoadTest::readUrls(const QString &fileName, QString *errorString)
+{
+    QList<QUrl> urls;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *errorString = file.errorString();
+        return urls;
+    }
+    // One URL per line, blank lines and lines starting with # are skipped
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (!line.isEmpty() && !line.startsWith(QLatin1Char('#'))) {
+            urls.append(QUrl::fromUserInput(line));
+        }
+    }
+    if (urls.isEmpty()) {
+        *errorString = tr("%1 lists no URLs").arg(fileName);
+    }
+    return urls;
+}
+
+void LoadTest::start()
+{
+    m_next = 0;
+    m_samples.clear();
+    m_runTimer.start();
+    loadNext();
+}
+
+void LoadTest::loadNext()
+{
+    if (m_next >= m_urls.size() * m_iterations) {
+        printSummary();
+        emit finished(writeReport() ? 0 : 1);
+        return;
+    }
+
+    const QUrl url = m_urls.at(m_next % m_urls.size());
+    fprintf(stderr, "[%d/%d] %s\n", m_next + 1, int(m_urls.size() * m_iterations),
+            qPrintable(url.toString()));
+    m_loading = true;
+    m_timeout.start();
+    m_loadTimer.start();
+    m_page->load(url);
+}
+
+void LoadTest::loadDone(bool ok)
+{
+    // Backends may report a failed load more than once
+    if (!m_loading) {
+        return;
+    }
+    m_loading = false;
+
+    Sample sample{ ok, m_loadTimer.nsecsElapsed(), -1 };
+    if (!ok) {
+        // A hung page may not answer scripts either
+        m_timeout.stop();
+        sampleDone(sample);
+        return;
+    }
+
+    // The timeout keeps running until the page answers
+    m_evaluating = true;
+    const int next = m_next;
+    QPointer<LoadTest> self = this;
+    QElapsedTimer roundTrip;
+    roundTrip.start();
+    m_page->evaluateJavaScript(QStringLiteral("0"),
+                               [self, next, sample, roundTrip](const QVariant &) mutable {
+                                   // Late answers of timed out samples are dropped
+                                   if (!self || !self->m_evaluating || self->m_next != next) {
+                                       return;
+                                   }
+                                   self->m_evaluating = false;
+                                   self->m_timeout.stop();
+                                   sample.roundTrip = roundTrip.nsecsElapsed();
+                                   self->sampleDone(sample);
+                               });
+}
+
+void LoadTest::sampleDone(const Sample &sample)
+{
+    m_samples[m_urls.at(m_next % m_urls.size())].append(sample);
+    ++m_next;
+    QTimer::singleShot(0, this, &LoadTest::loadNext);
+}
+
+void LoadTest::printSummary()
+{
+    // Memory is read with the last page still loaded
+    const double seconds = m_runTimer.nsecsElapsed() / 1e9;
+    fprintf(stderr, "%s: %d loads, %.2f pages/s, %lld KiB for the page and its web processes\n",
+            m_view ? "view" : "page", m_next, seconds > 0 ? m_next / seconds : 0.0,
+            (totalMemory() - m_baseMemory) / 1024);
+}
+
+bool LoadTest::writeReport()
+{
+    QFile file;
+    if (m_outputFileName.isEmpty() || m_outputFileName == QLatin1String("-")) {
+        file.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    } else {
+        file.setFileName(m_outputFileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            fprintf(stderr, "%s\n", qPrintable(file.errorString()));
+            return false;
+        }
+    }
+
+    QTextStream out(&file);
+    out << "url,loads,failures,min_ms,median_ms,mean_ms,p95_ms,max_ms,mean_js_round_trip_ms\n";
+    for (const QUrl &url : qAsConst(m_urls)) {
+        // The same URL may be listed more than once
+        if (!m_samples.contains(url)) {
+            continue;
+        }
+        const QList<Sample> samples = m_samples.take(url);
+        QList<qint64> loadTimes;
+        double roundTrips = 0;
+        for (const Sample &sample : samples) {
+            if (sample.ok) {
+                loadTimes.append(sample.loadTime);
+                roundTrips += sample.roundTrip;
+            }
+        }
+        std::sort(loadTimes.begin(), loadTimes.end());
+
+        out << '"' << url.toString().replace(QLatin1Char('"'), QLatin1String("\"\"")) << "\","
+            << samples.size() << ',' << samples.size() - loadTimes.size() << ',';
+        if (loadTimes.isEmpty()) {
+            out << ",,,,,\n";
+            continue;
+        }
+        double sum = 0;
+        for (const qint64 loadTime : qAsConst(loadTimes)) {
+            sum += loadTime;
+        }
+        out << milliseconds(loadTimes.first()) << ','
+            << milliseconds(loadTimes.at(loadTimes.size() / 2)) << ','
+            << milliseconds(sum / loadTimes.size()) << ','
+            << milliseconds(loadTimes.at((loadTimes.size() - 1) * 95 / 100)) << ','
+            << milliseconds(loadTimes.last()) << ','
+            << milliseconds(roundTrips / loadTimes.size()) << '\n';
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef LOADTEST_H
+#define LOADTEST_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+#include <QUrl>
+
+class QNativeWebPage;
+class QNativeWebView;
+
+// Loads a list of URLs a number of times and writes a CSV summary per URL: load
+// times and the JavaScript round trip after each load. The loads run in a page
+// without a window, or in a shown QNativeWebView to compare the two; pages per
+// second and the memory the page costs are printed to stderr.
+class LoadTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    LoadTest(const QList<QUrl> &urls, int iterations, const QString &outputFileName,
+             bool inView = false, QObject *parent = nullptr);
+    ~LoadTest();
+
+    static QList<QUrl> readUrls(const QString &fileName, QString *errorString);
+
+public slots:
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    struct Sample
+    {
+        bool ok;
+        qint64 loadTime;
+        qint64 roundTrip;
+    };
+
+    void loadNext();
+    void loadDone(bool ok);
+    void sampleDone(const Sample &sample);
+    bool writeReport();
+    void printSummary();
+
+    QNativeWebView *m_view = nullptr;
+    QNativeWebPage *m_page;
+    QList<QUrl> m_urls;
+    int m_iterations;
+    QString m_outputFileName;
+    int m_next = 0;
+    bool m_loading = false;
+    // Between the end of a load and the answer to the script after it
+    bool m_evaluating = false;
+    QElapsedTimer m_loadTimer;
+    QElapsedTimer m_runTimer;
+    // Memory of this process and the web processes before the page was created
+    qint64 m_baseMemory;
+    QTimer m_timeout;
+    QHash<QUrl, QList<Sample>> m_samples;
+};
+
+#endif // LOADTEST_H
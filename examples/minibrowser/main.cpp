@@ -1,11 +1,92 @@
 #include "mainwindow.h"
+#include "benchmark.h"
+#include "loadtest.h"
+
+#include <QNativeWebPage>
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+
+#include <cstdio>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Minimal browser built on QNativeWebView"));
+    parser.addHelpOption();
+    const QCommandLineOption hudOption(QStringLiteral("hud"),
+                                       QStringLiteral("Show the performance overlay."));
+    const QCommandLineOption loadTestOption(
+            QStringLiteral("load-test"),
+            QStringLiteral("Load the URLs listed in <file> and write a CSV summary; without a "
+                           "window unless --view is given."),
+            QStringLiteral("file"));
+    const QCommandLineOption viewOption(
+            QStringLiteral("view"),
+            QStringLiteral("Run the load test in a shown QNativeWebView instead of a page "
+                           "without a window."));
+    const QCommandLineOption benchmarkOption(
+            QStringLiteral("benchmark"),
+            QStringLiteral("Time a native path against its JavaScript counterpart and write "
+                           "a CSV summary; <name> is one of: %1.")
+                    .arg(Benchmark::names().join(QStringLiteral(", "))),
+            QStringLiteral("name"));
+    const QCommandLineOption iterationsOption(
+            QStringLiteral("iterations"),
+            QStringLiteral("Number of passes the load test makes over the URLs, or of runs "
+                           "of each benchmarked method."),
+            QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption outputOption(
+            QStringLiteral("output"),
+            QStringLiteral("Write the load test or benchmark summary to <file> instead of "
+                           "stdout."),
+            QStringLiteral("file"));
+    const QCommandLineOption backendOption(
+            QStringLiteral("backend"),
+            QStringLiteral("Web engine backend, one of: %1.")
+                    .arg(QNativeWebPage::availableBackends().join(QStringLiteral(", "))),
+            QStringLiteral("name"));
+    parser.addOptions({ hudOption, loadTestOption, viewOption, benchmarkOption,
+                        iterationsOption, outputOption, backendOption });
+    parser.process(a);
+
+    if (parser.isSet(backendOption)
+        && !QNativeWebPage::setDefaultBackend(parser.value(backendOption))) {
+        fprintf(stderr, "Unknown backend %s\n", qPrintable(parser.value(backendOption)));
+        return 1;
+    }
+
+    if (parser.isSet(loadTestOption)) {
+        QString error;
+        const QList<QUrl> urls = LoadTest::readUrls(parser.value(loadTestOption), &error);
+        if (urls.isEmpty()) {
+            fprintf(stderr, "%s\n", qPrintable(error));
+            return 1;
+        }
+        LoadTest test(urls, parser.value(iterationsOption).toInt(), parser.value(outputOption),
+                      parser.isSet(viewOption));
+        QObject::connect(&test, &LoadTest::finished, &a, &QCoreApplication::exit);
+        QTimer::singleShot(0, &test, &LoadTest::start);
+        return a.exec();
+    }
+
+    if (parser.isSet(benchmarkOption)) {
+        if (!Benchmark::names().contains(parser.value(benchmarkOption))) {
+            fprintf(stderr, "Unknown benchmark %s\n", qPrintable(parser.value(benchmarkOption)));
+            return 1;
+        }
+        Benchmark benchmark(parser.value(benchmarkOption), parser.value(iterationsOption).toInt(),
+                            parser.value(outputOption));
+        QObject::connect(&benchmark, &Benchmark::finished, &a, &QCoreApplication::exit);
+        QTimer::singleShot(0, &benchmark, &Benchmark::start);
+        return a.exec();
+    }
+
     MainWindow w;
+    w.setHudVisible(parser.isSet(hudOption));
     w.show();
     return a.exec();
 }
@@ -1,10 +1,10 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
+#include "performancehud.h"
 
 #include <QDebug>
 #include <QAction>
 #include <QIcon>
-#include <QJsonDocument>
 #include <QStyle>
 #include <QPixmap>
 
@@ -17,23 +17,17 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     ui->actionForward->setIcon(style()->standardIcon(QStyle::SP_ArrowForward));
     ui->actionRefresh->setIcon(style()->standardIcon(QStyle::SP_BrowserReload));
 
+    m_hud = new PerformanceHud(ui->widgetBrowser);
+    m_hud->hide();
+
     connect(ui->widgetBrowser, &QNativeWebView::titleChanged, this, &MainWindow::setWindowTitle);
+    // Only the load boundaries are logged, per-progress logging and fetching every
+    // cookie after each load would distort what the HUD measures
     connect(ui->widgetBrowser, &QNativeWebView::loadStarted, this, [&] {
-        qInfo() << "loadStarted";
         ui->logEdit->appendPlainText("loadStarted");
     });
     connect(ui->widgetBrowser, &QNativeWebView::loadFinished, this, [&](bool ok) {
-        qInfo() << "loadFinished" << ok;
         ui->logEdit->appendPlainText(QString("loadFinished: %1").arg(ok));
-        qInfo() << "user agent:" << ui->widgetBrowser->userAgent();
-        ui->widgetBrowser->allCookies([&](const QJsonObject &cookies) {
-            qInfo() << "cookies:" << cookies;
-            ui->logEdit->appendPlainText("cookies:" + QJsonDocument(cookies).toJson());
-        });
-    });
-    connect(ui->widgetBrowser, &QNativeWebView::loadProgress, this, [&](int progress) {
-        qInfo() << "loadProgress" << progress;
-        ui->logEdit->appendPlainText(QString("loadProgress: %1").arg(progress));
     });
     connect(ui->widgetBrowser, &QNativeWebView::errorOccurred, this, [&](const QString &error) {
         qInfo() << "errorOccurred" << error;
@@ -72,6 +66,16 @@ void MainWindow::on_actionForward_triggered(bool checked)
 
 void MainWindow::on_actionRefresh_triggered(bool checked) { }
 
+void MainWindow::on_actionHud_toggled(bool checked)
+{
+    m_hud->setVisible(checked);
+}
+
+void MainWindow::setHudVisible(bool visible)
+{
+    ui->actionHud->setChecked(visible);
+}
+
 void MainWindow::on_buttonRunJs_clicked()
 {
     const QString code = ui->jsEdit->toPlainText().trimmed();
@@ -9,6 +9,8 @@ class MainWindow;
 }
 QT_END_NAMESPACE
 
+class PerformanceHud;
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -17,14 +19,18 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    void setHudVisible(bool visible);
+
 public slots:
     void on_urlEdit_returnPressed();
     void on_actionBack_triggered(bool checked = false);
     void on_actionForward_triggered(bool checked = false);
     void on_actionRefresh_triggered(bool checked = false);
+    void on_actionHud_toggled(bool checked);
     void on_buttonRunJs_clicked();
 
 private:
     Ui::MainWindow *ui;
+    PerformanceHud *m_hud;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,135 @@
+#include "performancehud.h"
+#include "processmemory.h"
+
+#include <QNativeWebView>
+
+#include <QEvent>
+#include <QPointer>
+
+namespace {
+
+QString milliseconds(qint64 nsecs)
+{
+    return nsecs < 0 ? QStringLiteral("-") : QString::number(nsecs / 1e6, 'f', 2);
+}
+
+} // namespace
+
+PerformanceHud::PerformanceHud(QNativeWebView *view) : QLabel(view), m_view(view)
+{
+    // The view shows a native window; the overlay needs one of its own to be
+    // stacked above it
+    setAttribute(Qt::WA_NativeWindow);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setStyleSheet(QStringLiteral("background: rgba(0, 0, 0, 180); color: #7fff7f;"
+                                 "font-family: monospace; padding: 6px;"));
+
+    connect(view, &QNativeWebView::loadStarted, this, [this] { m_loadTimer.start(); });
+    connect(view, &QNativeWebView::loadFinished, this, [this] {
+        if (m_loadTimer.isValid()) {
+            m_loadTime = m_loadTimer.nsecsElapsed();
+            m_loadTimer.invalidate();
+            updateText();
+        }
+    });
+    view->installEventFilter(this);
+
+    m_sampleTimer.setInterval(1000);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &PerformanceHud::sample);
+    updateText();
+}
+
+bool PerformanceHud::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_view && event->type() == QEvent::Resize) {
+        updatePosition();
+        if (isVisible()) {
+            m_resizeTimer.start();
+            pollResize(m_view->width(), ++m_resizeGeneration);
+        }
+    }
+    return QLabel::eventFilter(watched, event);
+}
+
+void PerformanceHud::showEvent(QShowEvent *event)
+{
+    QLabel::showEvent(event);
+    updatePosition();
+    raise();
+    sample();
+    m_sampleTimer.start();
+}
+
+void PerformanceHud::hideEvent(QHideEvent *event)
+{
+    m_sampleTimer.stop();
+    QLabel::hideEvent(event);
+}
+
+void PerformanceHud::sample()
+{
+    QPointer<PerformanceHud> self = this;
+    QElapsedTimer roundTrip;
+    roundTrip.start();
+    m_view->evaluateJavaScript(QStringLiteral("0"), [self, roundTrip](const QVariant &) {
+        if (self) {
+            self->m_roundTrip = roundTrip.nsecsElapsed();
+            self->updateText();
+        }
+    });
+
+    m_memory = webProcessMemory();
+    m_memoryIsJsHeap = false;
+    if (m_memory < 0) {
+        // Chromium based backends report their JavaScript heap
+        m_view->evaluateJavaScript(
+                QStringLiteral("performance.memory ? performance.memory.usedJSHeapSize : -1"),
+                [self](const QVariant &result) {
+                    if (self) {
+                        self->m_memory = qint64(result.toDouble());
+                        self->m_memoryIsJsHeap = true;
+                        self->updateText();
+                    }
+                });
+    }
+    updateText();
+}
+
+void PerformanceHud::pollResize(int width, int generation)
+{
+    QPointer<PerformanceHud> self = this;
+    m_view->evaluateJavaScript(
+            QStringLiteral("window.innerWidth"), [self, width, generation](const QVariant &result) {
+                if (!self || generation != self->m_resizeGeneration) {
+                    return;
+                }
+                if (result.toInt() == width) {
+                    self->m_resizeCost = self->m_resizeTimer.nsecsElapsed();
+                    self->updateText();
+                } else if (self->m_resizeTimer.elapsed() < 2000) {
+                    self->pollResize(width, generation);
+                }
+            });
+}
+
+void PerformanceHud::updateText()
+{
+    const QString memory = m_memory < 0
+            ? QStringLiteral("-")
+            : QStringLiteral("%1 MB%2")
+                      .arg(QString::number(m_memory / 1048576.0, 'f', 1),
+                           m_memoryIsJsHeap ? QStringLiteral(" (JS heap)") : QString());
+    setText(QStringLiteral("load      %1 ms\n"
+                           "js rtt    %2 ms\n"
+                           "memory    %3\n"
+                           "resize    %4 ms")
+                    .arg(milliseconds(m_loadTime), milliseconds(m_roundTrip), memory,
+                         milliseconds(m_resizeCost)));
+    adjustSize();
+    updatePosition();
+}
+
+void PerformanceHud::updatePosition()
+{
+    move(m_view->width() - width() - 8, 8);
+}
@@ -0,0 +1,45 @@
+#ifndef PERFORMANCEHUD_H
+#define PERFORMANCEHUD_H
+
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QTimer>
+
+class QNativeWebView;
+
+// Overlay in the corner of a view with the time of the last load, the
+// JavaScript round-trip latency, the web process memory and how long the page
+// took to see the last resize
+class PerformanceHud : public QLabel
+{
+    Q_OBJECT
+
+public:
+    explicit PerformanceHud(QNativeWebView *view);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void sample();
+    // Polls window.innerWidth until the page has the new width
+    void pollResize(int width, int generation);
+    void updateText();
+    void updatePosition();
+
+    QNativeWebView *m_view;
+    QTimer m_sampleTimer;
+    QElapsedTimer m_loadTimer;
+    QElapsedTimer m_resizeTimer;
+    int m_resizeGeneration = 0;
+    // Times in nanoseconds and memory in bytes, negative while unknown
+    qint64 m_loadTime = -1;
+    qint64 m_roundTrip = -1;
+    qint64 m_resizeCost = -1;
+    qint64 m_memory = -1;
+    bool m_memoryIsJsHeap = false;
+};
+
+#endif // PERFORMANCEHUD_H
@@ -0,0 +1,141 @@
+#include "processmemory.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+
+#ifdef Q_OS_LINUX
+#  include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// Process ids of the WebKit web processes started by this application
+QStringList webProcessIds()
+{
+    const QByteArray parent = QByteArray::number(QCoreApplication::applicationPid());
+    QStringList result;
+    const QStringList pids = QDir(QStringLiteral("/proc")).entryList(QDir::Dirs);
+    for (const QString &pid : pids) {
+        QFile stat(QStringLiteral("/proc/%1/stat").arg(pid));
+        if (!stat.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        // pid (comm) state ppid ...
+        const QByteArray line = stat.readAll();
+        const int commEnd = line.lastIndexOf(')');
+        const QList<QByteArray> fields = line.mid(commEnd + 2).split(' ');
+        // comm is truncated to 15 characters
+        if (commEnd >= 0 && fields.size() >= 2 && fields.at(1) == parent
+            && line.contains("(WebKitWebProces")) {
+            result.append(pid);
+        }
+    }
+    return result;
+}
+
+// VmHWM of /proc/<pid>/status
+qint64 peakMemory(const QString &pid)
+{
+    QFile status(QStringLiteral("/proc/%1/status").arg(pid));
+    if (status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!status.atEnd()) {
+            // "VmHWM:     12345 kB"
+            const QByteArray line = status.readLine();
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong() * 1024;
+            }
+        }
+    }
+    return -1;
+}
+
+bool resetPeakMemory(const QString &pid)
+{
+    // Linux 4.0 and later
+    QFile clearRefs(QStringLiteral("/proc/%1/clear_refs").arg(pid));
+    return clearRefs.open(QIODevice::WriteOnly) && clearRefs.write("5") == 1;
+}
+#endif
+
+} // namespace
+
+qint64 webProcessMemory()
+{
+#ifdef Q_OS_LINUX
+    const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    qint64 total = -1;
+    const QStringList pids = webProcessIds();
+    for (const QString &pid : pids) {
+        QFile statm(QStringLiteral("/proc/%1/statm").arg(pid));
+        if (statm.open(QIODevice::ReadOnly)) {
+            const qint64 residentPages = statm.readAll().split(' ').value(1).toLongLong();
+            total = qMax<qint64>(total, 0) + residentPages * pageSize;
+        }
+    }
+    return total;
+#else
+    return -1;
+#endif
+}
+
+qint64 peakWebProcessMemory()
+{
+#ifdef Q_OS_LINUX
+    qint64 total = -1;
+    const QStringList pids = webProcessIds();
+    for (const QString &pid : pids) {
+        const qint64 peak = peakMemory(pid);
+        if (peak >= 0) {
+            total = qMax<qint64>(total, 0) + peak;
+        }
+    }
+    return total;
+#else
+    return -1;
+#endif
+}
+
+bool resetPeakWebProcessMemory()
+{
+#ifdef Q_OS_LINUX
+    const QStringList pids = webProcessIds();
+    bool reset = !pids.isEmpty();
+    for (const QString &pid : pids) {
+        reset = resetPeakMemory(pid) && reset;
+    }
+    return reset;
+#else
+    return false;
+#endif
+}
+
+qint64 residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (statm.open(QIODevice::ReadOnly)) {
+        return statm.readAll().split(' ').value(1).toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return -1;
+}
+
+qint64 peakResidentMemory()
+{
+#ifdef Q_OS_LINUX
+    return peakMemory(QStringLiteral("self"));
+#else
+    return -1;
+#endif
+}
+
+bool resetPeakResidentMemory()
+{
+#ifdef Q_OS_LINUX
+    return resetPeakMemory(QStringLiteral("self"));
+#else
+    return false;
+#endif
+}
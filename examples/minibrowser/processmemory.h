@@ -0,0 +1,22 @@
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QtGlobal>
+
+// Memory figures in bytes, -1 where the platform does not report them. Only
+// Linux is supported.
+
+// Resident memory of the WebKit web processes started by this application, and
+// the sum of their peaks since they started or since the last
+// resetPeakWebProcessMemory(). Sandboxed web processes are not our children and
+// are not found.
+qint64 webProcessMemory();
+qint64 peakWebProcessMemory();
+bool resetPeakWebProcessMemory();
+// Resident memory of this process, and its peak since it started or since the
+// last resetPeakResidentMemory()
+qint64 residentMemory();
+qint64 peakResidentMemory();
+bool resetPeakResidentMemory();
+
+#endif // PROCESSMEMORY_H
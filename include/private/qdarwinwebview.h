@@ -11,7 +11,7 @@ class QDarwinWebViewPrivate : public QNativeWebViewPrivate
 {
     Q_OBJECT
 public:
-    explicit QDarwinWebViewPrivate(QObject *parent = nullptr);
+    explicit QDarwinWebViewPrivate(QNativeWebProfile *profile, QObject *parent = nullptr);
     ~QDarwinWebViewPrivate();
 
     void load(const QUrl &url) override;
@@ -35,15 +35,31 @@ public:
     void evaluateJavaScript(const QString &scriptSource,
                             const std::function<void(const QVariant &)> &callback = {}) override;
 
+public Q_SLOTS:
+    void applySettings() override;
+    void applyUserContent() override;
+
+protected:
+    void registerMessageHandler(const QString &name) override;
+    void unregisterMessageHandler(const QString &name) override;
+
 private Q_SLOTS:
     void updateWindowGeometry();
     void initialize();
 
 public:
+    // Called by the navigation delegate
+    void webContentProcessDidTerminate();
+    // Called by the script message handlers
+    void scriptMessageReceived(const QString &name, const QString &message);
+
     QString m_error;
     WKNavigation *m_navigation;
 
 private:
+    // Keeps the profile's cookie mirror current from the cookie store observer
+    void watchCookies();
+
     WKWebView *m_webview;
     QWindow *m_window;
 };
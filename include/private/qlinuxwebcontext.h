@@ -0,0 +1,54 @@
+#ifndef QLINUXWEBCONTEXT_H
+#define QLINUXWEBCONTEXT_H
+
+#include "qnativewebprofile_p.h"
+
+// Profile-wide WebKit state: the web context shared by the profile's views, its
+// website data manager and the native objects of the profile's user content.
+// Persistent profiles without a storage name share WebKit's default context.
+// Named profiles have a context and a data manager with directories of their own,
+// each ephemeral profile has an ephemeral context.
+class QLinuxWebContext : public QNativeWebProfileBackend
+{
+public:
+    explicit QLinuxWebContext(QNativeWebProfile *profile);
+    ~QLinuxWebContext();
+
+    // Creates the context of a profile made while another backend was the default
+    static QLinuxWebContext *get(QNativeWebProfile *profile)
+    {
+        QNativeWebProfilePrivate *d = QNativeWebProfilePrivate::get(profile);
+        if (d->backendName != QLatin1String("webkitgtk")) {
+            d->createBackend(QStringLiteral("webkitgtk"));
+        }
+        return static_cast<QLinuxWebContext *>(d->backend);
+    }
+
+    void *context() const { return m_context; } // WebKitWebContext
+
+    // Adds the profile's scripts and stylesheets to a view's user content manager.
+    // The WebKitUserScript and WebKitUserStyleSheet objects are created once per
+    // profile, every view only adds a reference to its own manager.
+    void addUserContent(void *manager); // WebKitUserContentManager
+
+    // Called by the views created in the context; the data of an ephemeral
+    // context is cleared when its last view is gone
+    void addView() { ++m_views; }
+    void removeView();
+
+    void websiteDataUsage(QNativeWebProfile::WebsiteDataTypes types,
+                          const std::function<void(const QList<QNativeWebProfile::WebsiteData> &)>
+                                  &callback) override;
+    void removeWebsiteData(QNativeWebProfile::WebsiteDataTypes types, const QStringList &origins,
+                           const std::function<void()> &callback) override;
+    void clearWebsiteData(QNativeWebProfile::WebsiteDataTypes types, const QDateTime &since,
+                          const std::function<void()> &callback) override;
+    void setProxy(const QNetworkProxy &proxy) override;
+    bool sharesWebsiteData() const override;
+
+private:
+    void *m_context; // WebKitWebContext
+    int m_views = 0;
+};
+
+#endif // QLINUXWEBCONTEXT_H
@@ -3,11 +3,16 @@
 
 #include "qnativewebview_p.h"
 
+#include <QHash>
+#include <QPointer>
+
+struct QLinuxHarResource;
+
 class QLinuxWebViewPrivate : public QNativeWebViewPrivate
 {
     Q_OBJECT
 public:
-    explicit QLinuxWebViewPrivate(QObject *parent = nullptr);
+    explicit QLinuxWebViewPrivate(QNativeWebProfile *profile, QObject *parent = nullptr);
     ~QLinuxWebViewPrivate();
 
     void load(const QUrl &url) override;
@@ -27,18 +32,57 @@ public:
     void deleteAllCookies() override;
     void evaluateJavaScript(const QString &scriptSource,
                             const std::function<void(const QVariant &)> &callback = {}) override;
+    void pageSource(const std::function<void(const QByteArray &)> &callback) override;
+    void setViewportSize(const QSize &size) override;
+    void snapshot(const std::function<void(const QImage &)> &callback) override;
+
+public Q_SLOTS:
+    void applySettings() override;
+    void applyUserContent() override;
+
+protected:
+    void registerMessageHandler(const QString &name) override;
+    void unregisterMessageHandler(const QString &name) override;
+    QString postedDataUrl(int id, const PostedData &posted) const override;
+    bool captureResources(bool enabled) override;
 
 private Q_SLOTS:
     void updateWindowGeometry();
     void initialize();
 
 public:
+    // Serves a chunk of data posted to the page, called by the context's scheme handler
+    void finishDataRequest(void *request); // WebKitURISchemeRequest
+
     QString m_error;
 
 private:
+    void createNativeWindow();
+    // One-time setup of a web context that may be shared by many views: serves
+    // installed QNativeWebAssetPacks and enables the on-disk favicon database
+    static void initializeContext(void *context); // WebKitWebContext
+    void updateIcon();
+    // Keeps the profile's cookie mirror current from the cookie manager
+    void watchCookies();
+    void onDownloadStarted(void *download); // WebKitDownload
+    void attachDownload(QNativeWebDownload *item, void *download);
+    void resumeDownload(QNativeWebDownload *item);
+    // Follows a resource load for the HAR capture until it finishes
+    void trackResource(void *resource, void *request); // WebKitWebResource, WebKitURIRequest
+    void untrackResource(void *resource);
+
     void *m_webview; // WebKitWebView
-    void *m_widget; // GtkWidget
+    void *m_widget; // GtkWidget (GtkPlug)
+    void *m_offscreen; // GtkWidget (GtkOffscreenWindow)
     QWindow *m_window;
+    // Download being restarted, picked up by the next download-started
+    QPointer<QNativeWebDownload> m_resumingDownload;
+    // script-message-received handler ids by message handler name
+    QHash<QString, unsigned long> m_messageHandlerIds;
+    // resource-load-started handler id while capturing
+    unsigned long m_resourceHandlerId = 0;
+    // Loads in progress by WebKitWebResource
+    QHash<void *, QLinuxHarResource *> m_harResources;
 };
 
 #endif // QLINUXWEBVIEW_H
@@ -0,0 +1,61 @@
+#ifndef QNATIVEWEBCONSOLEBUFFER_P_H
+#define QNATIVEWEBCONSOLEBUFFER_P_H
+
+#include "qnativewebpage.h"
+
+#include <atomic>
+#include <memory>
+
+// Fixed-size ring of the last console messages of a page. Entries have a fixed
+// size, longer texts are truncated, and the oldest entry is overwritten when the
+// ring is full, so appending never allocates. Every slot is guarded by its own
+// sequence number: appending and draining happen on the GUI thread, dump() may
+// run on any thread at the same time, without locks, and skips the slots being
+// overwritten.
+class QNativeWebConsoleBuffer
+{
+public:
+    explicit QNativeWebConsoleBuffer(int capacity);
+
+    int capacity() const { return m_capacity; }
+
+    void append(QNativeWebConsoleMessage::Level level, qint64 timestamp,
+                const QByteArray &message, const QByteArray &source, int line, int column);
+    // Entries appended since the previous drain, oldest first
+    QList<QNativeWebConsoleMessage> drain();
+    // Entries overwritten before they were drained
+    quint64 dropped() const { return m_dropped; }
+    // Writes every entry in the ring as a line of text with write(2) only, so it
+    // can be called from a signal handler
+    void dump(int fd) const;
+
+private:
+    enum { MessageSize = 240, SourceSize = 120 };
+
+    struct Slot
+    {
+        // 2 * position + 1 while the entry at position is written, + 2 once written
+        std::atomic<quint64> sequence{ 0 };
+        qint64 timestamp = 0;
+        qint32 line = 0;
+        qint32 column = 0;
+        quint8 level = 0;
+        quint8 messageSize = 0;
+        quint8 sourceSize = 0;
+        char message[MessageSize];
+        char source[SourceSize];
+    };
+
+    // Copies the entry at position into slot, false if it was overwritten
+    bool read(quint64 position, Slot *slot) const;
+
+    const int m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+    // Entries appended so far
+    std::atomic<quint64> m_head{ 0 };
+    // Next entry to drain
+    quint64 m_tail = 0;
+    quint64 m_dropped = 0;
+};
+
+#endif // QNATIVEWEBCONSOLEBUFFER_P_H
@@ -0,0 +1,47 @@
+#ifndef QNATIVEWEBDOWNLOAD_P_H
+#define QNATIVEWEBDOWNLOAD_P_H
+
+#include "qnativewebdownload.h"
+
+#include <QElapsedTimer>
+#include <QPointer>
+
+class QNativeWebViewPrivate;
+
+class QNativeWebDownloadPrivate
+{
+public:
+    static QNativeWebDownload *create(const QUrl &url, QNativeWebViewPrivate *owner);
+    static QNativeWebDownloadPrivate *get(QNativeWebDownload *download)
+    {
+        return download->d_ptr;
+    }
+
+    // Called by the backends as data arrives, emits downloadProgress() at most once
+    // per progressInterval unless forced
+    void updateProgress(qint64 received, qint64 total, bool force = false);
+    void setState(QNativeWebDownload::State state, const QString &error = QString());
+    // Resets the counters when the transfer is started again
+    void restart();
+
+    QNativeWebDownload *q_ptr = nullptr;
+    QPointer<QNativeWebViewPrivate> owner;
+    QUrl url;
+    QString destination;
+    QNativeWebDownload::State state = QNativeWebDownload::InProgress;
+    QString errorString;
+    qint64 receivedBytes = 0;
+    qint64 totalBytes = -1;
+    int progressInterval = 250;
+    QElapsedTimer clock;
+    // Transfer time once the download has ended
+    qint64 duration = -1;
+    QElapsedTimer lastProgress;
+
+    // Set by the backend that owns the native download
+    std::function<void()> cancelHandler;
+    std::function<void()> resumeHandler;
+    std::function<void()> releaseHandler;
+};
+
+#endif // QNATIVEWEBDOWNLOAD_P_H
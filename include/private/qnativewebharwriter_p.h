@@ -0,0 +1,33 @@
+#ifndef QNATIVEWEBHARWRITER_P_H
+#define QNATIVEWEBHARWRITER_P_H
+
+#include <QJsonObject>
+#include <QPointer>
+#include <QTemporaryFile>
+
+class QIODevice;
+
+// Writes an HTTP Archive (HAR 1.2) to a device as it is captured. Entries are
+// written as soon as they are added; page records belong after them and are
+// spooled to a temporary file until finish() copies them to the device.
+class QNativeWebHarWriter
+{
+public:
+    explicit QNativeWebHarWriter(QIODevice *device) : m_device(device) { }
+
+    void begin();
+    void addEntry(const QJsonObject &entry);
+    void addPage(const QJsonObject &page);
+    // Closes the JSON document, the device is left open
+    void finish();
+
+private:
+    void write(const QByteArray &data);
+
+    QPointer<QIODevice> m_device;
+    QTemporaryFile m_pages;
+    bool m_firstEntry = true;
+    bool m_firstPage = true;
+};
+
+#endif // QNATIVEWEBHARWRITER_P_H
@@ -0,0 +1,119 @@
+#ifndef QNATIVEWEBPROFILE_P_H
+#define QNATIVEWEBPROFILE_P_H
+
+#include "qnativewebprofile.h"
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIcon>
+#include <QJsonObject>
+#include <QList>
+#include <memory>
+
+struct QNativeWebUserContent
+{
+    int id = 0;
+    bool styleSheet = false;
+    QString source;
+    QNativeWebProfile::InjectionTime injectionTime = QNativeWebProfile::DocumentStart;
+    bool allFrames = false;
+    // Backend object built from the source on first use and shared by all pages
+    // of the profile
+    std::shared_ptr<void> native;
+};
+
+struct QNativeWebCachedIcon
+{
+    QIcon icon;
+    // Hash of the native image the icon was decoded from
+    uint imageHash = 0;
+};
+
+// Profile-wide part of a backend, created with the profile
+class QNativeWebProfileBackend
+{
+public:
+    explicit QNativeWebProfileBackend(QNativeWebProfile *profile) : m_profile(profile) { }
+    virtual ~QNativeWebProfileBackend() = default;
+
+    // Sizes are reported for the types the backend can measure; lastUsed is filled
+    // in by the profile
+    virtual void
+    websiteDataUsage(QNativeWebProfile::WebsiteDataTypes types,
+                     const std::function<void(const QList<QNativeWebProfile::WebsiteData> &)>
+                             &callback)
+    {
+        Q_UNUSED(types);
+        callback({});
+    }
+    virtual void removeWebsiteData(QNativeWebProfile::WebsiteDataTypes types,
+                                   const QStringList &origins,
+                                   const std::function<void()> &callback)
+    {
+        Q_UNUSED(types);
+        Q_UNUSED(origins);
+        callback();
+    }
+    virtual void clearWebsiteData(QNativeWebProfile::WebsiteDataTypes types,
+                                  const QDateTime &since, const std::function<void()> &callback)
+    {
+        Q_UNUSED(types);
+        Q_UNUSED(since);
+        callback();
+    }
+    virtual void setProxy(const QNetworkProxy &proxy) { Q_UNUSED(proxy); }
+    // Whether other profiles store their website data in the same place
+    virtual bool sharesWebsiteData() const { return false; }
+
+protected:
+    QNativeWebProfile *m_profile;
+};
+
+class QNativeWebProfilePrivate
+{
+public:
+    static QNativeWebProfilePrivate *get(QNativeWebProfile *profile) { return profile->d_ptr; }
+
+    // Script that adds css to the document, for backends without native stylesheets
+    static QString styleSheetScript(const QString &css);
+
+    // Replaces the cookie mirror with the backend's full cookie list and emits
+    // cookieChanged() for the differences
+    void setCookies(const QList<QNetworkCookie> &cookies);
+    // The mirror in the format of QNativeWebView::allCookies()
+    QJsonObject cookiesToJson() const;
+
+    // Called by the pages as they navigate
+    void recordOriginUse(const QUrl &url);
+    void maybeEvict();
+
+    // Replaces the profile-wide part with the one of the named page backend.
+    // Profiles start with that of the default backend; pages of another backend
+    // replace it before they use it.
+    void createBackend(const QString &name);
+
+    QNativeWebProfile *q_ptr = nullptr;
+    QNativeWebProfileBackend *backend = nullptr;
+    QString backendName;
+    QNativeWebProfile::StorageMode storageMode = QNativeWebProfile::PersistentStorage;
+    QString storageName;
+
+    QList<QNativeWebUserContent> userContent;
+    int nextId = 1;
+    // Decoded favicons by page host, least recently used are dropped first
+    QCache<QString, QNativeWebCachedIcon> icons{ 256 };
+    // Cookies by domain and name
+    QHash<QString, QHash<QString, QNetworkCookie>> cookies;
+    // Backend object watching the cookie store for the profile
+    std::shared_ptr<void> cookieObserver;
+    // Last navigation time by host
+    QHash<QString, QDateTime> originUse;
+    qint64 websiteDataQuota = 0;
+    int evictionInterval = 60000;
+    QElapsedTimer lastEviction;
+    bool evicting = false;
+    QNetworkProxy proxy{ QNetworkProxy::DefaultProxy };
+};
+
+#endif // QNATIVEWEBPROFILE_P_H
@@ -0,0 +1,43 @@
+#ifndef QNATIVEWEBSTREAMREADER_P_H
+#define QNATIVEWEBSTREAMREADER_P_H
+
+#include "qnativewebstreamreader.h"
+
+#include <QList>
+#include <functional>
+
+class QNativeWebStreamReaderPrivate
+{
+public:
+    static QNativeWebStreamReader *create(QObject *owner);
+    static QNativeWebStreamReaderPrivate *get(QNativeWebStreamReader *reader)
+    {
+        return reader->d_ptr;
+    }
+
+    // Called by the page as chunks arrive and once the stream has ended
+    void append(const QByteArray &chunk);
+    void finish(const QString &error = QString());
+    // Lets the page send up to window() chunks beyond those read
+    void grantCredit();
+
+    QNativeWebStreamReader *q_ptr = nullptr;
+    // Chunks not read yet, the first from offset on
+    QList<QByteArray> chunks;
+    int offset = 0;
+    qint64 buffered = 0;
+    quint64 consumed = 0;
+    quint64 granted = 0;
+    int window = 4;
+    bool finished = false;
+    // A credit update is queued
+    bool crediting = false;
+
+    // Set by the page: sends the number of chunks the page may have sent in
+    // total, and drops the stream when the reader goes away
+    std::function<void(quint64 credit)> creditHandler;
+    std::function<void()> cancelHandler;
+    std::function<void()> releaseHandler;
+};
+
+#endif // QNATIVEWEBSTREAMREADER_P_H
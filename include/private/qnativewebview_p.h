@@ -1,10 +1,27 @@
 #ifndef QNATIVEWEBVIEW_P_H
 #define QNATIVEWEBVIEW_P_H
 
+#include "qnativewebsettings.h"
+#include "qnativewebdownload.h"
+#include "qnativewebprofile_p.h"
+#include "qnativewebpage.h"
+#include "qnativewebbridge.h"
+#include "qnativewebnavigationpolicy.h"
+#include "qnativewebconsolebuffer_p.h"
+#include "qnativewebharwriter_p.h"
+#include "qnativewebstreamreader_p.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QMap>
 #include <QObject>
+#include <QPointer>
 #include <QUrl>
 #include <QVariant>
 #include <functional>
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 class QWindow;
@@ -17,6 +34,19 @@ class QNativeWebViewPrivate : public QObject
     Q_OBJECT
 
 public:
+    // Backends by name: "null" and the platform's, "webview2", "webkitgtk" or
+    // "wkwebview". Pages get the default backend, which is the one named by the
+    // QNATIVEWEBVIEW_BACKEND environment variable unless set by the application,
+    // else the platform's.
+    typedef std::function<QNativeWebViewPrivate *(QNativeWebProfile *, QObject *)>
+            BackendFactory;
+    static void registerBackend(const QString &name, const BackendFactory &factory);
+    static QStringList backends();
+    static QString defaultBackend();
+    static bool setDefaultBackend(const QString &name);
+    static QNativeWebViewPrivate *create(QNativeWebProfile *profile, QObject *parent);
+    QString backendName() const { return m_backendName; }
+
     virtual void load(const QUrl &url) = 0;
     virtual void setHtml(const QString &html, const QUrl &baseUrl = QUrl()) = 0;
     virtual void stop() = 0;
@@ -35,6 +65,119 @@ public:
     virtual void evaluateJavaScript(const QString &scriptSource,
                                     const std::function<void(const QVariant &)> &callback = {}) = 0;
 
+    // Raw bytes of the main resource; backends without access to it serialize the DOM
+    virtual void pageSource(const std::function<void(const QByteArray &)> &callback)
+    {
+        evaluateJavaScript(QStringLiteral("document.documentElement.outerHTML"),
+                           [callback](const QVariant &result) {
+                               if (callback) {
+                                   callback(result.toString().toUtf8());
+                               }
+                           });
+    }
+    // Size of the page while it has no native window, which otherwise sizes it
+    virtual void setViewportSize(const QSize &size) { Q_UNUSED(size); }
+    // Image of the whole document, null where the backend can not take one
+    virtual void snapshot(const std::function<void(const QImage &)> &callback)
+    {
+        callback(QImage());
+    }
+    virtual void plainText(const std::function<void(const QString &)> &callback)
+    {
+        evaluateJavaScript(QStringLiteral("document.body ? document.body.innerText : ''"),
+                           [callback](const QVariant &result) {
+                               if (callback) {
+                                   callback(result.toString());
+                               }
+                           });
+    }
+
+    QNativeWebSettings *settings() const { return m_settings; }
+    QNativeWebProfile *profile() const { return m_profile; }
+    QIcon icon() const { return m_icon; }
+
+    void setDownloadPolicy(const QNativeWebDownloadPolicy &policy) { m_downloadPolicy = policy; }
+    // Destination chosen by the download policy, by default a unique file in the
+    // user's download directory. Default names are reserved for the download until
+    // released, so concurrent downloads of the same name get different files.
+    QString downloadDestination(const QUrl &url, const QString &suggestedFileName) const;
+    static void releaseDownloadDestination(const QString &path);
+    QList<QNativeWebDownload *> downloads() const;
+    QNativeWebDownloadStatistics downloadStatistics() const;
+
+    void setRenderProcessRecovery(int maxRestarts, int intervalMsecs)
+    {
+        m_recoveryMaxRestarts = qMax(0, maxRestarts);
+        m_recoveryInterval = qMax(0, intervalMsecs);
+    }
+
+    // Page scripts post strings to a handler with
+    // window.webkit.messageHandlers.<name>.postMessage(); the optional script is
+    // injected into the top frame at document start, before the page's own scripts
+    typedef std::function<void(const QString &)> MessageHandler;
+    void addMessageHandler(const QString &name, const MessageHandler &handler,
+                           const QString &script = QString());
+    void removeMessageHandler(const QString &name);
+
+    QNativeWebBridge *webBridge() const { return m_bridge; }
+    void setWebBridge(QNativeWebBridge *bridge);
+
+    QNativeWebNavigationPolicy *navigationPolicy() const { return m_navigationPolicy; }
+    void setNavigationPolicy(QNativeWebNavigationPolicy *policy) { m_navigationPolicy = policy; }
+    // Asked by the backends before a navigation or a new window starts
+    bool isNavigationAllowed(const QUrl &url)
+    {
+        return !m_navigationPolicy
+                || m_navigationPolicy->decide(url) == QNativeWebNavigationPolicy::Allow;
+    }
+
+    // Hands data to the page's qnativewebdata listeners as ArrayBuffers, in chunks
+    // of chunkSize bytes when it is positive
+    void postData(const QString &channel, const QByteArray &data, int chunkSize);
+    // Installs the page side of postData(), which postData() does on first use
+    void enableDataChannel();
+    // Calls the page function producer with a writer whose chunks arrive in the
+    // returned reader, owned by this page
+    QNativeWebStreamReader *streamJavaScript(const QString &producer);
+
+    void setMetricsCollectionEnabled(bool enabled);
+    bool isMetricsCollectionEnabled() const { return m_metricsEnabled; }
+    QNativeWebPageMetrics metrics() const { return m_metrics; }
+
+    void setConsoleCapacity(int capacity);
+    int consoleCapacity() const { return m_console ? m_console->capacity() : 0; }
+    QList<QNativeWebConsoleMessage> drainConsoleMessages();
+    quint64 droppedConsoleMessages() const { return m_console ? m_console->dropped() : 0; }
+    void dumpConsoleMessages(int fd) const
+    {
+        if (m_console) {
+            m_console->dump(fd);
+        }
+    }
+
+    void setQueryCacheEnabled(bool enabled);
+    bool isQueryCacheEnabled() const { return m_queryCacheEnabled; }
+    void evaluateCachedJavaScript(const QString &query,
+                                  const std::function<void(const QVariant &)> &callback);
+    QNativeWebQueryCacheStatistics queryCacheStatistics() const;
+    void resetQueryCacheStatistics() { m_queryCacheStatistics = QNativeWebQueryCacheStatistics(); }
+
+    void setVirtualTimeEnabled(bool enabled);
+    bool isVirtualTimeEnabled() const { return m_virtualTimeEnabled; }
+    void advanceVirtualTime(int msecs, const std::function<void(double)> &callback);
+
+    // False if the backend can not capture resource loads or device is not writable
+    bool startHarCapture(QIODevice *device);
+    void stopHarCapture();
+    bool isHarCapturing() const { return m_har != nullptr; }
+
+public Q_SLOTS:
+    // Pushes the current QNativeWebSettings values to the native view
+    virtual void applySettings() { }
+    // Replaces the native user scripts and stylesheets with the profile's and
+    // the message handler scripts
+    virtual void applyUserContent() { }
+
 Q_SIGNALS:
     void loadStarted();
     void loadProgress(int progress);
@@ -45,9 +188,209 @@ Q_SIGNALS:
     void iconChanged(const QIcon &icon);
     void urlChanged(const QUrl &url);
     void errorOccurred(const QString &error);
+    void downloadRequested(QNativeWebDownload *download);
+    void renderProcessTerminated(QNativeWebPage::RenderProcessTerminationReason reason);
+    void renderProcessRecovered(qint64 downtimeMsecs);
+    void metricsCollected(const QNativeWebPageMetrics &metrics);
 
 protected:
-    explicit QNativeWebViewPrivate(QObject *parent = nullptr) : QObject(parent) { }
+    explicit QNativeWebViewPrivate(QNativeWebProfile *profile, QObject *parent = nullptr)
+        : QObject(parent), m_settings(new QNativeWebSettings(this)), m_profile(profile)
+    {
+        connect(m_settings, &QNativeWebSettings::settingsChanged, this,
+                &QNativeWebViewPrivate::applySettings);
+        connect(m_profile, &QNativeWebProfile::userContentChanged, this,
+                &QNativeWebViewPrivate::applyUserContent);
+        // Usage data for the profile's website data quota
+        connect(this, &QNativeWebViewPrivate::urlChanged, m_profile, [this](const QUrl &url) {
+            QNativeWebProfilePrivate::get(m_profile)->recordOriginUse(url);
+        });
+        connect(this, &QNativeWebViewPrivate::loadFinished, m_profile,
+                [this] { QNativeWebProfilePrivate::get(m_profile)->maybeEvict(); });
+        connect(this, &QNativeWebViewPrivate::loadStarted, this,
+                &QNativeWebViewPrivate::dropPostedData);
+        connect(this, &QNativeWebViewPrivate::loadFinished, this,
+                &QNativeWebViewPrivate::startQueuedPostedData);
+        connect(this, &QNativeWebViewPrivate::loadStarted, this,
+                [this] { m_metricsRetiring = !m_metricsDocument.isEmpty(); });
+        connect(this, &QNativeWebViewPrivate::loadFinished, this, [this] {
+            if (m_metricsRetiring) {
+                finishMetrics();
+            }
+        });
+        connect(this, &QNativeWebViewPrivate::loadStarted, this,
+                &QNativeWebViewPrivate::resetQueryCache);
+        connect(this, &QNativeWebViewPrivate::loadStarted, this,
+                &QNativeWebViewPrivate::failVirtualTimeAdvances);
+        connect(this, &QNativeWebViewPrivate::loadStarted, this,
+                &QNativeWebViewPrivate::startHarPage);
+        connect(this, &QNativeWebViewPrivate::loadStarted, this,
+                &QNativeWebViewPrivate::failStreams);
+        connect(this, &QNativeWebViewPrivate::loadFinished, this, [this] {
+            if (m_har && !m_harPage.isEmpty()) {
+                QJsonObject timings = m_harPage.value(QLatin1String("pageTimings")).toObject();
+                timings.insert(QStringLiteral("onLoad"), double(m_harPageTimer.elapsed()));
+                m_harPage.insert(QStringLiteral("pageTimings"), timings);
+            }
+        });
+        connect(this, &QNativeWebViewPrivate::titleChanged, this, [this](const QString &title) {
+            if (m_har && !m_harPage.isEmpty()) {
+                m_harPage.insert(QStringLiteral("title"), title);
+            }
+        });
+        connect(this, &QNativeWebViewPrivate::loadStarted, this, [this] {
+            if (m_recoveryLoadPending) {
+                m_recoveryLoadPending = false;
+            } else {
+                m_downtime.invalidate();
+            }
+        });
+        connect(this, &QNativeWebViewPrivate::loadFinished, this, [this](bool ok) {
+            if (ok && m_downtime.isValid()) {
+                emit renderProcessRecovered(m_downtime.elapsed());
+            }
+            m_downtime.invalidate();
+        });
+    }
+
+    // Tracks a download created by the backend and announces it
+    void addDownload(QNativeWebDownload *download);
+    // Reports a dead render process and restarts it within the recovery budget
+    void handleRenderProcessTerminated(QNativeWebPage::RenderProcessTerminationReason reason);
+    // Brings the page back after its render process died; WebKit and WebView2
+    // start a new process and keep the session history on reload
+    virtual void recoverRenderProcess() { reload(); }
+    // Installs the native end of window.webkit.messageHandlers.<name>
+    virtual void registerMessageHandler(const QString &name) { Q_UNUSED(name); }
+    virtual void unregisterMessageHandler(const QString &name) { Q_UNUSED(name); }
+    void dispatchMessage(const QString &name, const QString &message);
+    // Starts or stops reporting the page's resource loads with addHarEntry(),
+    // false if the backend can not
+    virtual bool captureResources(bool enabled)
+    {
+        Q_UNUSED(enabled);
+        return false;
+    }
+    // Writes a completed entry, referring to the current page
+    void addHarEntry(QJsonObject entry);
+
+    struct PostedData
+    {
+        QString channel;
+        QByteArray data;
+        int chunkSize = 0;
+        int nextChunk = 0;
+        // Random part of the URL, so only the page that was told can fetch it
+        QByteArray key;
+    };
+    // URL the page fetches the chunks of a transfer from, with "/<index>" appended;
+    // empty if the backend can not serve them, they are then pushed base64 encoded
+    // through evaluateJavaScript() one at a time as the page takes them
+    virtual QString postedDataUrl(int id, const PostedData &posted) const
+    {
+        Q_UNUSED(id);
+        Q_UNUSED(posted);
+        return QString();
+    }
+    void startPostedData(const PostedData &transfer);
+    void sendPostedDataChunk(int id);
+    // A new document can not fetch what was posted to the previous one
+    void dropPostedData();
+    // Hands the transfers posted during the load to the loaded document
+    void startQueuedPostedData();
+    // Updates m_metrics from a report of the page's collector
+    void updateMetrics(const QString &report);
+    // Announces the metrics of the navigation that ended and starts over
+    void finishMetrics();
+    // Adds a batch of messages sent by the page's console hook to m_console
+    void appendConsoleMessages(const QString &batch);
+    // Moves the cache to a newer DOM epoch reported by the page, dropping the
+    // results of older ones; false if the epoch is older than the known one
+    bool advanceDomEpoch(const QString &epoch);
+    // Forgets the cached results and the epoch of the previous document
+    void resetQueryCache();
+    // Completes an advance reported by the page's virtual clock
+    void finishVirtualTimeAdvance(const QString &report);
+    // Completes the pending advances with -1, e.g. when their document is gone
+    void failVirtualTimeAdvances();
+    // Hands the record of the previous page to the HAR writer and starts a new one
+    void startHarPage();
+    // Delivers a chunk, the end or the failure of a stream to its reader
+    void receiveStreamMessage(const QString &message);
+    // Ends the streams of a document that is gone with an error
+    void failStreams();
+    void setIcon(const QIcon &icon)
+    {
+        if (icon.cacheKey() != m_icon.cacheKey()) {
+            m_icon = icon;
+            emit iconChanged(m_icon);
+        }
+    }
+
+    QNativeWebSettings *m_settings;
+    QNativeWebProfile *m_profile;
+    QString m_backendName;
+    QIcon m_icon;
+    QNativeWebDownloadPolicy m_downloadPolicy;
+    QList<QPointer<QNativeWebDownload>> m_downloads;
+    int m_recoveryMaxRestarts = 0;
+    int m_recoveryInterval = 60000;
+    // Times of the recent restarts on m_recoveryClock
+    QList<qint64> m_recoveryRestarts;
+    QElapsedTimer m_recoveryClock;
+    // Running from a termination until the page has loaded again; invalid again
+    // when the reload fails or another navigation replaces it
+    QElapsedTimer m_downtime;
+    // Set until the load of recoverRenderProcess() has started
+    bool m_recoveryLoadPending = false;
+
+    struct MessageHandlerEntry
+    {
+        MessageHandler handler;
+        QString script;
+        // Backend object for the script, created by applyUserContent()
+        std::shared_ptr<void> native;
+    };
+    QMap<QString, MessageHandlerEntry> m_messageHandlers;
+    QPointer<QNativeWebBridge> m_bridge;
+    QPointer<QNativeWebNavigationPolicy> m_navigationPolicy;
+    // Transfers still to be fetched by the current document
+    QHash<int, PostedData> m_postedData;
+    int m_nextPostedData = 0;
+    // Transfers posted before the first load or during one, for the next document
+    QList<PostedData> m_queuedPostedData;
+    // From loadStarted() until loadFinished(), and before the first load
+    bool m_documentLoading = true;
+    // Readers of the streams the page is writing
+    QHash<int, QPointer<QNativeWebStreamReader>> m_streams;
+    int m_lastStream = 0;
+    bool m_metricsEnabled = false;
+    // Random id of the document that reported m_metrics, empty before its
+    // first report, and of the previous document, whose late reports are dropped
+    QString m_metricsDocument;
+    QString m_retiredMetricsDocument;
+    // Set from the start of the next load until m_metricsDocument is finished;
+    // it still sends its last report when it is hidden
+    bool m_metricsRetiring = false;
+    QNativeWebPageMetrics m_metrics;
+    std::unique_ptr<QNativeWebConsoleBuffer> m_console;
+    bool m_queryCacheEnabled = false;
+    // Query results, valid for the known DOM epoch of the current document
+    QHash<QString, QVariant> m_queryCache;
+    QString m_domDocument;
+    qint64 m_domEpoch = -1;
+    // Bumped by every navigation, results of an older document are not cached
+    int m_queryNavigation = 0;
+    QHash<QString, QList<std::function<void(const QVariant &)>>> m_pendingQueries;
+    QNativeWebQueryCacheStatistics m_queryCacheStatistics;
+    bool m_virtualTimeEnabled = false;
+    QHash<int, std::function<void(double)>> m_virtualTimeAdvances;
+    int m_lastVirtualTimeAdvance = 0;
+    std::unique_ptr<QNativeWebHarWriter> m_har;
+    // Record of the page being captured, empty before the first load
+    QJsonObject m_harPage;
+    QElapsedTimer m_harPageTimer;
+    int m_harPages = 0;
 };
 
 #endif // QNATIVEWEBVIEW_P_H
@@ -0,0 +1,50 @@
+#ifndef QNULLWEBVIEW_H
+#define QNULLWEBVIEW_H
+
+#include "qnativewebview_p.h"
+
+// Backend without an engine, see QNativeWebNullBackend
+class QNullWebViewPrivate : public QNativeWebViewPrivate
+{
+    Q_OBJECT
+public:
+    explicit QNullWebViewPrivate(QNativeWebProfile *profile, QObject *parent = nullptr);
+
+    void load(const QUrl &url) override;
+    void setHtml(const QString &html, const QUrl &baseUrl = QUrl()) override;
+    void stop() override;
+    void back() override;
+    void forward() override;
+    void reload() override;
+
+    QWindow *nativeWindow() override { return nullptr; }
+    QString errorString() const override { return m_error; }
+    QString userAgent() const override { return m_userAgent; }
+    bool setUserAgent(const QString &userAgent) override;
+    void allCookies(const std::function<void(const QJsonObject &)> &callback) override;
+    bool setCookie(const QString &domain, const QString &name, const QString &value) override;
+    void deleteCookie(const QString &domain, const QString &name) override;
+    void deleteAllCookies() override;
+    void evaluateJavaScript(const QString &scriptSource,
+                            const std::function<void(const QVariant &)> &callback = {}) override;
+    void pageSource(const std::function<void(const QByteArray &)> &callback) override;
+    void setViewportSize(const QSize &size) override;
+    // A transparent image of the viewport size
+    void snapshot(const std::function<void(const QImage &)> &callback) override;
+
+private:
+    void record(const QString &method, const QVariantList &arguments = QVariantList());
+    // Reports the load of the current history entry on the next event loop iteration
+    void navigate();
+
+    QList<QUrl> m_history;
+    int m_historyIndex = -1;
+    QString m_html;
+    QString m_error;
+    QString m_userAgent;
+    QSize m_viewportSize{ 800, 600 };
+    // Bumped by every navigation and stop(), so superseded loads are not reported
+    int m_navigation = 0;
+};
+
+#endif // QNULLWEBVIEW_H
@@ -4,6 +4,7 @@
 #include "qnativewebview_p.h"
 
 #include <QMap>
+#include <QStringList>
 #include <QUrl>
 
 // clang-format off
@@ -33,7 +34,7 @@ class QWebView2WebViewPrivate : public QNativeWebViewPrivate
 {
     Q_OBJECT
 public:
-    explicit QWebView2WebViewPrivate(QObject *parent = nullptr);
+    explicit QWebView2WebViewPrivate(QNativeWebProfile *profile, QObject *parent = nullptr);
     ~QWebView2WebViewPrivate();
 
     void load(const QUrl &url) override;
@@ -54,6 +55,10 @@ public:
     void evaluateJavaScript(const QString &scriptSource,
                             const std::function<void(const QVariant &)> &callback = {}) override;
 
+public Q_SLOTS:
+    void applySettings() override;
+    void applyUserContent() override;
+
 private Q_SLOTS:
     HRESULT onNavigationStarting(ICoreWebView2 *webview,
                                  ICoreWebView2NavigationStartingEventArgs *args);
@@ -67,10 +72,16 @@ private Q_SLOTS:
     HRESULT onDocumentTitleChanged(ICoreWebView2 *webview, IUnknown *args);
     HRESULT onNewWindowRequested(ICoreWebView2 *webview,
                                  ICoreWebView2NewWindowRequestedEventArgs *args);
+    HRESULT onWebMessageReceived(ICoreWebView2 *webview,
+                                 ICoreWebView2WebMessageReceivedEventArgs *args);
+    HRESULT onProcessFailed(ICoreWebView2 *webview, ICoreWebView2ProcessFailedEventArgs *args);
     void updateWindowGeometry();
     void initialize();
 
 private:
+    // Updates the profile's cookie mirror from the cookie manager
+    void refreshCookies(const std::function<void()> &done = {});
+
     QUrl m_url;
     QString m_error;
     ComPtr<ICoreWebView2Controller> m_webviewController;
@@ -78,6 +89,9 @@ private:
     ComPtr<ICoreWebView2CookieManager> m_cookieManager;
     QWindow *m_window;
     QWebViewInitData m_initData;
+    // Ids of the scripts added by applyUserContent()
+    QStringList m_userScriptIds;
+    int m_userContentGeneration = 0;
 };
 
 #endif // QWEBVIEW2WEBVIEW_H
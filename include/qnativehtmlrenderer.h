@@ -0,0 +1,67 @@
+#ifndef QNATIVEHTMLRENDERER_H
+#define QNATIVEHTMLRENDERER_H
+
+#include "QNativeWebView_global.h"
+
+#include <QImage>
+#include <QObject>
+
+class QNativeHtmlRendererPrivate;
+
+struct QNativeHtmlRendererStatistics
+{
+    quint64 rendered = 0;
+    quint64 cacheHits = 0;
+    quint64 cacheMisses = 0;
+    // Snippets rendered per second of rendering
+    double throughput = 0;
+    // Hits over all lookups, 0 before the first
+    double hitRate = 0;
+};
+
+// Renders HTML snippets to images with a single hidden page, for painting rich
+// text in item delegates without a view per row. Snippets are laid out at the
+// requested width, one at a time, and cropped to the height of their content.
+// The images are cached by a hash of the snippet and the width, the least
+// recently used are dropped first.
+//
+// A delegate paints image() when it is not null, and repaints the view on
+// imageReady():
+//
+//     const QImage image = renderer->image(html, option.rect.width());
+//     if (!image.isNull())
+//         painter->drawImage(option.rect.topLeft(), image);
+class QNATIVEWEBVIEW_EXPORT QNativeHtmlRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QNativeHtmlRenderer(QObject *parent = nullptr);
+    ~QNativeHtmlRenderer();
+
+    // The cached image, else a null image and the snippet is queued for rendering
+    QImage image(const QString &html, int width);
+    bool contains(const QString &html, int width) const;
+    // Queues the snippet unless it is cached or queued already
+    void render(const QString &html, int width);
+
+    // Applied to every snippet; changing it clears the cache
+    QString styleSheet() const;
+    void setStyleSheet(const QString &css);
+
+    qint64 cacheLimit() const;
+    void setCacheLimit(qint64 bytes);
+    void clearCache();
+
+    QNativeHtmlRendererStatistics statistics() const;
+    void resetStatistics();
+
+Q_SIGNALS:
+    void imageReady(const QString &html, int width, const QImage &image);
+
+private:
+    QNativeHtmlRendererPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeHtmlRenderer)
+};
+
+#endif // QNATIVEHTMLRENDERER_H
@@ -0,0 +1,71 @@
+#ifndef QNATIVEWEBASSETPACK_H
+#define QNATIVEWEBASSETPACK_H
+
+#include "QNativeWebView_global.h"
+
+#include <QObject>
+#include <memory>
+
+class QNativeWebAssetPackPrivate;
+
+// A read-only archive of web assets in a single memory-mapped file.
+//
+// Layout, all integers little-endian:
+//   header   "QNWPACK\0", quint32 version, quint32 count,
+//            quint64 string table offset, quint64 string table size
+//   index    count entries of 56 bytes sorted by path:
+//            quint32 path offset, quint32 path size, quint32 mime offset, quint32 mime size,
+//            quint64 data offset, quint64 stored size, quint64 original size,
+//            quint32 flags, quint32 reserved, quint64 etag
+//   strings  paths and MIME types, UTF-8, not terminated
+//   data     entries, 8-byte aligned; zlib streams when flags has Compressed
+//
+// Installed packs are served to the views as app://<host>/<path>.
+class QNATIVEWEBVIEW_EXPORT QNativeWebAssetPack : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum EntryFlag { Compressed = 0x1 };
+
+    struct Asset
+    {
+        // Points into the mapped file, which is kept alive by storage
+        const uchar *data = nullptr;
+        qint64 size = 0;
+        qint64 originalSize = 0;
+        bool compressed = false;
+        QByteArray mimeType;
+        QByteArray etag;
+        std::shared_ptr<const void> storage;
+
+        bool isValid() const { return data != nullptr; }
+    };
+
+    explicit QNativeWebAssetPack(QObject *parent = nullptr);
+    ~QNativeWebAssetPack();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+    int count() const;
+
+    // Binary search of the sorted index, path is relative and without leading '/'
+    Asset find(const QString &path) const;
+
+    // Packs every file below sourceDirectory, compressing text assets that shrink
+    static bool build(const QString &sourceDirectory, const QString &packFileName,
+                      QString *errorString = nullptr);
+
+    static QString scheme();
+    static void install(const QString &host, QNativeWebAssetPack *pack);
+    static void uninstall(const QString &host);
+    static QNativeWebAssetPack *installed(const QString &host);
+
+private:
+    QNativeWebAssetPackPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebAssetPack)
+};
+
+#endif // QNATIVEWEBASSETPACK_H
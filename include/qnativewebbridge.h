@@ -0,0 +1,47 @@
+#ifndef QNATIVEWEBBRIDGE_H
+#define QNATIVEWEBBRIDGE_H
+
+#include "QNativeWebView_global.h"
+
+#include <QObject>
+#include <QHash>
+
+class QNativeWebBridgePrivate;
+class QNativeWebViewPrivate;
+
+// Exposes QObjects to the pages it is set on. Page scripts find them in
+//
+//   qnativewebbridge.ready.then(function(objects) { ... })
+//
+// where every registered object has a stub generated from its QMetaObject:
+// public slots and Q_INVOKABLE methods return promises of their result,
+// properties are cached values kept current through their notify signals and
+// written back on assignment, and signals have connect() and disconnect().
+//
+// Traffic in both directions is batched per event loop turn and encoded as
+// CBOR. Changes to a property within a turn reach the page once, with the
+// final value. Large batches to the page go through QNativeWebPage::postData()
+// on the "qnativewebbridge" channel.
+class QNATIVEWEBVIEW_EXPORT QNativeWebBridge : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QNativeWebBridge(QObject *parent = nullptr);
+    ~QNativeWebBridge();
+
+    // Objects registered after a page loaded are seen by it after a reload
+    void registerObject(const QString &name, QObject *object);
+    void deregisterObject(QObject *object);
+    QHash<QString, QObject *> registeredObjects() const;
+
+private:
+    friend class QNativeWebViewPrivate;
+    void attach(QNativeWebViewPrivate *page);
+    void detach(QNativeWebViewPrivate *page);
+
+    QNativeWebBridgePrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebBridge)
+};
+
+#endif // QNATIVEWEBBRIDGE_H
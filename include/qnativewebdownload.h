@@ -0,0 +1,69 @@
+#ifndef QNATIVEWEBDOWNLOAD_H
+#define QNATIVEWEBDOWNLOAD_H
+
+#include "QNativeWebView_global.h"
+
+#include <QObject>
+#include <QUrl>
+#include <functional>
+
+class QNativeWebDownloadPrivate;
+
+// Returns the file path a download is written to, or an empty string to refuse it
+using QNativeWebDownloadPolicy =
+        std::function<QString(const QUrl &url, const QString &suggestedFileName)>;
+
+struct QNativeWebDownloadStatistics
+{
+    int active = 0;
+    int completed = 0;
+    int cancelled = 0;
+    int failed = 0;
+    qint64 bytesReceived = 0;
+    // Combined rate of the downloads in progress
+    double bytesPerSecond = 0;
+};
+
+// A download started by a page. The data is written to the destination file by the
+// backend as it arrives; downloadProgress() is rate-limited to progressInterval().
+class QNATIVEWEBVIEW_EXPORT QNativeWebDownload : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State { InProgress, Completed, Cancelled, Failed };
+    Q_ENUM(State)
+
+    ~QNativeWebDownload();
+
+    QUrl url() const;
+    QString destination() const;
+    State state() const;
+    QString errorString() const;
+    qint64 receivedBytes() const;
+    // -1 when the server did not announce a length
+    qint64 totalBytes() const;
+    double bytesPerSecond() const;
+    int progressInterval() const;
+    void setProgressInterval(int msecs);
+
+public Q_SLOTS:
+    void cancel();
+    // Starts the transfer again; the backends cannot continue from a partial file,
+    // so the destination is rewritten from the beginning
+    void resume();
+
+Q_SIGNALS:
+    void downloadProgress(qint64 received, qint64 total);
+    void stateChanged(QNativeWebDownload::State state);
+    void finished();
+
+private:
+    explicit QNativeWebDownload(QNativeWebDownloadPrivate *d, QObject *parent = nullptr);
+
+    friend class QNativeWebDownloadPrivate;
+    QNativeWebDownloadPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebDownload)
+};
+
+#endif // QNATIVEWEBDOWNLOAD_H
@@ -0,0 +1,72 @@
+#ifndef QNATIVEWEBNAVIGATIONPOLICY_H
+#define QNATIVEWEBNAVIGATIONPOLICY_H
+
+#include "QNativeWebView_global.h"
+
+#include <QObject>
+#include <QUrl>
+
+class QNativeWebNavigationPolicyPrivate;
+
+struct QNativeWebNavigationStatistics
+{
+    quint64 allowed = 0;
+    quint64 denied = 0;
+    // Time spent in decide(), in nanoseconds
+    qint64 totalDecisionTime = 0;
+    qint64 maxDecisionTime = 0;
+    // Time spent compiling the rules after changes, in nanoseconds
+    qint64 totalCompileTime = 0;
+    qint64 maxCompileTime = 0;
+};
+
+// Allow and deny rules for the navigations of the pages it is set on, shared
+// by any number of pages.
+//
+// Domain rules match the domain and all of its subdomains, URL prefix rules
+// match URLs of the same host starting with the prefix. The most specific rule
+// decides: the longest matching prefix, else the deepest matching domain, else
+// the default decision. Rules are compiled into a trie of reversed host labels
+// when they change, once per loadRules() file, so a decision costs a lookup per
+// label of the host whatever the number of rules. URLs without a host, such as
+// about:blank and data: URLs, and the library's own schemes are always allowed.
+class QNATIVEWEBVIEW_EXPORT QNativeWebNavigationPolicy : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Decision { Allow, Deny };
+    Q_ENUM(Decision)
+
+    explicit QNativeWebNavigationPolicy(QObject *parent = nullptr);
+    ~QNativeWebNavigationPolicy();
+
+    Decision defaultDecision() const;
+    void setDefaultDecision(Decision decision);
+
+    // "example.com", ".example.com" and "*.example.com" are the same rule.
+    // Returns false for an invalid domain or URL; a later rule for the same
+    // domain or prefix replaces the earlier one. Each call compiles the rules,
+    // loadRules() compiles once for many.
+    bool addDomainRule(const QString &domain, Decision decision);
+    bool addUrlPrefixRule(const QString &prefix, Decision decision);
+    // One rule per line, "allow" or "deny" and a domain or a URL prefix with a
+    // scheme; blank lines and lines starting with # are skipped
+    bool loadRules(const QString &fileName, QString *errorString = nullptr);
+    void clear();
+    int ruleCount() const;
+
+    Decision decide(const QUrl &url);
+
+    QNativeWebNavigationStatistics statistics() const;
+    void resetStatistics();
+
+Q_SIGNALS:
+    void navigationDenied(const QUrl &url);
+
+private:
+    QNativeWebNavigationPolicyPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebNavigationPolicy)
+};
+
+#endif // QNATIVEWEBNAVIGATIONPOLICY_H
@@ -0,0 +1,74 @@
+#ifndef QNATIVEWEBNULLBACKEND_H
+#define QNATIVEWEBNULLBACKEND_H
+
+#include "QNativeWebView_global.h"
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QUrl>
+#include <QVariant>
+#include <QVector>
+
+// Scripted results and the call log of the "null" backend, which pages use when
+// it is selected with QNativeWebPage::setDefaultBackend("null") or
+// QNATIVEWEBVIEW_BACKEND=null. It starts no engine: loads finish and scripts
+// return on the next event loop iteration, with the results set here, so the
+// application's own handling of the page signals can be tested and measured.
+class QNATIVEWEBVIEW_EXPORT QNativeWebNullBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Call
+    {
+        // The QNativeWebPage, for telling pages apart only
+        const QObject *page = nullptr;
+        QString method;
+        QVariantList arguments;
+    };
+
+    // Shared by all pages of the null backend, owned by the application
+    static QNativeWebNullBackend *instance();
+
+    // Loads of url succeed unless set to fail here; the title is the URL
+    void setLoadResult(const QUrl &url, bool ok, const QString &title = QString());
+    // Result of scripts with exactly this source, others return the default result
+    void setScriptResult(const QString &script, const QVariant &result);
+    void setDefaultScriptResult(const QVariant &result);
+    void clearResults();
+
+    // Off by default. While recording, the last callCapacity() calls reaching a
+    // page are kept, older ones are dropped.
+    bool isRecording() const { return m_recording; }
+    void setRecording(bool recording) { m_recording = recording; }
+    int callCapacity() const { return m_callCapacity; }
+    void setCallCapacity(int capacity);
+    // Oldest first
+    QList<Call> calls() const;
+    void clearCalls();
+
+private:
+    friend class QNullWebViewPrivate;
+
+    explicit QNativeWebNullBackend(QObject *parent = nullptr);
+
+    struct LoadResult
+    {
+        bool ok = true;
+        QString title;
+    };
+
+    void record(const QObject *page, const QString &method, const QVariantList &arguments);
+
+    QHash<QUrl, LoadResult> m_loadResults;
+    QHash<QString, QVariant> m_scriptResults;
+    QVariant m_defaultScriptResult;
+    bool m_recording = false;
+    int m_callCapacity = 10000;
+    // Ring buffer, m_firstCall is the oldest once it is full
+    QVector<Call> m_calls;
+    int m_firstCall = 0;
+};
+
+#endif // QNATIVEWEBNULLBACKEND_H
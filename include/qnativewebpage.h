@@ -0,0 +1,211 @@
+#ifndef QNATIVEWEBPAGE_H
+#define QNATIVEWEBPAGE_H
+
+#include "QNativeWebView_global.h"
+#include "qnativewebdownload.h"
+
+#include <QObject>
+#include <QIcon>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+#include <QJsonObject>
+#include <functional>
+
+// Rendering metrics of one navigation, measured in the page with
+// PerformanceObserver and requestAnimationFrame. Times are in milliseconds
+// since the navigation started, negative while unknown; engines without an
+// entry type leave its fields at their defaults.
+struct QNativeWebPageMetrics
+{
+    QUrl url;
+    double firstContentfulPaint = -1;
+    double largestContentfulPaint = -1;
+    double cumulativeLayoutShift = 0;
+    int longTasks = 0;
+    double longTaskTime = 0;
+    // Frames by the time since the previous frame: up to 8, 16, 33, 50, 100,
+    // 250 ms and longer
+    QVector<int> frameTimeHistogram;
+};
+
+// A message a page logged to its console, or an uncaught error. The source
+// location is only known for warnings and errors.
+struct QNativeWebConsoleMessage
+{
+    enum Level { Debug, Info, Warning, Error };
+
+    Level level = Info;
+    // Milliseconds since the epoch
+    qint64 timestamp = 0;
+    QString message;
+    QString source;
+    int line = 0;
+    int column = 0;
+};
+
+struct QNativeWebQueryCacheStatistics
+{
+    quint64 hits = 0;
+    quint64 misses = 0;
+    // Times cached results were dropped because the DOM changed
+    quint64 invalidations = 0;
+    // Hits over all lookups, 0 before the first
+    double hitRate = 0;
+};
+
+class QIODevice;
+class QNativeWebStreamReader;
+class QNativeWebViewPrivate;
+class QNativeWebSettings;
+class QNativeWebProfile;
+class QNativeWebBridge;
+class QNativeWebNavigationPolicy;
+
+// A web page without a widget. The backend is never given an on-screen window,
+// which makes it suitable for loading pages only to extract data from them.
+// A QNativeWebView can later be constructed around the page to display it.
+class QNATIVEWEBVIEW_EXPORT QNativeWebPage : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum RenderProcessTerminationReason {
+        RenderProcessCrashed,
+        RenderProcessExceededMemoryLimit,
+        RenderProcessTerminatedByApi
+    };
+    Q_ENUM(RenderProcessTerminationReason)
+
+    explicit QNativeWebPage(QObject *parent = nullptr);
+    // A null profile is the default profile
+    explicit QNativeWebPage(QNativeWebProfile *profile, QObject *parent = nullptr);
+    ~QNativeWebPage();
+
+    // Backends pages can be created with: "null" (see QNativeWebNullBackend) and
+    // the platform's. The default applies to pages constructed afterwards and is
+    // initially the QNATIVEWEBVIEW_BACKEND environment variable or the platform's.
+    static QStringList availableBackends();
+    static QString defaultBackend();
+    static bool setDefaultBackend(const QString &name);
+    QString backend() const;
+
+    QString errorString() const;
+    QNativeWebSettings *settings() const;
+    QNativeWebProfile *profile() const;
+    QIcon icon() const;
+    QString userAgent() const;
+    bool setUserAgent(const QString &userAgent);
+    void allCookies(const std::function<void(const QJsonObject &)> &callback);
+    bool setCookie(const QString &domain, const QString &name, const QString &value);
+    void deleteCookie(const QString &domain, const QString &name);
+    void deleteAllCookies();
+    // The callback gets an invalid QVariant if the script fails
+    void evaluateJavaScript(const QString &scriptSource,
+                            const std::function<void(const QVariant &)> &callback = {});
+    void pageSource(const std::function<void(const QByteArray &)> &callback);
+    void plainText(const std::function<void(const QString &)> &callback);
+    void setDownloadPolicy(const QNativeWebDownloadPolicy &policy);
+    QList<QNativeWebDownload *> downloads() const;
+    QNativeWebDownloadStatistics downloadStatistics() const;
+    // Reloads the page when its render process dies, at most maxRestarts times per
+    // interval; 0 disables recovery
+    void setRenderProcessRecovery(int maxRestarts, int intervalMsecs = 60000);
+    // Exposes the bridge's objects to page scripts; a bridge can serve many pages
+    void setWebBridge(QNativeWebBridge *bridge);
+    QNativeWebBridge *webBridge() const;
+    // Navigations the policy denies do not start; a policy can serve many pages
+    void setNavigationPolicy(QNativeWebNavigationPolicy *policy);
+    QNativeWebNavigationPolicy *navigationPolicy() const;
+    // Hands the bytes, in chunks of chunkSize when positive, to the listeners of
+    // qnativewebdata.addListener(channel, function(arrayBuffer, info) { ... }).
+    // Data posted before the first load finished or during a load is queued for
+    // the document being loaded and handed to it when loadFinished() is emitted.
+    // Transfers a document has not taken when the next load starts are dropped
+    // with a warning.
+    void postData(const QString &channel, const QByteArray &data, int chunkSize = 0);
+    // For results too large for evaluateJavaScript(): producer is a JavaScript
+    // function(stream) that awaits stream.write() with strings, sent as UTF-8, or
+    // binary data. The reader ends when the producer returns or its promise
+    // settles, with an error if it throws or the document goes away. It is a
+    // child of the page until deleted; delete it, e.g. with deleteLater(), once read.
+    QNativeWebStreamReader *streamJavaScript(const QString &producer);
+    // Off by default; the collector starts in the current document and in every
+    // one loaded after it is enabled
+    void setMetricsCollectionEnabled(bool enabled);
+    bool isMetricsCollectionEnabled() const;
+    // Metrics of the current navigation so far; while the next one loads, of the
+    // previous one until the new document reports
+    QNativeWebPageMetrics metrics() const;
+    // Keeps the last capacity console messages and uncaught errors in a ring
+    // buffer; 0, the default, stops capturing and changing it clears the buffer
+    void setConsoleCapacity(int capacity);
+    int consoleCapacity() const;
+    // Messages captured since the previous call, oldest first
+    QList<QNativeWebConsoleMessage> drainConsoleMessages();
+    // Messages overwritten before they were drained
+    quint64 droppedConsoleMessages() const;
+    // Writes the buffer to a file descriptor without allocating or locking, for crash handlers
+    void dumpConsoleMessages(int fd) const;
+    // Off by default; once enabled, documents loaded afterwards count DOM changes
+    // and input events so evaluateCachedJavaScript() can reuse results
+    void setQueryCacheEnabled(bool enabled);
+    bool isQueryCacheEnabled() const;
+    // query must be a read-only JavaScript expression; its result is reused until
+    // the document changes, as seen one message from the page later
+    void evaluateCachedJavaScript(const QString &query,
+                                  const std::function<void(const QVariant &)> &callback);
+    QNativeWebQueryCacheStatistics queryCacheStatistics() const;
+    void resetQueryCacheStatistics();
+
+    // Off by default; once enabled, Date, performance.now(), timers and animation
+    // frames only move when advanced, in the current document from then on and in
+    // every document loaded afterwards. Timers the current document set earlier
+    // keep running on the real clock.
+    void setVirtualTimeEnabled(bool enabled);
+    bool isVirtualTimeEnabled() const;
+    // Runs the timers and frames due within msecs; the callback gets the virtual
+    // time in ms, or -1 if the document has no virtual clock or went away
+    void advanceVirtualTime(int msecs, const std::function<void(double)> &callback = {});
+
+    // Writes the page's requests and responses to device as an HTTP Archive
+    // (HAR 1.2) as their loads complete; only loads in progress stay in memory.
+    // The device must stay open until stopped. Linux only, elsewhere false.
+    bool startHarCapture(QIODevice *device);
+    void stopHarCapture();
+    bool isHarCapturing() const;
+
+public Q_SLOTS:
+    void load(const QUrl &url);
+    void setHtml(const QString &html, const QUrl &baseUrl = QUrl());
+    void stop();
+    void back();
+    void forward();
+    void reload();
+
+Q_SIGNALS:
+    void loadStarted();
+    void loadProgress(int progress);
+    void loadFinished(bool ok);
+    void titleChanged(const QString &title);
+    void statusBarMessage(const QString &text);
+    void linkClicked(const QUrl &url);
+    void iconChanged(const QIcon &icon);
+    void urlChanged(const QUrl &url);
+    void errorOccurred(const QString &error);
+    void downloadRequested(QNativeWebDownload *download);
+    void renderProcessTerminated(QNativeWebPage::RenderProcessTerminationReason reason);
+    // Time from the termination until the page had loaded again; not emitted when
+    // the reload fails or another navigation starts first
+    void renderProcessRecovered(qint64 downtimeMsecs);
+    // Final metrics of a navigation, including the report its document sends when
+    // hidden: once the next document reports, its load finishes, or collection
+    // stops
+    void metricsCollected(const QNativeWebPageMetrics &metrics);
+
+private:
+    friend class QNativeWebView;
+    QNativeWebViewPrivate *d_ptr;
+};
+
+#endif // QNATIVEWEBPAGE_H
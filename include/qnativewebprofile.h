@@ -0,0 +1,134 @@
+#ifndef QNATIVEWEBPROFILE_H
+#define QNATIVEWEBPROFILE_H
+
+#include "QNativeWebView_global.h"
+
+#include <QDateTime>
+#include <QIcon>
+#include <QNetworkCookie>
+#include <QNetworkProxy>
+#include <QObject>
+#include <functional>
+
+class QNativeWebProfilePrivate;
+
+// State shared by every page created with the profile. The profile must outlive
+// its pages.
+class QNATIVEWEBVIEW_EXPORT QNativeWebProfile : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum StorageMode { PersistentStorage, EphemeralStorage };
+    Q_ENUM(StorageMode)
+
+    enum InjectionTime { DocumentStart, DocumentEnd };
+    Q_ENUM(InjectionTime)
+
+    enum CookieChange { CookieAdded, CookieRemoved };
+    Q_ENUM(CookieChange)
+
+    enum WebsiteDataType {
+        MemoryCache = 0x1,
+        DiskCache = 0x2,
+        Cookies = 0x4,
+        SessionStorage = 0x8,
+        LocalStorage = 0x10,
+        IndexedDb = 0x20,
+        ServiceWorkers = 0x40,
+        // Cache API storage of service workers
+        DomCache = 0x80,
+        AllWebsiteData = 0xff
+    };
+    Q_DECLARE_FLAGS(WebsiteDataTypes, WebsiteDataType)
+    Q_FLAG(WebsiteDataTypes)
+
+    struct WebsiteData
+    {
+        // Host or domain the data belongs to, as grouped by the backend
+        QString origin;
+        WebsiteDataTypes types;
+        qint64 size = 0;
+        // Last navigation of a page of the profile to the origin, invalid if unknown
+        QDateTime lastUsed;
+    };
+
+    explicit QNativeWebProfile(QObject *parent = nullptr);
+    // An ephemeral profile keeps cookies, caches and storage in memory and writes
+    // nothing to disk; its website data is dropped when its last page goes away.
+    // Only the Linux backend has ephemeral storage, others keep their default store.
+    explicit QNativeWebProfile(StorageMode storageMode, QObject *parent = nullptr);
+    // A persistent profile keeping its website data apart from all other profiles,
+    // in a directory named storageName under the application's data and cache
+    // locations. Persistent profiles without a name share the backend's default
+    // store. Only the Linux backend has separate stores.
+    explicit QNativeWebProfile(const QString &storageName, QObject *parent = nullptr);
+    ~QNativeWebProfile();
+
+    StorageMode storageMode() const;
+    QString storageName() const;
+
+    // Used by pages constructed without a profile, owned by the application
+    static QNativeWebProfile *defaultProfile();
+
+    // User content is injected into every document loaded by the profile's pages,
+    // before any page script runs for DocumentStart. Returns an id for removal.
+    int addUserScript(const QString &source, InjectionTime injectionTime = DocumentStart,
+                      bool allFrames = false);
+    int addUserStyleSheet(const QString &css, bool allFrames = true);
+    bool removeUserContent(int id);
+    void clearUserContent();
+
+    // Favicon last seen for the host of url, without loading anything
+    QIcon cachedIcon(const QUrl &url) const;
+
+    // Mirror of the backend cookie store kept current by its change notifications,
+    // lookups do not reach the network process. Empty with WebKitGTK before 2.42,
+    // which can not list the store.
+    QNetworkCookie cookie(const QString &domain, const QString &name) const;
+    QList<QNetworkCookie> cookies() const;
+
+    // Website data stored by the profile's pages. All operations are asynchronous
+    // and the callbacks are invoked on the GUI thread.
+    void websiteDataUsage(WebsiteDataTypes types,
+                          const std::function<void(const QList<WebsiteData> &)> &callback);
+    void removeWebsiteData(WebsiteDataTypes types, const QStringList &origins,
+                           const std::function<void()> &callback = {});
+    // Clears data modified since the given time, or all data for an invalid time
+    void clearWebsiteData(WebsiteDataTypes types, const QDateTime &since = QDateTime(),
+                          const std::function<void()> &callback = {});
+
+    // Once the total size exceeds the quota, the least recently used origins are
+    // removed until usage is below 90% of it. Checked after page loads at most once
+    // per evictionInterval, 0 disables the quota. Sizes cover the disk cache, local
+    // storage, IndexedDB and Cache API storage; service worker registrations are
+    // not counted. Profiles sharing the default store would evict each other's
+    // data, so only one of them can have a quota; it covers the whole store.
+    qint64 websiteDataQuota() const;
+    void setWebsiteDataQuota(qint64 bytes);
+    int evictionInterval() const;
+    void setEvictionInterval(int msecs);
+    void evictWebsiteData(const std::function<void(qint64 bytesFreed)> &callback = {});
+
+    // Proxy for the network requests of the profile's pages, DefaultProxy uses the
+    // system settings. Only the Linux backend applies it, where persistent
+    // profiles without a storage name share WebKit's default context and so
+    // their proxy; setting one there warns.
+    QNetworkProxy proxy() const;
+    void setProxy(const QNetworkProxy &proxy);
+
+Q_SIGNALS:
+    void userContentChanged();
+    // A changed value is reported as the old cookie removed and the new one added
+    void cookieChanged(const QNetworkCookie &cookie, QNativeWebProfile::CookieChange change);
+    void websiteDataEvicted(const QStringList &origins, qint64 bytesFreed);
+
+private:
+    friend class QNativeWebProfilePrivate;
+    QNativeWebProfilePrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebProfile)
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(QNativeWebProfile::WebsiteDataTypes)
+
+#endif // QNATIVEWEBPROFILE_H
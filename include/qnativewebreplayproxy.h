@@ -0,0 +1,95 @@
+#ifndef QNATIVEWEBREPLAYPROXY_H
+#define QNATIVEWEBREPLAYPROXY_H
+
+#include "QNativeWebView_global.h"
+
+#include <QNetworkProxy>
+#include <QObject>
+#include <QStringList>
+#include <QUrl>
+
+class QNativeWebReplayProxyPrivate;
+
+struct QNativeWebReplayProxyStatistics
+{
+    quint64 requests = 0;
+    quint64 recorded = 0;
+    quint64 replayed = 0;
+    // Requests the archive has no response for, answered with 404
+    quint64 missed = 0;
+    // CONNECT requests, tunnelled unrecorded when recording and refused in replay
+    quint64 tunnels = 0;
+    // Response bodies sent to the pages
+    qint64 bytesServed = 0;
+};
+
+// HTTP proxy on the loopback interface that records the responses of the
+// pages' requests to an archive file and serves them back from it, so page
+// loads can be measured offline and against the same content on every run.
+//
+// Set it as the proxy of a profile of its own, named or ephemeral, so other
+// pages keep their network; the default profile shares its proxy with every
+// unnamed persistent profile on Linux:
+//
+//     QNativeWebProfile *profile =
+//             new QNativeWebProfile(QNativeWebProfile::EphemeralStorage, parent);
+//     proxy->start(QNativeWebReplayProxy::Replay, "site.qnwr");
+//     profile->setProxy(proxy->networkProxy());
+//
+// Only plain HTTP is recorded and replayed. HTTPS goes through CONNECT tunnels
+// whose content the proxy can not see: they are tunnelled unrecorded when
+// recording and refused with 502 in replay, so HTTPS pages do not load offline.
+//
+// Responses are looked up by method, URL and a hash of the request body. A
+// request made several times is answered with the recorded responses in order,
+// the last one repeating. Query parameters that differ between runs, such as
+// cache busters and timestamps, can be left out of the lookup with
+// setIgnoredQueryParameters(), set to the same names when recording and
+// replaying.
+class QNATIVEWEBVIEW_EXPORT QNativeWebReplayProxy : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode { Record, Replay };
+    Q_ENUM(Mode)
+
+    explicit QNativeWebReplayProxy(QObject *parent = nullptr);
+    ~QNativeWebReplayProxy();
+
+    // Listens on 127.0.0.1, on any free port for 0. Record truncates the
+    // archive, which is complete once stopped; Replay reads its index.
+    bool start(Mode mode, const QString &archivePath, quint16 port = 0);
+    void stop();
+    bool isRunning() const;
+    Mode mode() const;
+    quint16 port() const;
+    QNetworkProxy networkProxy() const;
+    QString errorString() const;
+    // Responses in the archive
+    int entryCount() const;
+
+    // Shaping of replayed responses: the delay before a response starts and the
+    // rate it is sent at per connection in bytes per second, 0 for none
+    int latency() const;
+    void setLatency(int msecs);
+    qint64 bandwidth() const;
+    void setBandwidth(qint64 bytesPerSecond);
+
+    // Names of the query parameters removed from URLs before they are looked up;
+    // none by default
+    QStringList ignoredQueryParameters() const;
+    void setIgnoredQueryParameters(const QStringList &names);
+
+    QNativeWebReplayProxyStatistics statistics() const;
+    void resetStatistics();
+
+Q_SIGNALS:
+    void requestMissed(const QString &method, const QUrl &url);
+
+private:
+    QNativeWebReplayProxyPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebReplayProxy)
+};
+
+#endif // QNATIVEWEBREPLAYPROXY_H
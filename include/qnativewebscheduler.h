@@ -0,0 +1,81 @@
+#ifndef QNATIVEWEBSCHEDULER_H
+#define QNATIVEWEBSCHEDULER_H
+
+#include "QNativeWebView_global.h"
+#include "qnativewebsettings.h"
+
+#include <QObject>
+#include <QUrl>
+#include <QVariant>
+
+class QNativeWebSchedulerPrivate;
+
+struct QNativeWebJob
+{
+    QUrl url;
+    // Evaluated once the page has loaded, its result is reported by jobFinished()
+    QString script;
+    // Milliseconds for load and script together, per attempt
+    int timeout = 30000;
+};
+
+// Runs QNativeWebJobs on a bounded pool of QNativeWebPages, which are reused between jobs.
+class QNATIVEWEBVIEW_EXPORT QNativeWebScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        quint64 succeeded = 0;
+        quint64 failed = 0;
+        quint64 retried = 0;
+        int queueDepth = 0;
+        int activeJobs = 0;
+        // Finished jobs per second since the first job was enqueued
+        double throughput = 0;
+        // Job latency in milliseconds, from dispatch to result
+        double meanLatency = 0;
+        int p50Latency = 0;
+        int p90Latency = 0;
+        int p99Latency = 0;
+        int maxLatency = 0;
+    };
+
+    explicit QNativeWebScheduler(QObject *parent = nullptr);
+    ~QNativeWebScheduler();
+
+    int maxConcurrentJobs() const;
+    void setMaxConcurrentJobs(int count);
+    int maxJobsPerHost() const;
+    void setMaxJobsPerHost(int count);
+    int maxRetries() const;
+    void setMaxRetries(int count);
+    // Delay before the first retry, doubled for every further attempt
+    int retryBackoff() const;
+    void setRetryBackoff(int msecs);
+    // Pages are destroyed and recreated after this many jobs to bound memory growth
+    int jobsPerPage() const;
+    void setJobsPerPage(int count);
+    QNativeWebSettings::PerformanceProfile performanceProfile() const;
+    void setPerformanceProfile(QNativeWebSettings::PerformanceProfile profile);
+
+    quint64 enqueue(const QNativeWebJob &job);
+    void clear();
+
+    int queueDepth() const;
+    int activeJobs() const;
+    Statistics statistics() const;
+    void resetStatistics();
+
+Q_SIGNALS:
+    void jobFinished(quint64 id, const QUrl &url, bool ok, const QVariant &result,
+                     const QString &error);
+    void idle();
+
+private:
+    QNativeWebSchedulerPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebScheduler)
+};
+
+#endif // QNATIVEWEBSCHEDULER_H
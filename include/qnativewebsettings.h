@@ -0,0 +1,62 @@
+#ifndef QNATIVEWEBSETTINGS_H
+#define QNATIVEWEBSETTINGS_H
+
+#include "QNativeWebView_global.h"
+
+#include <QObject>
+
+class QNativeWebSettingsPrivate;
+
+class QNATIVEWEBVIEW_EXPORT QNativeWebSettings : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum HardwareAccelerationPolicy {
+        HardwareAccelerationOnDemand,
+        HardwareAccelerationAlways,
+        HardwareAccelerationNever
+    };
+    Q_ENUM(HardwareAccelerationPolicy)
+
+    enum PerformanceProfile {
+        // Backend defaults
+        DefaultProfile,
+        // Document viewing: no WebGL, no autoplay, no smooth scrolling
+        LightweightViewerProfile,
+        // Machines without a GPU: as above and compositing forced off
+        CpuOnlyKioskProfile
+    };
+    Q_ENUM(PerformanceProfile)
+
+    explicit QNativeWebSettings(QObject *parent = nullptr);
+    ~QNativeWebSettings();
+
+    bool javaScriptEnabled() const;
+    void setJavaScriptEnabled(bool enabled);
+    bool autoLoadImages() const;
+    void setAutoLoadImages(bool enabled);
+    bool webGLEnabled() const;
+    void setWebGLEnabled(bool enabled);
+    bool mediaAutoplayEnabled() const;
+    void setMediaAutoplayEnabled(bool enabled);
+    HardwareAccelerationPolicy hardwareAccelerationPolicy() const;
+    void setHardwareAccelerationPolicy(HardwareAccelerationPolicy policy);
+    bool smoothScrollingEnabled() const;
+    void setSmoothScrollingEnabled(bool enabled);
+    bool allowFileAccess() const;
+    void setAllowFileAccess(bool allow);
+
+    // Sets WebGL, autoplay, acceleration and scrolling and emits settingsChanged()
+    // once; JavaScript, images and file access keep the application's values
+    void applyPerformanceProfile(PerformanceProfile profile);
+
+Q_SIGNALS:
+    void settingsChanged();
+
+private:
+    QNativeWebSettingsPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebSettings)
+};
+
+#endif // QNATIVEWEBSETTINGS_H
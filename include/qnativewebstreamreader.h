@@ -0,0 +1,55 @@
+#ifndef QNATIVEWEBSTREAMREADER_H
+#define QNATIVEWEBSTREAMREADER_H
+
+#include "QNativeWebView_global.h"
+
+#include <QIODevice>
+
+class QNativeWebStreamReaderPrivate;
+
+// Read end of a stream written by a page script, see
+// QNativeWebPage::streamJavaScript(). Chunks are buffered as they arrive and
+// readyRead() is emitted for each. The page may only send window() chunks
+// ahead of what was read, its writes wait for the rest, so the buffer stays
+// within a few chunks whatever the size of the whole result. Readers are not
+// deleted when they finish, the caller deletes them once done reading.
+class QNATIVEWEBVIEW_EXPORT QNativeWebStreamReader : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    ~QNativeWebStreamReader();
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+    // Once the stream has ended and everything was read
+    bool atEnd() const override;
+
+    // True once the page closed the stream or it failed; errorString() is set
+    // on failure
+    bool isFinished() const;
+
+    // Chunks the page may send before they are read, 4 by default
+    int window() const;
+    void setWindow(int chunks);
+
+public Q_SLOTS:
+    // Stops the page's writer, whose pending write fails
+    void cancel();
+
+Q_SIGNALS:
+    void finished();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    explicit QNativeWebStreamReader(QNativeWebStreamReaderPrivate *d, QObject *parent = nullptr);
+
+    friend class QNativeWebStreamReaderPrivate;
+    QNativeWebStreamReaderPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QNativeWebStreamReader)
+};
+
+#endif // QNATIVEWEBSTREAMREADER_H
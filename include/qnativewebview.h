@@ -2,13 +2,22 @@
 #define QNATIVEWEBVIEW_H
 
 #include "QNativeWebView_global.h"
+#include "qnativewebdownload.h"
+#include "qnativewebpage.h"
 
 #include <QWidget>
+#include <QIcon>
 #include <QUrl>
 #include <QJsonObject>
 #include <functional>
 
+class QIODevice;
+class QNativeWebStreamReader;
 class QNativeWebViewPrivate;
+class QNativeWebSettings;
+class QNativeWebProfile;
+class QNativeWebBridge;
+class QNativeWebNavigationPolicy;
 
 class QNATIVEWEBVIEW_EXPORT QNativeWebView : public QWidget
 {
@@ -16,8 +25,15 @@ class QNATIVEWEBVIEW_EXPORT QNativeWebView : public QWidget
 
 public:
     explicit QNativeWebView(QWidget *parent = nullptr, Qt::WindowFlags f = Qt::WindowFlags());
+    // Displays an existing page, or a new one for nullptr; the view takes ownership of it
+    explicit QNativeWebView(QNativeWebPage *page, QWidget *parent = nullptr,
+                            Qt::WindowFlags f = Qt::WindowFlags());
     ~QNativeWebView();
+    QNativeWebPage *page() const;
     QString errorString() const;
+    QNativeWebSettings *settings() const;
+    QNativeWebProfile *profile() const;
+    QIcon icon() const;
     QString userAgent() const;
     bool setUserAgent(const QString &userAgent);
     void allCookies(const std::function<void(const QJsonObject &)> &callback);
@@ -26,6 +42,51 @@ public:
     void deleteAllCookies();
     void evaluateJavaScript(const QString &scriptSource,
                             const std::function<void(const QVariant &)> &callback = {});
+    void pageSource(const std::function<void(const QByteArray &)> &callback);
+    void plainText(const std::function<void(const QString &)> &callback);
+    void setDownloadPolicy(const QNativeWebDownloadPolicy &policy);
+    QList<QNativeWebDownload *> downloads() const;
+    QNativeWebDownloadStatistics downloadStatistics() const;
+    // See QNativeWebPage::setRenderProcessRecovery()
+    void setRenderProcessRecovery(int maxRestarts, int intervalMsecs = 60000);
+    // See QNativeWebPage::setWebBridge()
+    void setWebBridge(QNativeWebBridge *bridge);
+    QNativeWebBridge *webBridge() const;
+    // See QNativeWebPage::setNavigationPolicy()
+    void setNavigationPolicy(QNativeWebNavigationPolicy *policy);
+    QNativeWebNavigationPolicy *navigationPolicy() const;
+    // See QNativeWebPage::postData()
+    void postData(const QString &channel, const QByteArray &data, int chunkSize = 0);
+    // See QNativeWebPage::streamJavaScript()
+    QNativeWebStreamReader *streamJavaScript(const QString &producer);
+    // See QNativeWebPage::setMetricsCollectionEnabled()
+    void setMetricsCollectionEnabled(bool enabled);
+    bool isMetricsCollectionEnabled() const;
+    // See QNativeWebPage::metrics()
+    QNativeWebPageMetrics metrics() const;
+    // Console capture, see QNativeWebPage::setConsoleCapacity()
+    void setConsoleCapacity(int capacity);
+    int consoleCapacity() const;
+    QList<QNativeWebConsoleMessage> drainConsoleMessages();
+    quint64 droppedConsoleMessages() const;
+    void dumpConsoleMessages(int fd) const;
+    // See QNativeWebPage::setQueryCacheEnabled()
+    void setQueryCacheEnabled(bool enabled);
+    bool isQueryCacheEnabled() const;
+    void evaluateCachedJavaScript(const QString &query,
+                                  const std::function<void(const QVariant &)> &callback);
+    QNativeWebQueryCacheStatistics queryCacheStatistics() const;
+    void resetQueryCacheStatistics();
+
+    // See QNativeWebPage::setVirtualTimeEnabled()
+    void setVirtualTimeEnabled(bool enabled);
+    bool isVirtualTimeEnabled() const;
+    void advanceVirtualTime(int msecs, const std::function<void(double)> &callback = {});
+
+    // See QNativeWebPage::startHarCapture()
+    bool startHarCapture(QIODevice *device);
+    void stopHarCapture();
+    bool isHarCapturing() const;
 
 public Q_SLOTS:
     void load(const QUrl &url);
@@ -45,8 +106,17 @@ Q_SIGNALS:
     void iconChanged(const QIcon &icon);
     void urlChanged(const QUrl &url);
     void errorOccurred(const QString &error);
+    void downloadRequested(QNativeWebDownload *download);
+    void renderProcessTerminated(QNativeWebPage::RenderProcessTerminationReason reason);
+    // See QNativeWebPage::renderProcessRecovered()
+    void renderProcessRecovered(qint64 downtimeMsecs);
+    // See QNativeWebPage::metricsCollected()
+    void metricsCollected(const QNativeWebPageMetrics &metrics);
 
 private:
+    void initialize();
+
+    QNativeWebPage *m_page;
     QNativeWebViewPrivate *d_ptr;
     Q_DECLARE_PRIVATE(QNativeWebView)
 };
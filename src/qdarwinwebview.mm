@@ -1,4 +1,8 @@
 #include "private/qdarwinwebview.h"
+#include "private/qnativewebprofile_p.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
 
 #include <QDebug>
 #include <QWindow>
@@ -38,6 +42,7 @@ typedef NSView UIView;
 - (void)webView:(WKWebView *)webView
         didFailNavigation:(WKNavigation *)navigation
                 withError:(NSError *)error;
+- (void)webViewWebContentProcessDidTerminate:(WKWebView *)webView;
 
 @end
 
@@ -127,6 +132,10 @@ typedef NSView UIView;
 {
     Q_UNUSED(webView);
     NSURL *url = navigationAction.request.URL;
+    if (!qDarwinWebViewPrivate->isNavigationAllowed(QUrl::fromNSURL(url))) {
+        decisionHandler(WKNavigationActionPolicyCancel);
+        return;
+    }
     const BOOL handled = (^{
         // For links with target="_blank", open externally
         if (!navigationAction.targetFrame)
@@ -216,10 +225,99 @@ typedef NSView UIView;
     completionHandler(result.toNSString());
 }
 
+- (void)webViewWebContentProcessDidTerminate:(WKWebView *)webView
+{
+    Q_UNUSED(webView);
+    qDarwinWebViewPrivate->webContentProcessDidTerminate();
+}
+
+@end
+
+static QNetworkCookie fromNSHTTPCookie(NSHTTPCookie *cookie)
+{
+    QNetworkCookie result(QString::fromNSString(cookie.name).toUtf8(),
+                          QString::fromNSString(cookie.value).toUtf8());
+    result.setDomain(QString::fromNSString(cookie.domain));
+    result.setPath(QString::fromNSString(cookie.path));
+    result.setSecure(cookie.secure);
+    result.setHttpOnly(cookie.HTTPOnly);
+    if (!cookie.sessionOnly && cookie.expiresDate != nil) {
+        result.setExpirationDate(QDateTime::fromNSDate(cookie.expiresDate));
+    }
+    return result;
+}
+
+// Refreshes the cookie mirror of a profile, then calls done on the main thread
+static void refreshCookies(WKHTTPCookieStore *cookieStore, QNativeWebProfile *profile,
+                           const std::function<void()> &done = {})
+{
+    QPointer<QNativeWebProfile> profilePtr = profile;
+    std::function<void()> callback = done;
+    [cookieStore getAllCookies:^(NSArray<NSHTTPCookie *> *cookies) {
+        QList<QNetworkCookie> cookieList;
+        for (NSHTTPCookie *cookie in cookies) {
+            cookieList.append(fromNSHTTPCookie(cookie));
+        }
+        QMetaObject::invokeMethod(qApp, [profilePtr, cookieList, callback] {
+            if (profilePtr) {
+                QNativeWebProfilePrivate::get(profilePtr)->setCookies(cookieList);
+            }
+            if (callback) {
+                callback();
+            }
+        });
+    }];
+}
+
+@interface QtWKCookieObserver : NSObject <WKHTTPCookieStoreObserver> {
+    QNativeWebProfile *profile;
+}
+- (QtWKCookieObserver *)initWithProfile:(QNativeWebProfile *)webProfile;
 @end
 
-QDarwinWebViewPrivate::QDarwinWebViewPrivate(QObject *parent)
-    : QNativeWebViewPrivate(parent), m_webview(nil), m_navigation(nil), m_window(nullptr)
+@implementation QtWKCookieObserver
+- (QtWKCookieObserver *)initWithProfile:(QNativeWebProfile *)webProfile
+{
+    if ((self = [super init])) {
+        profile = webProfile;
+    }
+    return self;
+}
+
+- (void)cookiesDidChangeInCookieStore:(WKHTTPCookieStore *)cookieStore
+{
+    refreshCookies(cookieStore, profile);
+}
+@end
+
+@interface QtWKScriptMessageHandler : NSObject <WKScriptMessageHandler> {
+    QDarwinWebViewPrivate *qDarwinWebViewPrivate;
+}
+- (QtWKScriptMessageHandler *)initWithQDarwinWebView:(QDarwinWebViewPrivate *)webViewPrivate;
+@end
+
+@implementation QtWKScriptMessageHandler
+- (QtWKScriptMessageHandler *)initWithQDarwinWebView:(QDarwinWebViewPrivate *)webViewPrivate
+{
+    if ((self = [super init])) {
+        qDarwinWebViewPrivate = webViewPrivate;
+    }
+    return self;
+}
+
+- (void)userContentController:(WKUserContentController *)userContentController
+      didReceiveScriptMessage:(WKScriptMessage *)message
+{
+    Q_UNUSED(userContentController);
+    if ([message.body isKindOfClass:[NSString class]]) {
+        qDarwinWebViewPrivate->scriptMessageReceived(QString::fromNSString(message.name),
+                                                     QString::fromNSString(message.body));
+    }
+}
+@end
+
+QDarwinWebViewPrivate::QDarwinWebViewPrivate(QNativeWebProfile *profile, QObject *parent)
+    : QNativeWebViewPrivate(profile, parent), m_webview(nil), m_navigation(nil), m_window(nullptr)
 {
     initialize();
 }
@@ -231,6 +329,9 @@ QDarwinWebViewPrivate::~QDarwinWebViewPrivate()
                    forKeyPath:@"estimatedProgress"
                       context:nil];
     [m_webview removeObserver:m_webview.navigationDelegate forKeyPath:@"title" context:nil];
+    for (auto it = m_messageHandlers.cbegin(); it != m_messageHandlers.cend(); ++it) {
+        unregisterMessageHandler(it.key());
+    }
     [m_webview.navigationDelegate release];
     m_webview.navigationDelegate = nil;
     [m_webview release];
@@ -346,59 +447,23 @@ bool QDarwinWebViewPrivate::setUserAgent(const QString &userAgent)
 
 void QDarwinWebViewPrivate::allCookies(const std::function<void(const QJsonObject &)> &callback)
 {
-    if (m_webview) {
-        WKHTTPCookieStore *cookieStore = m_webview.configuration.websiteDataStore.httpCookieStore;
-        if (cookieStore == nullptr) {
-            if (callback) {
-                QMetaObject::invokeMethod(this, [callback] { callback(QJsonObject()); });
-            }
-            return;
+    WKHTTPCookieStore *cookieStore =
+            m_webview ? m_webview.configuration.websiteDataStore.httpCookieStore : nil;
+    if (cookieStore == nil) {
+        if (callback) {
+            QMetaObject::invokeMethod(this, [callback] { callback(QJsonObject()); });
         }
-
-        std::function<void(const QJsonObject &)> cb = callback;
-        [cookieStore getAllCookies:^(NSArray *cookies) {
-            QJsonObject result;
-            for (NSHTTPCookie *cookie in cookies) {
-                // domain
-                QString strDomain = QString::fromNSString(cookie.domain);
-                if (!result.contains(strDomain)) {
-                    result.insert(strDomain, QJsonObject());
-                }
-                // name
-                QString strName = QString::fromNSString(cookie.name);
-                if (strName.isEmpty()) {
-                    continue;
-                }
-
-                // expires
-                double expires = 0;
-                NSDate *expiresDate = cookie.expiresDate;
-                if (expiresDate != nil) {
-                    expires = [expiresDate timeIntervalSince1970];
-                }
-
-                QJsonValueRef refDomain = result[strDomain];
-                QJsonObject jsonDomain = refDomain.toObject();
-                jsonDomain[strName] = QJsonObject{
-                    { "value", QString::fromNSString(cookie.value) },
-                    { "path", QString::fromNSString(cookie.path) },
-                    { "expires", expires },
-                    { "httpOnly", (bool)cookie.HTTPOnly },
-                    { "secure", (bool)cookie.secure },
-                    { "session", (bool)cookie.sessionOnly },
-                };
-                refDomain = jsonDomain;
-            }
-            if (cb) {
-                QMetaObject::invokeMethod(this, [cb, result] { cb(result); });
-            }
-        }];
         return;
-    } else {
+    }
+
+    // The mirror builds each domain object once instead of copying it per cookie
+    QPointer<QNativeWebProfile> profile = m_profile;
+    refreshCookies(cookieStore, m_profile, [profile, callback] {
         if (callback) {
-            callback(QJsonObject());
+            callback(profile ? QNativeWebProfilePrivate::get(profile)->cookiesToJson()
+                             : QJsonObject());
         }
-    }
+    });
 }
 
 bool QDarwinWebViewPrivate::setCookie(const QString &domain, const QString &name,
@@ -575,6 +640,109 @@ void QDarwinWebViewPrivate::evaluateJavaScript(
     }
 }
 
+void QDarwinWebViewPrivate::applySettings()
+{
+    if (m_webview) {
+        m_webview.configuration.preferences.javaScriptEnabled = m_settings->javaScriptEnabled();
+    }
+}
+
+void QDarwinWebViewPrivate::watchCookies()
+{
+    QNativeWebProfilePrivate *profile = QNativeWebProfilePrivate::get(m_profile);
+    if (profile->cookieObserver) {
+        return;
+    }
+
+    WKHTTPCookieStore *cookieStore = m_webview.configuration.websiteDataStore.httpCookieStore;
+    [cookieStore retain];
+    QtWKCookieObserver *observer = [[QtWKCookieObserver alloc] initWithProfile:m_profile];
+    [cookieStore addObserver:observer];
+    profile->cookieObserver.reset(observer, [cookieStore](void *observer) {
+        [cookieStore removeObserver:(QtWKCookieObserver *)observer];
+        [(QtWKCookieObserver *)observer release];
+        [cookieStore release];
+    });
+    refreshCookies(cookieStore, m_profile);
+}
+
+void QDarwinWebViewPrivate::applyUserContent()
+{
+    if (!m_webview) {
+        return;
+    }
+
+    WKUserContentController *controller = m_webview.configuration.userContentController;
+    [controller removeAllUserScripts];
+
+    // WKUserScript objects are immutable and shared by all views of the profile
+    for (QNativeWebUserContent &content : QNativeWebProfilePrivate::get(m_profile)->userContent) {
+        if (!content.native) {
+            // Stylesheets are injected as scripts, WKUserStyleSheet is not public API
+            const QString source = content.styleSheet
+                    ? QNativeWebProfilePrivate::styleSheetScript(content.source)
+                    : content.source;
+            const WKUserScriptInjectionTime time =
+                    content.styleSheet || content.injectionTime == QNativeWebProfile::DocumentStart
+                    ? WKUserScriptInjectionTimeAtDocumentStart
+                    : WKUserScriptInjectionTimeAtDocumentEnd;
+            WKUserScript *script =
+                    [[WKUserScript alloc] initWithSource:source.toNSString()
+                                           injectionTime:time
+                                        forMainFrameOnly:content.allFrames ? NO : YES];
+            content.native.reset(script, [](void *script) { [(WKUserScript *)script release]; });
+        }
+        [controller addUserScript:(WKUserScript *)content.native.get()];
+    }
+
+    for (MessageHandlerEntry &entry : m_messageHandlers) {
+        if (entry.script.isEmpty()) {
+            continue;
+        }
+        if (!entry.native) {
+            WKUserScript *script =
+                    [[WKUserScript alloc] initWithSource:entry.script.toNSString()
+                                           injectionTime:WKUserScriptInjectionTimeAtDocumentStart
+                                        forMainFrameOnly:YES];
+            entry.native.reset(script, [](void *script) { [(WKUserScript *)script release]; });
+        }
+        [controller addUserScript:(WKUserScript *)entry.native.get()];
+    }
+}
+
+void QDarwinWebViewPrivate::registerMessageHandler(const QString &name)
+{
+    if (!m_webview) {
+        return;
+    }
+
+    // The controller retains the handler until it is removed
+    QtWKScriptMessageHandler *handler =
+            [[QtWKScriptMessageHandler alloc] initWithQDarwinWebView:this];
+    [m_webview.configuration.userContentController addScriptMessageHandler:handler
+                                                                      name:name.toNSString()];
+    [handler release];
+}
+
+void QDarwinWebViewPrivate::unregisterMessageHandler(const QString &name)
+{
+    if (m_webview) {
+        [m_webview.configuration.userContentController
+                removeScriptMessageHandlerForName:name.toNSString()];
+    }
+}
+
+void QDarwinWebViewPrivate::scriptMessageReceived(const QString &name, const QString &message)
+{
+    dispatchMessage(name, message);
+}
+
+void QDarwinWebViewPrivate::webContentProcessDidTerminate()
+{
+    // WebKit does not tell why the process ended
+    handleRenderProcessTerminated(QNativeWebPage::RenderProcessCrashed);
+}
+
 void QDarwinWebViewPrivate::updateWindowGeometry() { }
 
 void QDarwinWebViewPrivate::initialize()
@@ -597,5 +765,8 @@ void QDarwinWebViewPrivate::initialize()
         m_webview.inspectable = YES;
     }
 
+    applyUserContent();
+    watchCookies();
+
     m_window = QWindow::fromWinId(reinterpret_cast<WId>(m_webview));
 }
@@ -0,0 +1,445 @@
+// clang-format off
+#include <webkit2/webkit2.h>
+// clang-format on
+
+#include "private/qlinuxwebcontext.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QHash>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QUrl>
+
+namespace {
+
+struct TypeMapping
+{
+    QNativeWebProfile::WebsiteDataType type;
+    WebKitWebsiteDataTypes webkitType;
+};
+
+const TypeMapping typeMappings[] = {
+    { QNativeWebProfile::MemoryCache, WEBKIT_WEBSITE_DATA_MEMORY_CACHE },
+    { QNativeWebProfile::DiskCache, WEBKIT_WEBSITE_DATA_DISK_CACHE },
+    { QNativeWebProfile::Cookies, WEBKIT_WEBSITE_DATA_COOKIES },
+    { QNativeWebProfile::SessionStorage, WEBKIT_WEBSITE_DATA_SESSION_STORAGE },
+    { QNativeWebProfile::LocalStorage, WEBKIT_WEBSITE_DATA_LOCAL_STORAGE },
+    { QNativeWebProfile::IndexedDb, WEBKIT_WEBSITE_DATA_INDEXEDDB_DATABASES },
+#if WEBKIT_CHECK_VERSION(2, 30, 0)
+    { QNativeWebProfile::ServiceWorkers, WEBKIT_WEBSITE_DATA_SERVICE_WORKER_REGISTRATIONS },
+#endif
+#if WEBKIT_CHECK_VERSION(2, 34, 0)
+    { QNativeWebProfile::DomCache, WEBKIT_WEBSITE_DATA_DOM_CACHE },
+#endif
+};
+
+WebKitWebsiteDataTypes toWebKitTypes(QNativeWebProfile::WebsiteDataTypes types)
+{
+    int result = 0;
+    for (const TypeMapping &mapping : typeMappings) {
+        if (types & mapping.type) {
+            result |= mapping.webkitType;
+        }
+    }
+    return WebKitWebsiteDataTypes(result);
+}
+
+QNativeWebProfile::WebsiteDataTypes fromWebKitTypes(WebKitWebsiteDataTypes types)
+{
+    QNativeWebProfile::WebsiteDataTypes result;
+    for (const TypeMapping &mapping : typeMappings) {
+        if (types & mapping.webkitType) {
+            result |= mapping.type;
+        }
+    }
+    return result;
+}
+
+// Fetches the website data records of the given types and hands them to callback,
+// which does not take ownership of the list
+void fetchWebsiteData(WebKitWebsiteDataManager *manager, WebKitWebsiteDataTypes types,
+                      const std::function<void(GList *)> &callback)
+{
+    webkit_website_data_manager_fetch(
+            manager, types, nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                std::function<void(GList *)> *callback =
+                        static_cast<std::function<void(GList *)> *>(userData);
+                GError *error = nullptr;
+                GList *records = webkit_website_data_manager_fetch_finish(
+                        WEBKIT_WEBSITE_DATA_MANAGER(object), result, &error);
+                if (error) {
+                    qWarning() << "Failed to fetch website data:" << error->message;
+                    g_error_free(error);
+                }
+                (*callback)(records);
+                g_list_free_full(records,
+                                 reinterpret_cast<GDestroyNotify>(webkit_website_data_unref));
+                delete callback;
+            },
+            new std::function<void(GList *)>(callback));
+}
+
+// Storage WebKit reports no size for. Newer WebKit keeps it per origin in
+// <base data directory>/storage, in a directory for each type.
+const struct
+{
+    QNativeWebProfile::WebsiteDataType type;
+    const char *directory;
+} storageDirectories[] = {
+    { QNativeWebProfile::LocalStorage, "LocalStorage" },
+    { QNativeWebProfile::IndexedDb, "IndexedDB" },
+    { QNativeWebProfile::DomCache, "CacheStorage" },
+};
+
+qint64 diskUsage(const QFileInfo &entry)
+{
+    if (!entry.isDir()) {
+        return entry.size();
+    }
+    qint64 size = 0;
+    QDirIterator it(entry.filePath(), QDir::Files | QDir::Hidden | QDir::NoSymLinks,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        size += it.fileInfo().size();
+    }
+    return size;
+}
+
+// Host of the origin a storage entry belongs to. Older WebKit names entries after
+// the origin, as in https_www.example.com_0.localstorage; newer WebKit names them
+// by hash and writes the top level and the storing origin to an "origin" file.
+QString entryHost(const QFileInfo &entry)
+{
+    static const QRegularExpression hostPattern(QStringLiteral("[A-Za-z0-9-]+(\\.[A-Za-z0-9-]+)+"));
+    QFile originFile(entry.filePath() + QLatin1String("/origin"));
+    if (entry.isDir() && originFile.open(QIODevice::ReadOnly)) {
+        // The hosts are stored as Latin-1 between binary lengths and ports
+        const QString contents = QString::fromLatin1(originFile.read(4096));
+        QString host;
+        QRegularExpressionMatchIterator it = hostPattern.globalMatch(contents);
+        while (it.hasNext()) {
+            host = it.next().captured();
+        }
+        return host;
+    }
+
+    // Hashed names have no dots, so they do not pass for a scheme, host and port
+    static const QRegularExpression namePattern(
+            QStringLiteral("^[a-z][a-z0-9+.-]*_(.+)_[0-9]+(\\.localstorage.*)?$"));
+    const QString host = namePattern.match(entry.fileName()).captured(1);
+    return hostPattern.match(host).capturedLength() == host.size() ? host : QString();
+}
+
+// Adds the size of the entries of directory to the hosts they belong to, looking
+// into directories that are not an origin's for a few levels
+void measureStorage(const QString &directory, QNativeWebProfile::WebsiteDataTypes types,
+                    QHash<QString, qint64> *sizes, int depth = 3)
+{
+    if (directory.isEmpty() || depth == 0) {
+        return;
+    }
+    const QFileInfoList entries =
+            QDir(directory).entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot);
+    for (const QFileInfo &entry : entries) {
+        const QString host = entryHost(entry);
+        if (host.isEmpty()) {
+            if (entry.isDir()) {
+                measureStorage(entry.filePath(), types, sizes, depth - 1);
+            }
+            continue;
+        }
+        // Newer WebKit keeps all types of an origin together, one directory each
+        const QDir origin(entry.filePath());
+        bool split = false;
+        for (const auto &storage : storageDirectories) {
+            const QFileInfo typeEntry(origin.filePath(QLatin1String(storage.directory)));
+            if (entry.isDir() && typeEntry.exists()) {
+                split = true;
+                if (types & storage.type) {
+                    (*sizes)[host] += diskUsage(typeEntry);
+                }
+            }
+        }
+        if (!split) {
+            (*sizes)[host] += diskUsage(entry);
+        }
+    }
+}
+
+// Whether host belongs to the domain WebKit groups website data by
+bool inDomain(const QString &host, const QString &domain)
+{
+    return host.compare(domain, Qt::CaseInsensitive) == 0
+            || host.endsWith(QLatin1Char('.') + domain, Qt::CaseInsensitive);
+}
+
+// Ephemeral profiles get an ephemeral context and named profiles a context with a
+// data manager of their own; the others share WebKit's default context
+WebKitWebContext *createContext(QNativeWebProfile *profile)
+{
+    if (profile->storageMode() == QNativeWebProfile::EphemeralStorage) {
+        return webkit_web_context_new_ephemeral();
+    }
+    if (profile->storageName().isEmpty()) {
+        return WEBKIT_WEB_CONTEXT(g_object_ref(webkit_web_context_get_default()));
+    }
+
+    const QString path = QStringLiteral("profiles/") + profile->storageName();
+    const QByteArray data =
+            QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation))
+                    .filePath(path)
+                    .toUtf8();
+    const QByteArray cache =
+            QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+                    .filePath(path)
+                    .toUtf8();
+    WebKitWebsiteDataManager *manager = webkit_website_data_manager_new(
+            "base-data-directory", data.constData(), "base-cache-directory", cache.constData(),
+            nullptr);
+    WebKitWebContext *context = webkit_web_context_new_with_website_data_manager(manager);
+    g_object_unref(manager);
+    webkit_web_context_set_favicon_database_directory(context, (cache + "/favicons").constData());
+    return context;
+}
+
+} // namespace
+
+QLinuxWebContext::QLinuxWebContext(QNativeWebProfile *profile)
+    : QNativeWebProfileBackend(profile), m_context(createContext(profile))
+{
+}
+
+QLinuxWebContext::~QLinuxWebContext()
+{
+    g_object_unref(m_context);
+}
+
+void QLinuxWebContext::removeView()
+{
+    if (--m_views > 0
+        || !webkit_web_context_is_ephemeral(static_cast<WebKitWebContext *>(m_context))) {
+        return;
+    }
+    // Frees the memory of the data nothing can reach any more; the context itself
+    // is kept for the profile's next view
+    clearWebsiteData(QNativeWebProfile::AllWebsiteData, QDateTime(), [] {});
+}
+
+bool QLinuxWebContext::sharesWebsiteData() const
+{
+    return m_context == webkit_web_context_get_default();
+}
+
+void QLinuxWebContext::addUserContent(void *userContentManager)
+{
+    WebKitUserContentManager *manager = static_cast<WebKitUserContentManager *>(userContentManager);
+    for (QNativeWebUserContent &content : QNativeWebProfilePrivate::get(m_profile)->userContent) {
+        const WebKitUserContentInjectedFrames frames = content.allFrames
+                ? WEBKIT_USER_CONTENT_INJECT_ALL_FRAMES
+                : WEBKIT_USER_CONTENT_INJECT_TOP_FRAME;
+        const QByteArray source = content.source.toUtf8();
+        if (content.styleSheet) {
+            if (!content.native) {
+                content.native.reset(webkit_user_style_sheet_new(source.constData(), frames,
+                                                                 WEBKIT_USER_STYLE_LEVEL_USER,
+                                                                 nullptr, nullptr),
+                                     [](void *styleSheet) {
+                                         webkit_user_style_sheet_unref(
+                                                 static_cast<WebKitUserStyleSheet *>(styleSheet));
+                                     });
+            }
+            webkit_user_content_manager_add_style_sheet(
+                    manager, static_cast<WebKitUserStyleSheet *>(content.native.get()));
+        } else {
+            if (!content.native) {
+                const WebKitUserScriptInjectionTime time =
+                        content.injectionTime == QNativeWebProfile::DocumentStart
+                        ? WEBKIT_USER_SCRIPT_INJECT_AT_DOCUMENT_START
+                        : WEBKIT_USER_SCRIPT_INJECT_AT_DOCUMENT_END;
+                content.native.reset(
+                        webkit_user_script_new(source.constData(), frames, time, nullptr, nullptr),
+                        [](void *script) {
+                            webkit_user_script_unref(static_cast<WebKitUserScript *>(script));
+                        });
+            }
+            webkit_user_content_manager_add_script(
+                    manager, static_cast<WebKitUserScript *>(content.native.get()));
+        }
+    }
+}
+
+void QLinuxWebContext::websiteDataUsage(
+        QNativeWebProfile::WebsiteDataTypes types,
+        const std::function<void(const QList<QNativeWebProfile::WebsiteData> &)> &callback)
+{
+    WebKitWebsiteDataManager *manager =
+            webkit_web_context_get_website_data_manager(static_cast<WebKitWebContext *>(m_context));
+    const WebKitWebsiteDataTypes webkitTypes = toWebKitTypes(types);
+
+    // WebKit only measures the disk cache, the storage of the other types is
+    // measured on disk. Service worker registrations share one database for all
+    // origins and are not counted.
+    const QNativeWebProfile::WebsiteDataTypes measured = types
+            & (QNativeWebProfile::LocalStorage | QNativeWebProfile::IndexedDb
+               | QNativeWebProfile::DomCache);
+    QStringList directories;
+    if (measured & QNativeWebProfile::LocalStorage) {
+        directories.append(QString::fromUtf8(
+                webkit_website_data_manager_get_local_storage_directory(manager)));
+    }
+    if (measured & QNativeWebProfile::IndexedDb) {
+        directories.append(
+                QString::fromUtf8(webkit_website_data_manager_get_indexeddb_directory(manager)));
+    }
+#if WEBKIT_CHECK_VERSION(2, 30, 0)
+    if (measured & QNativeWebProfile::DomCache) {
+        directories.append(
+                QString::fromUtf8(webkit_website_data_manager_get_dom_cache_directory(manager)));
+    }
+#endif
+    const char *baseDirectory = webkit_website_data_manager_get_base_data_directory(manager);
+    if (measured && baseDirectory) {
+        directories.append(
+                QDir(QString::fromUtf8(baseDirectory)).filePath(QStringLiteral("storage")));
+    }
+    directories.removeDuplicates();
+    QHash<QString, qint64> storage;
+    for (const QString &directory : qAsConst(directories)) {
+        measureStorage(directory, measured, &storage);
+    }
+
+    const WebKitWebsiteDataTypes sizedTypes =
+            WebKitWebsiteDataTypes(webkitTypes & ~toWebKitTypes(measured));
+    fetchWebsiteData(manager, webkitTypes, [callback, sizedTypes, storage](GList *records) {
+        QList<QNativeWebProfile::WebsiteData> result;
+        for (GList *it = records; it; it = it->next) {
+            WebKitWebsiteData *data = static_cast<WebKitWebsiteData *>(it->data);
+            QNativeWebProfile::WebsiteData record;
+            record.origin = QString::fromUtf8(webkit_website_data_get_name(data));
+            record.types = fromWebKitTypes(webkit_website_data_get_types(data));
+            record.size = qint64(webkit_website_data_get_size(data, sizedTypes));
+            for (auto size = storage.cbegin(); size != storage.cend(); ++size) {
+                if (inDomain(size.key(), record.origin)) {
+                    record.size += size.value();
+                }
+            }
+            result.append(record);
+        }
+        callback(result);
+    });
+}
+
+void QLinuxWebContext::removeWebsiteData(QNativeWebProfile::WebsiteDataTypes types,
+                                         const QStringList &origins,
+                                         const std::function<void()> &callback)
+{
+    WebKitWebsiteDataManager *manager =
+            webkit_web_context_get_website_data_manager(static_cast<WebKitWebContext *>(m_context));
+    const WebKitWebsiteDataTypes webkitTypes = toWebKitTypes(types);
+    auto remove = [manager, webkitTypes, origins, callback](GList *records) {
+        // The records to remove are matched by name, WebKit only removes records it returned
+        GList *selected = nullptr;
+        for (GList *it = records; it; it = it->next) {
+            WebKitWebsiteData *data = static_cast<WebKitWebsiteData *>(it->data);
+            if (origins.contains(QString::fromUtf8(webkit_website_data_get_name(data)))) {
+                selected = g_list_prepend(selected, webkit_website_data_ref(data));
+            }
+        }
+        if (!selected) {
+            callback();
+            return;
+        }
+
+        webkit_website_data_manager_remove(
+                manager, webkitTypes, selected, nullptr,
+                +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                    std::function<void()> *callback =
+                            static_cast<std::function<void()> *>(userData);
+                    GError *error = nullptr;
+                    if (!webkit_website_data_manager_remove_finish(
+                                WEBKIT_WEBSITE_DATA_MANAGER(object), result, &error)) {
+                        qWarning() << "Failed to remove website data:"
+                                   << (error ? error->message : "");
+                        g_clear_error(&error);
+                    }
+                    (*callback)();
+                    delete callback;
+                },
+                new std::function<void()>(callback));
+        g_list_free_full(selected, reinterpret_cast<GDestroyNotify>(webkit_website_data_unref));
+    };
+    fetchWebsiteData(manager, webkitTypes, remove);
+}
+
+void QLinuxWebContext::clearWebsiteData(QNativeWebProfile::WebsiteDataTypes types,
+                                        const QDateTime &since,
+                                        const std::function<void()> &callback)
+{
+    // WebKit clears the data modified in the last timespan, 0 meaning all of it
+    GTimeSpan timeSpan = 0;
+    if (since.isValid()) {
+        timeSpan = qMax<GTimeSpan>(1, since.msecsTo(QDateTime::currentDateTimeUtc()) * 1000);
+    }
+    WebKitWebsiteDataManager *manager =
+            webkit_web_context_get_website_data_manager(static_cast<WebKitWebContext *>(m_context));
+    webkit_website_data_manager_clear(
+            manager, toWebKitTypes(types), timeSpan, nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                std::function<void()> *callback = static_cast<std::function<void()> *>(userData);
+                GError *error = nullptr;
+                if (!webkit_website_data_manager_clear_finish(WEBKIT_WEBSITE_DATA_MANAGER(object),
+                                                              result, &error)) {
+                    qWarning() << "Failed to clear website data:" << (error ? error->message : "");
+                    g_clear_error(&error);
+                }
+                (*callback)();
+                delete callback;
+            },
+            new std::function<void()>(callback));
+}
+
+void QLinuxWebContext::setProxy(const QNetworkProxy &proxy)
+{
+    WebKitNetworkProxyMode mode = WEBKIT_NETWORK_PROXY_MODE_DEFAULT;
+    WebKitNetworkProxySettings *settings = nullptr;
+    switch (proxy.type()) {
+    case QNetworkProxy::NoProxy:
+        mode = WEBKIT_NETWORK_PROXY_MODE_NO_PROXY;
+        break;
+    case QNetworkProxy::HttpProxy:
+    case QNetworkProxy::Socks5Proxy: {
+        QUrl uri;
+        uri.setScheme(proxy.type() == QNetworkProxy::HttpProxy ? QStringLiteral("http")
+                                                                : QStringLiteral("socks5"));
+        uri.setHost(proxy.hostName());
+        uri.setPort(proxy.port());
+        uri.setUserName(proxy.user());
+        uri.setPassword(proxy.password());
+        mode = WEBKIT_NETWORK_PROXY_MODE_CUSTOM;
+        settings = webkit_network_proxy_settings_new(uri.toEncoded().constData(), nullptr);
+        break;
+    }
+    default:
+        // Caching and FTP proxies have no WebKit equivalent
+        if (proxy.type() != QNetworkProxy::DefaultProxy) {
+            qWarning() << "Unsupported proxy type" << proxy.type();
+        }
+        break;
+    }
+#if WEBKIT_CHECK_VERSION(2, 32, 0)
+    webkit_website_data_manager_set_network_proxy_settings(
+            webkit_web_context_get_website_data_manager(static_cast<WebKitWebContext *>(m_context)),
+            mode, settings);
+#else
+    webkit_web_context_set_network_proxy_settings(static_cast<WebKitWebContext *>(m_context),
+                                                  mode, settings);
+#endif
+    if (settings) {
+        webkit_network_proxy_settings_free(settings);
+    }
+}
@@ -4,12 +4,31 @@
 // clang-format on
 
 #include "private/qlinuxwebview.h"
+#include "private/qlinuxwebcontext.h"
+#include "private/qnativewebdownload_p.h"
+#include "private/qnativewebprofile_p.h"
+#include "qnativewebassetpack.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QUrlQuery>
 #include <QWindow>
 #include <QTimer>
 #include <QScreen>
 #include <QUrl>
+#include <QPointer>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QPixmap>
+#include <QStandardPaths>
+
+#include <limits>
 
 // clang-format off
 #include <cairo/cairo.h>
@@ -19,36 +38,169 @@
 #include <gtk/gtkx.h>
 // clang-format on
 
-QLinuxWebViewPrivate::QLinuxWebViewPrivate(QObject *parent)
-    : QNativeWebViewPrivate(parent), m_webview(nullptr), m_widget(nullptr), m_window(nullptr)
+namespace {
+
+// Scheme of the data handed to pages by postData()
+const char DataScheme[] = "qnwdata";
+// Set on every WebKitWebView to find its QLinuxWebViewPrivate
+const char ViewKey[] = "qnativewebview-view";
+// Largest buffer a QByteArray can hold, less room for its header; just under 2 GB in Qt 5
+using ByteArraySize = decltype(QByteArray().size());
+const gsize MaxByteArraySize = gsize(std::numeric_limits<ByteArraySize>::max()) - 64;
+
+QJsonArray harHeaders(SoupMessageHeaders *headers)
+{
+    QJsonArray result;
+    if (headers) {
+        soup_message_headers_foreach(
+                headers,
+                +[](const char *name, const char *value, gpointer userData) {
+                    static_cast<QJsonArray *>(userData)->append(
+                            QJsonObject{ { QStringLiteral("name"), QString::fromUtf8(name) },
+                                         { QStringLiteral("value"), QString::fromUtf8(value) } });
+                },
+                &result);
+    }
+    return result;
+}
+
+QJsonObject harRequest(WebKitURIRequest *request)
+{
+    const QUrl url(QString::fromUtf8(webkit_uri_request_get_uri(request)));
+    QJsonArray queryString;
+    const QList<QPair<QString, QString>> items =
+            QUrlQuery(url).queryItems(QUrl::FullyDecoded);
+    for (const QPair<QString, QString> &item : items) {
+        queryString.append(QJsonObject{ { QStringLiteral("name"), item.first },
+                                        { QStringLiteral("value"), item.second } });
+    }
+    const char *method = webkit_uri_request_get_http_method(request);
+    return QJsonObject{
+        { QStringLiteral("method"), QString::fromLatin1(method ? method : "GET") },
+        { QStringLiteral("url"), url.toString() },
+        { QStringLiteral("httpVersion"), QString() },
+        { QStringLiteral("cookies"), QJsonArray() },
+        { QStringLiteral("headers"), harHeaders(webkit_uri_request_get_http_headers(request)) },
+        { QStringLiteral("queryString"), queryString },
+        { QStringLiteral("headersSize"), -1 },
+        { QStringLiteral("bodySize"), -1 }
+    };
+}
+
+// An empty response for loads that failed before one arrived
+QJsonObject harResponse(WebKitURIResponse *response)
+{
+    QJsonObject result{ { QStringLiteral("status"), 0 },
+                        { QStringLiteral("statusText"), QString() },
+                        { QStringLiteral("httpVersion"), QString() },
+                        { QStringLiteral("cookies"), QJsonArray() },
+                        { QStringLiteral("headers"), QJsonArray() },
+                        { QStringLiteral("redirectURL"), QString() },
+                        { QStringLiteral("headersSize"), -1 },
+                        { QStringLiteral("bodySize"), -1 } };
+    QJsonObject content{ { QStringLiteral("size"), 0 },
+                         { QStringLiteral("mimeType"), QString() } };
+    if (response) {
+        const guint status = webkit_uri_response_get_status_code(response);
+        SoupMessageHeaders *headers = webkit_uri_response_get_http_headers(response);
+        const char *location =
+                headers ? soup_message_headers_get_one(headers, "Location") : nullptr;
+        // 0 when the length is not known in advance
+        const double length = double(webkit_uri_response_get_content_length(response));
+        result.insert(QStringLiteral("status"), int(status));
+        result.insert(QStringLiteral("statusText"),
+                      QString::fromUtf8(status ? soup_status_get_phrase(status) : ""));
+        result.insert(QStringLiteral("headers"), harHeaders(headers));
+        result.insert(QStringLiteral("redirectURL"), QString::fromUtf8(location ? location : ""));
+        result.insert(QStringLiteral("bodySize"), length > 0 ? length : -1);
+        content.insert(QStringLiteral("size"), length);
+        content.insert(QStringLiteral("mimeType"),
+                       QString::fromUtf8(webkit_uri_response_get_mime_type(response)));
+    }
+    result.insert(QStringLiteral("content"), content);
+    return result;
+}
+
+} // namespace
+
+// Resource load followed by the HAR capture
+struct QLinuxHarResource
+{
+    QJsonObject request;
+    QDateTime started;
+    QElapsedTimer timer;
+    // Time to the response, -1 before it arrives
+    qint64 wait = -1;
+    QString error;
+
+    QJsonObject entry(WebKitURIResponse *response) const
+    {
+        const qint64 time = timer.elapsed();
+        const qint64 waited = wait >= 0 ? wait : time;
+        QJsonObject result{
+            { QStringLiteral("startedDateTime"), started.toString(Qt::ISODateWithMs) },
+            { QStringLiteral("time"), double(time) },
+            { QStringLiteral("request"), request },
+            { QStringLiteral("response"), harResponse(response) },
+            { QStringLiteral("cache"), QJsonObject() },
+            // WebKit does not report the connection phases
+            { QStringLiteral("timings"),
+              QJsonObject{ { QStringLiteral("blocked"), -1 },
+                           { QStringLiteral("dns"), -1 },
+                           { QStringLiteral("connect"), -1 },
+                           { QStringLiteral("ssl"), -1 },
+                           { QStringLiteral("send"), 0 },
+                           { QStringLiteral("wait"), double(waited) },
+                           { QStringLiteral("receive"), double(time - waited) } } }
+        };
+        if (!error.isEmpty()) {
+            result.insert(QStringLiteral("_error"), error);
+        }
+        return result;
+    }
+
+    // Starts over for the request a redirect leads to
+    void restart(WebKitURIRequest *uriRequest)
+    {
+        request = harRequest(uriRequest);
+        started = QDateTime::currentDateTime();
+        timer.start();
+        wait = -1;
+    }
+};
+
+QLinuxWebViewPrivate::QLinuxWebViewPrivate(QNativeWebProfile *profile, QObject *parent)
+    : QNativeWebViewPrivate(profile, parent),
+      m_webview(nullptr),
+      m_widget(nullptr),
+      m_offscreen(nullptr),
+      m_window(nullptr)
 {
     qputenv("GDK_BACKEND", "x11");
     // Initialize GTK
     gtk_init(nullptr, nullptr);
 
-    // Create WebView
-    m_webview = WEBKIT_WEB_VIEW(webkit_web_view_new());
+    // Create WebView in the profile's web context. Each view has a user content
+    // manager of its own, so its message handlers can not be reached from other
+    // views; the profile's scripts are shared between the managers.
+    m_webview = WEBKIT_WEB_VIEW(webkit_web_view_new_with_context(
+            static_cast<WebKitWebContext *>(QLinuxWebContext::get(profile)->context())));
     WebKitWebView *webview = (WebKitWebView *)m_webview;
     if (webview && WEBKIT_IS_WEB_VIEW(webview)) {
-        m_widget = gtk_plug_new(0);
-        GtkWidget *widget = (GtkWidget *)m_widget;
-        if (widget) {
-            gtk_container_add(GTK_CONTAINER(widget), GTK_WIDGET(webview));
-            gtk_widget_show_all(widget);
-            gtk_widget_realize(widget);
-            void *hWnd = reinterpret_cast<void *>(gtk_plug_get_id(GTK_PLUG(widget)));
-            if (hWnd) {
-                // Create a QWindow without a parent
-                // This window is used for initializing the WebView2
-                m_window = QWindow::fromWinId(WId(hWnd));
-                m_window->setFlag(Qt::FramelessWindowHint); // No border
-                QTimer::singleShot(0, this, [this]() { emit initialize(); });
-            } else {
-                qWarning() << "Can not get plug widget handle";
-            }
-        } else {
-            qWarning() << "Failed to create plug widget";
-        }
+        g_object_set_data(G_OBJECT(webview), ViewKey, this);
+        QLinuxWebContext::get(profile)->addView();
+        applySettings();
+        applyUserContent();
+        initializeContext(webkit_web_view_get_context(webview));
+        watchCookies();
+
+        // The view lives in an offscreen toplevel until a widget asks for a native
+        // window, so pages used without a QNativeWebView never map an X window
+        m_offscreen = gtk_offscreen_window_new();
+        GtkWidget *offscreen = (GtkWidget *)m_offscreen;
+        gtk_container_add(GTK_CONTAINER(offscreen), GTK_WIDGET(webview));
+        gtk_widget_show_all(offscreen);
+        QTimer::singleShot(0, this, [this]() { emit initialize(); });
     } else {
         qWarning() << "Failed to create WebKit view";
     }
@@ -56,8 +208,23 @@ QLinuxWebViewPrivate::QLinuxWebViewPrivate(QObject *parent)
 
 QLinuxWebViewPrivate::~QLinuxWebViewPrivate()
 {
+    // Completes the archive while the resources can still be let go
+    stopHarCapture();
     stop();
 
+    if (m_webview) {
+        g_object_set_data(G_OBJECT(m_webview), ViewKey, nullptr);
+        WebKitUserContentManager *manager =
+                webkit_web_view_get_user_content_manager(static_cast<WebKitWebView *>(m_webview));
+        for (const unsigned long id : qAsConst(m_messageHandlerIds)) {
+            g_signal_handler_disconnect(manager, id);
+        }
+        // The web context is shared and outlives this view
+        g_signal_handlers_disconnect_by_data(
+                webkit_web_view_get_context(static_cast<WebKitWebView *>(m_webview)), this);
+        QLinuxWebContext::get(m_profile)->removeView();
+    }
+
     if (m_widget) {
         GtkWidget *widget = (GtkWidget *)m_widget;
         gtk_widget_hide(widget);
@@ -65,6 +232,11 @@ QLinuxWebViewPrivate::~QLinuxWebViewPrivate()
         m_widget = nullptr;
     }
 
+    if (m_offscreen) {
+        gtk_widget_destroy((GtkWidget *)m_offscreen);
+        m_offscreen = nullptr;
+    }
+
     if (m_window) {
         m_window->destroy();
     }
@@ -77,7 +249,15 @@ void QLinuxWebViewPrivate::load(const QUrl &url)
     }
 }
 
-void QLinuxWebViewPrivate::setHtml(const QString &html, const QUrl &baseUrl) { }
+void QLinuxWebViewPrivate::setHtml(const QString &html, const QUrl &baseUrl)
+{
+    if (m_webview) {
+        const QByteArray base = baseUrl.toString().toUtf8();
+        webkit_web_view_load_html(static_cast<WebKitWebView *>(m_webview),
+                                  html.toUtf8().constData(),
+                                  baseUrl.isEmpty() ? nullptr : base.constData());
+    }
+}
 
 void QLinuxWebViewPrivate::stop()
 {
@@ -109,39 +289,814 @@ void QLinuxWebViewPrivate::reload()
 
 QWindow *QLinuxWebViewPrivate::nativeWindow()
 {
+    if (!m_window && m_webview) {
+        createNativeWindow();
+    }
     return m_window;
 }
 
 QString QLinuxWebViewPrivate::errorString() const
 {
-    return "";
+    return m_error;
 }
 
 QString QLinuxWebViewPrivate::userAgent() const
 {
+    if (m_webview) {
+        WebKitSettings *settings =
+                webkit_web_view_get_settings(static_cast<WebKitWebView *>(m_webview));
+        return QString::fromUtf8(webkit_settings_get_user_agent(settings));
+    }
     return "";
 }
 
 bool QLinuxWebViewPrivate::setUserAgent(const QString &userAgent)
 {
+    if (m_webview && !userAgent.isEmpty()) {
+        WebKitSettings *settings =
+                webkit_web_view_get_settings(static_cast<WebKitWebView *>(m_webview));
+        webkit_settings_set_user_agent(settings, userAgent.toUtf8().constData());
+        return true;
+    }
     return false;
 }
 
-void QLinuxWebViewPrivate::allCookies(const std::function<void(const QJsonObject &)> &callback) { }
+static QNetworkCookie fromSoupCookie(SoupCookie *cookie)
+{
+    QNetworkCookie result(QByteArray(soup_cookie_get_name(cookie)),
+                          QByteArray(soup_cookie_get_value(cookie)));
+    result.setDomain(QString::fromUtf8(soup_cookie_get_domain(cookie)));
+    result.setPath(QString::fromUtf8(soup_cookie_get_path(cookie)));
+    result.setSecure(soup_cookie_get_secure(cookie));
+    result.setHttpOnly(soup_cookie_get_http_only(cookie));
+#if SOUP_CHECK_VERSION(2, 99, 0)
+    if (GDateTime *expires = soup_cookie_get_expires(cookie)) {
+        result.setExpirationDate(QDateTime::fromSecsSinceEpoch(g_date_time_to_unix(expires)));
+    }
+#else
+    if (SoupDate *expires = soup_cookie_get_expires(cookie)) {
+        result.setExpirationDate(QDateTime::fromSecsSinceEpoch(soup_date_to_time_t(expires)));
+    }
+#endif
+    return result;
+}
+
+namespace {
+
+// Shared by all views of a profile, owned by QNativeWebProfilePrivate::cookieObserver
+struct CookieObserver
+{
+    WebKitCookieManager *manager = nullptr;
+    QNativeWebProfile *profile = nullptr;
+    gulong handler = 0;
+    // WebKit reports every cookie of a response separately, so changes arriving
+    // during a fetch are coalesced into one more fetch
+    bool fetching = false;
+    bool dirty = false;
+    QList<std::function<void()>> pending;
+};
+
+} // namespace
+
+static void refreshCookies(CookieObserver *observer, const std::function<void()> &done = {})
+{
+    if (done) {
+        observer->pending.append(done);
+    }
+    if (observer->fetching) {
+        observer->dirty = true;
+        return;
+    }
+#if WEBKIT_CHECK_VERSION(2, 42, 0)
+    observer->fetching = true;
+    observer->dirty = false;
+    QPointer<QNativeWebProfile> *profile = new QPointer<QNativeWebProfile>(observer->profile);
+    webkit_cookie_manager_get_all_cookies(
+            observer->manager, nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                QPointer<QNativeWebProfile> *profile =
+                        static_cast<QPointer<QNativeWebProfile> *>(userData);
+                GError *error = nullptr;
+                GList *list = webkit_cookie_manager_get_all_cookies_finish(
+                        WEBKIT_COOKIE_MANAGER(object), result, &error);
+                if (*profile) {
+                    QNativeWebProfilePrivate *d = QNativeWebProfilePrivate::get(*profile);
+                    if (error) {
+                        qWarning() << "Failed to get cookies:" << error->message;
+                    } else {
+                        QList<QNetworkCookie> cookies;
+                        for (GList *it = list; it; it = it->next) {
+                            cookies.append(fromSoupCookie(static_cast<SoupCookie *>(it->data)));
+                        }
+                        d->setCookies(cookies);
+                    }
+                    CookieObserver *observer =
+                            static_cast<CookieObserver *>(d->cookieObserver.get());
+                    observer->fetching = false;
+                    if (observer->dirty) {
+                        refreshCookies(observer);
+                    } else {
+                        const QList<std::function<void()>> pending = observer->pending;
+                        observer->pending.clear();
+                        for (const std::function<void()> &done : pending) {
+                            done();
+                        }
+                    }
+                }
+                if (error) {
+                    g_error_free(error);
+                }
+                g_list_free_full(list, reinterpret_cast<GDestroyNotify>(soup_cookie_free));
+                delete profile;
+            },
+            profile);
+#else
+    // No way to enumerate the store, the mirror stays empty; watchCookies() warns
+    const QList<std::function<void()>> pending = observer->pending;
+    observer->pending.clear();
+    for (const std::function<void()> &callback : pending) {
+        callback();
+    }
+#endif
+}
+
+void QLinuxWebViewPrivate::watchCookies()
+{
+    QNativeWebProfilePrivate *profile = QNativeWebProfilePrivate::get(m_profile);
+    if (profile->cookieObserver) {
+        return;
+    }
+
+#if !WEBKIT_CHECK_VERSION(2, 42, 0)
+    qWarning() << "WebKitGTK 2.42 or later is needed to list cookies; cookies() stays empty"
+                  " and cookieChanged() is not emitted";
+#endif
+    CookieObserver *observer = new CookieObserver;
+    observer->manager = webkit_web_context_get_cookie_manager(
+            webkit_web_view_get_context(static_cast<WebKitWebView *>(m_webview)));
+    observer->profile = m_profile;
+    g_object_ref(observer->manager);
+    observer->handler = g_signal_connect_swapped(
+            observer->manager, "changed",
+            G_CALLBACK(+[](CookieObserver *observer) { refreshCookies(observer); }), observer);
+    profile->cookieObserver.reset(observer, [](void *data) {
+        CookieObserver *observer = static_cast<CookieObserver *>(data);
+        g_signal_handler_disconnect(observer->manager, observer->handler);
+        g_object_unref(observer->manager);
+        delete observer;
+    });
+    refreshCookies(observer);
+}
+
+void QLinuxWebViewPrivate::allCookies(const std::function<void(const QJsonObject &)> &callback)
+{
+    CookieObserver *observer = static_cast<CookieObserver *>(
+            QNativeWebProfilePrivate::get(m_profile)->cookieObserver.get());
+    if (!observer) {
+        if (callback) {
+            callback(QJsonObject());
+        }
+        return;
+    }
+
+    // Answered from the mirror once it has caught up with the store
+    QPointer<QNativeWebProfile> profile = m_profile;
+    refreshCookies(observer, [profile, callback] {
+        if (callback) {
+            callback(profile ? QNativeWebProfilePrivate::get(profile)->cookiesToJson()
+                             : QJsonObject());
+        }
+    });
+}
+
+// Completion of a cookie added or deleted through the cookie manager. The store's
+// "changed" signal updates the mirror, this catches up when the change did not
+// emit it.
+static void cookieChangeFinished(QPointer<QNativeWebProfile> *profile, GError *error)
+{
+    if (error) {
+        qWarning() << "Failed to change cookie:" << error->message;
+    }
+    if (*profile) {
+        if (CookieObserver *observer = static_cast<CookieObserver *>(
+                    QNativeWebProfilePrivate::get(*profile)->cookieObserver.get())) {
+            refreshCookies(observer);
+        }
+    }
+    if (error) {
+        g_error_free(error);
+    }
+    delete profile;
+}
 
 bool QLinuxWebViewPrivate::setCookie(const QString &domain, const QString &name,
                                      const QString &value)
 {
-    return false;
+    // A session cookie for every path of the domain
+    SoupCookie *cookie = soup_cookie_new(name.toUtf8().constData(), value.toUtf8().constData(),
+                                         domain.toUtf8().constData(), "/", -1);
+    webkit_cookie_manager_add_cookie(
+            webkit_web_context_get_cookie_manager(
+                    webkit_web_view_get_context(static_cast<WebKitWebView *>(m_webview))),
+            cookie, nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                GError *error = nullptr;
+                webkit_cookie_manager_add_cookie_finish(WEBKIT_COOKIE_MANAGER(object), result,
+                                                        &error);
+                cookieChangeFinished(static_cast<QPointer<QNativeWebProfile> *>(userData), error);
+            },
+            new QPointer<QNativeWebProfile>(m_profile));
+    soup_cookie_free(cookie);
+    return true;
 }
 
-void QLinuxWebViewPrivate::deleteCookie(const QString &domain, const QString &name) { }
+void QLinuxWebViewPrivate::deleteCookie(const QString &domain, const QString &name)
+{
+    // WebKit matches the name, domain and path
+    const QNetworkCookie known = m_profile->cookie(domain, name);
+    const QByteArray path = known.path().isEmpty() ? QByteArray("/") : known.path().toUtf8();
+    SoupCookie *cookie = soup_cookie_new(name.toUtf8().constData(), "",
+                                         domain.toUtf8().constData(), path.constData(), -1);
+    webkit_cookie_manager_delete_cookie(
+            webkit_web_context_get_cookie_manager(
+                    webkit_web_view_get_context(static_cast<WebKitWebView *>(m_webview))),
+            cookie, nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                GError *error = nullptr;
+                webkit_cookie_manager_delete_cookie_finish(WEBKIT_COOKIE_MANAGER(object), result,
+                                                           &error);
+                cookieChangeFinished(static_cast<QPointer<QNativeWebProfile> *>(userData), error);
+            },
+            new QPointer<QNativeWebProfile>(m_profile));
+    soup_cookie_free(cookie);
+}
 
-void QLinuxWebViewPrivate::deleteAllCookies() { }
+void QLinuxWebViewPrivate::deleteAllCookies()
+{
+    QPointer<QNativeWebProfile> profile = m_profile;
+    QNativeWebProfilePrivate::get(m_profile)->backend->clearWebsiteData(
+            QNativeWebProfile::Cookies, QDateTime(), [profile] {
+                if (!profile) {
+                    return;
+                }
+                if (CookieObserver *observer = static_cast<CookieObserver *>(
+                            QNativeWebProfilePrivate::get(profile)->cookieObserver.get())) {
+                    refreshCookies(observer);
+                }
+            });
+}
+
+static QVariant fromJSCValue(JSCValue *value)
+{
+    if (!value || jsc_value_is_undefined(value) || jsc_value_is_null(value)) {
+        return QVariant();
+    }
+    if (jsc_value_is_boolean(value)) {
+        return bool(jsc_value_to_boolean(value));
+    }
+    if (jsc_value_is_number(value)) {
+        return jsc_value_to_double(value);
+    }
+    if (jsc_value_is_string(value)) {
+        gchar *str = jsc_value_to_string(value);
+        const QString result = QString::fromUtf8(str);
+        g_free(str);
+        return result;
+    }
+
+    // Arrays and objects are converted through JSON
+    QVariant result;
+    gchar *json = jsc_value_to_json(value, 0);
+    if (json) {
+        QJsonParseError parseError;
+        const QJsonDocument jsonDoc = QJsonDocument::fromJson(QByteArray(json), &parseError);
+        if (parseError.error == QJsonParseError::NoError) {
+            result = jsonDoc.toVariant();
+        }
+        g_free(json);
+    }
+    return result;
+}
 
 void QLinuxWebViewPrivate::evaluateJavaScript(const QString &scriptSource,
                                               const std::function<void(const QVariant &)> &callback)
 {
+    if (!m_webview) {
+        if (callback) {
+            callback(QVariant());
+        }
+        return;
+    }
+
+    struct CallbackData
+    {
+        QPointer<QLinuxWebViewPrivate> instance;
+        std::function<void(const QVariant &)> callback;
+    };
+    CallbackData *data = new CallbackData{ this, callback };
+    const QByteArray script = scriptSource.toUtf8();
+
+#if WEBKIT_CHECK_VERSION(2, 40, 0)
+    webkit_web_view_evaluate_javascript(
+            static_cast<WebKitWebView *>(m_webview), script.constData(), script.size(), nullptr,
+            nullptr, nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                CallbackData *data = static_cast<CallbackData *>(userData);
+                GError *error = nullptr;
+                JSCValue *value = webkit_web_view_evaluate_javascript_finish(
+                        WEBKIT_WEB_VIEW(object), result, &error);
+                QVariant variant;
+                if (value) {
+                    variant = fromJSCValue(value);
+                    g_object_unref(value);
+                } else {
+                    // Failures are told apart from string results by an invalid value
+                    if (error) {
+                        qWarning() << "Failed to evaluate JavaScript:" << error->message;
+                        g_error_free(error);
+                    }
+                }
+                if (data->instance && data->callback) {
+                    data->callback(variant);
+                }
+                delete data;
+            },
+            data);
+#else
+    webkit_web_view_run_javascript(
+            static_cast<WebKitWebView *>(m_webview), script.constData(), nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                CallbackData *data = static_cast<CallbackData *>(userData);
+                GError *error = nullptr;
+                WebKitJavascriptResult *jsResult = webkit_web_view_run_javascript_finish(
+                        WEBKIT_WEB_VIEW(object), result, &error);
+                QVariant variant;
+                if (jsResult) {
+                    variant = fromJSCValue(webkit_javascript_result_get_js_value(jsResult));
+                    webkit_javascript_result_unref(jsResult);
+                } else {
+                    // Failures are told apart from string results by an invalid value
+                    if (error) {
+                        qWarning() << "Failed to evaluate JavaScript:" << error->message;
+                        g_error_free(error);
+                    }
+                }
+                if (data->instance && data->callback) {
+                    data->callback(variant);
+                }
+                delete data;
+            },
+            data);
+#endif
+}
+
+void QLinuxWebViewPrivate::pageSource(const std::function<void(const QByteArray &)> &callback)
+{
+    WebKitWebResource *resource = m_webview
+            ? webkit_web_view_get_main_resource(static_cast<WebKitWebView *>(m_webview))
+            : nullptr;
+    if (!resource) {
+        if (callback) {
+            callback(QByteArray());
+        }
+        return;
+    }
+
+    // WebKit hands over a copy of the resource data, which is copied once more into the
+    // QByteArray; that still avoids the JS string, JSON and QString of outerHTML
+    struct CallbackData
+    {
+        QPointer<QLinuxWebViewPrivate> instance;
+        std::function<void(const QByteArray &)> callback;
+    };
+    CallbackData *data = new CallbackData{ this, callback };
+    webkit_web_resource_get_data(
+            resource, nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                CallbackData *data = static_cast<CallbackData *>(userData);
+                gsize length = 0;
+                GError *error = nullptr;
+                guchar *bytes = webkit_web_resource_get_data_finish(WEBKIT_WEB_RESOURCE(object),
+                                                                    result, &length, &error);
+                QByteArray source;
+                if (bytes && length > MaxByteArraySize) {
+                    qWarning() << "Page source of" << quint64(length) << "bytes is too large";
+                } else if (bytes) {
+                    source = QByteArray(reinterpret_cast<const char *>(bytes),
+                                        ByteArraySize(length));
+                }
+                g_free(bytes);
+                if (error) {
+                    qWarning() << "Failed to get page source:" << error->message;
+                    g_error_free(error);
+                }
+                if (data->instance && data->callback) {
+                    data->callback(source);
+                }
+                delete data;
+            },
+            data);
+}
+
+void QLinuxWebViewPrivate::applySettings()
+{
+    if (!m_webview) {
+        return;
+    }
+
+    WebKitHardwareAccelerationPolicy policy = WEBKIT_HARDWARE_ACCELERATION_POLICY_ON_DEMAND;
+    switch (m_settings->hardwareAccelerationPolicy()) {
+    case QNativeWebSettings::HardwareAccelerationOnDemand:
+        policy = WEBKIT_HARDWARE_ACCELERATION_POLICY_ON_DEMAND;
+        break;
+    case QNativeWebSettings::HardwareAccelerationAlways:
+        policy = WEBKIT_HARDWARE_ACCELERATION_POLICY_ALWAYS;
+        break;
+    case QNativeWebSettings::HardwareAccelerationNever:
+        policy = WEBKIT_HARDWARE_ACCELERATION_POLICY_NEVER;
+        break;
+    }
+
+    // Set all properties in one g_object_set() call so notify:: emissions are coalesced
+    WebKitSettings *settings =
+            webkit_web_view_get_settings(static_cast<WebKitWebView *>(m_webview));
+    g_object_set(G_OBJECT(settings), "enable-javascript", gboolean(m_settings->javaScriptEnabled()),
+                 "auto-load-images", gboolean(m_settings->autoLoadImages()), "enable-webgl",
+                 gboolean(m_settings->webGLEnabled()), "media-playback-requires-user-gesture",
+                 gboolean(!m_settings->mediaAutoplayEnabled()), "hardware-acceleration-policy",
+                 policy, "enable-smooth-scrolling", gboolean(m_settings->smoothScrollingEnabled()),
+                 "allow-file-access-from-file-urls", gboolean(m_settings->allowFileAccess()),
+                 nullptr);
+}
+
+static void finishAssetRequest(WebKitURISchemeRequest *request)
+{
+    const QUrl url(QString::fromUtf8(webkit_uri_scheme_request_get_uri(request)));
+    QNativeWebAssetPack *pack = QNativeWebAssetPack::installed(url.host());
+    // Paths in the pack are relative; the root and directories serve their index.html
+    QString path = url.path();
+    if (path.startsWith(QLatin1Char('/'))) {
+        path.remove(0, 1);
+    }
+    if (path.isEmpty() || path.endsWith(QLatin1Char('/'))) {
+        path += QLatin1String("index.html");
+    }
+    const QNativeWebAssetPack::Asset asset = pack ? pack->find(path) : QNativeWebAssetPack::Asset();
+    if (!asset.isValid()) {
+        GError *error = g_error_new(G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "%s not found",
+                                    url.toString().toUtf8().constData());
+        webkit_uri_scheme_request_finish_error(request, error);
+        g_error_free(error);
+        return;
+    }
+
+    // Serve straight from the mapping, the bytes hold a reference to the pack file
+    GBytes *bytes = g_bytes_new_with_free_func(
+            asset.data, gsize(asset.size),
+            +[](gpointer storage) { delete static_cast<std::shared_ptr<const void> *>(storage); },
+            new std::shared_ptr<const void>(asset.storage));
+    GInputStream *stream = g_memory_input_stream_new_from_bytes(bytes);
+    g_bytes_unref(bytes);
+    if (asset.compressed) {
+        // Custom schemes can not pass Content-Encoding, so inflate while WebKit reads
+        GZlibDecompressor *decompressor = g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB);
+        GInputStream *inflated = g_converter_input_stream_new(stream, G_CONVERTER(decompressor));
+        g_object_unref(decompressor);
+        g_object_unref(stream);
+        stream = inflated;
+    }
+
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+    SoupMessageHeaders *requestHeaders = webkit_uri_scheme_request_get_http_headers(request);
+    const char *ifNoneMatch = requestHeaders
+            ? soup_message_headers_get_one(requestHeaders, "If-None-Match")
+            : nullptr;
+    const bool notModified = ifNoneMatch && asset.etag == ifNoneMatch;
+    if (notModified) {
+        g_object_unref(stream);
+        stream = g_memory_input_stream_new();
+    }
+    WebKitURISchemeResponse *response = webkit_uri_scheme_response_new(
+            stream, notModified ? 0 : gint64(asset.originalSize));
+    SoupMessageHeaders *headers = soup_message_headers_new(SOUP_MESSAGE_HEADERS_RESPONSE);
+    soup_message_headers_append(headers, "ETag", asset.etag.constData());
+    soup_message_headers_append(headers, "Cache-Control", "no-cache");
+    webkit_uri_scheme_response_set_http_headers(response, headers);
+    webkit_uri_scheme_response_set_content_type(response, asset.mimeType.constData());
+    webkit_uri_scheme_response_set_status(response, notModified ? 304 : 200, nullptr);
+    webkit_uri_scheme_request_finish_with_response(request, response);
+    g_object_unref(response);
+#else
+    webkit_uri_scheme_request_finish(request, stream, gint64(asset.originalSize),
+                                     asset.mimeType.constData());
+#endif
+    g_object_unref(stream);
+}
+
+void QLinuxWebViewPrivate::initializeContext(void *nativeContext)
+{
+    WebKitWebContext *context = static_cast<WebKitWebContext *>(nativeContext);
+    // Schemes can only be registered once per context, which may be shared by many views
+    static const char key[] = "qnativewebview-initialized";
+    if (g_object_get_data(G_OBJECT(context), key)) {
+        return;
+    }
+    g_object_set_data(G_OBJECT(context), key, GINT_TO_POINTER(1));
+
+    // Favicons are stored once for all views and survive restarts. Ephemeral
+    // contexts get no database, pages of ephemeral profiles have no icons.
+    if (!webkit_web_context_is_ephemeral(context)
+        && !webkit_web_context_get_favicon_database_directory(context)) {
+        const QByteArray directory =
+                QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+                        .filePath(QStringLiteral("favicons"))
+                        .toUtf8();
+        webkit_web_context_set_favicon_database_directory(context, directory.constData());
+    }
+
+    const QByteArray scheme = QNativeWebAssetPack::scheme().toUtf8();
+    webkit_web_context_register_uri_scheme(
+            context, scheme.constData(),
+            +[](WebKitURISchemeRequest *request, gpointer) { finishAssetRequest(request); },
+            nullptr, nullptr);
+    WebKitSecurityManager *security = webkit_web_context_get_security_manager(context);
+    webkit_security_manager_register_uri_scheme_as_secure(security, scheme.constData());
+    webkit_security_manager_register_uri_scheme_as_cors_enabled(security, scheme.constData());
+
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+    // Requests are answered by the view that posted the data
+    webkit_web_context_register_uri_scheme(
+            context, DataScheme,
+            +[](WebKitURISchemeRequest *request, gpointer) {
+                WebKitWebView *webview = webkit_uri_scheme_request_get_web_view(request);
+                QLinuxWebViewPrivate *view = webview
+                        ? static_cast<QLinuxWebViewPrivate *>(
+                                  g_object_get_data(G_OBJECT(webview), ViewKey))
+                        : nullptr;
+                if (view) {
+                    view->finishDataRequest(request);
+                } else {
+                    GError *error = g_error_new_literal(G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                                                        "No such transfer");
+                    webkit_uri_scheme_request_finish_error(request, error);
+                    g_error_free(error);
+                }
+            },
+            nullptr, nullptr);
+    webkit_security_manager_register_uri_scheme_as_secure(security, DataScheme);
+    webkit_security_manager_register_uri_scheme_as_cors_enabled(security, DataScheme);
+#endif
+}
+
+QString QLinuxWebViewPrivate::postedDataUrl(int id, const PostedData &posted) const
+{
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+    return QStringLiteral("%1://transfer/%2/%3")
+            .arg(QLatin1String(DataScheme), QString::number(id), QString::fromLatin1(posted.key));
+#else
+    // Cross-origin fetches need the CORS header of WebKitURISchemeResponse
+    Q_UNUSED(id);
+    Q_UNUSED(posted);
+    return QString();
+#endif
+}
+
+void QLinuxWebViewPrivate::finishDataRequest(void *nativeRequest)
+{
+#if WEBKIT_CHECK_VERSION(2, 36, 0)
+    WebKitURISchemeRequest *request = static_cast<WebKitURISchemeRequest *>(nativeRequest);
+    // qnwdata://transfer/<id>/<key>/<chunk>
+    const QStringList path = QString::fromUtf8(webkit_uri_scheme_request_get_path(request))
+                                     .mid(1)
+                                     .split(QLatin1Char('/'));
+    auto it = path.size() == 3 ? m_postedData.find(path.at(0).toInt()) : m_postedData.end();
+    const int chunk = path.value(2).toInt();
+    if (it == m_postedData.end() || it->key != path.at(1).toLatin1() || chunk != it->nextChunk) {
+        GError *error =
+                g_error_new_literal(G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No such transfer");
+        webkit_uri_scheme_request_finish_error(request, error);
+        g_error_free(error);
+        return;
+    }
+
+    ++it->nextChunk;
+    const int offset = chunk * it->chunkSize;
+    const int size = qMax(qMin(it->chunkSize, it->data.size() - offset), 0);
+    // WebKit reads straight from the posted QByteArray, which the bytes keep alive
+    QByteArray *data = new QByteArray(it->data);
+    GBytes *bytes = g_bytes_new_with_free_func(
+            data->constData() + offset, gsize(size),
+            +[](gpointer data) { delete static_cast<QByteArray *>(data); }, data);
+    if (offset + size >= it->data.size()) {
+        m_postedData.erase(it);
+    }
+    GInputStream *stream = g_memory_input_stream_new_from_bytes(bytes);
+    g_bytes_unref(bytes);
+
+    WebKitURISchemeResponse *response = webkit_uri_scheme_response_new(stream, gint64(size));
+    SoupMessageHeaders *headers = soup_message_headers_new(SOUP_MESSAGE_HEADERS_RESPONSE);
+    // Fetched from the page's own origin
+    soup_message_headers_append(headers, "Access-Control-Allow-Origin", "*");
+    soup_message_headers_append(headers, "Cache-Control", "no-store");
+    webkit_uri_scheme_response_set_http_headers(response, headers);
+    webkit_uri_scheme_response_set_content_type(response, "application/octet-stream");
+    webkit_uri_scheme_request_finish_with_response(request, response);
+    g_object_unref(response);
+    g_object_unref(stream);
+#else
+    Q_UNUSED(nativeRequest);
+#endif
+}
+
+void QLinuxWebViewPrivate::applyUserContent()
+{
+    if (!m_webview) {
+        return;
+    }
+
+    WebKitUserContentManager *manager =
+            webkit_web_view_get_user_content_manager(static_cast<WebKitWebView *>(m_webview));
+    webkit_user_content_manager_remove_all_scripts(manager);
+    webkit_user_content_manager_remove_all_style_sheets(manager);
+    QLinuxWebContext::get(m_profile)->addUserContent(manager);
+
+    for (MessageHandlerEntry &entry : m_messageHandlers) {
+        if (entry.script.isEmpty()) {
+            continue;
+        }
+        if (!entry.native) {
+            entry.native.reset(webkit_user_script_new(entry.script.toUtf8().constData(),
+                                                      WEBKIT_USER_CONTENT_INJECT_TOP_FRAME,
+                                                      WEBKIT_USER_SCRIPT_INJECT_AT_DOCUMENT_START,
+                                                      nullptr, nullptr),
+                               [](void *script) {
+                                   webkit_user_script_unref(
+                                           static_cast<WebKitUserScript *>(script));
+                               });
+        }
+        webkit_user_content_manager_add_script(
+                manager, static_cast<WebKitUserScript *>(entry.native.get()));
+    }
+}
+
+void QLinuxWebViewPrivate::registerMessageHandler(const QString &name)
+{
+    if (!m_webview) {
+        return;
+    }
+
+    WebKitUserContentManager *manager =
+            webkit_web_view_get_user_content_manager(static_cast<WebKitWebView *>(m_webview));
+    const QByteArray utf8 = name.toUtf8();
+    if (!webkit_user_content_manager_register_script_message_handler(manager, utf8.constData())) {
+        qWarning() << "Failed to register script message handler" << name;
+        return;
+    }
+
+    // The detailed signal does not pass the handler name back
+    struct Handler
+    {
+        QLinuxWebViewPrivate *view;
+        QString name;
+    };
+    m_messageHandlerIds.insert(
+            name,
+            g_signal_connect_data(
+                    manager, QByteArray("script-message-received::" + utf8).constData(),
+                    G_CALLBACK(+[](WebKitUserContentManager *, WebKitJavascriptResult *result,
+                                   gpointer data) {
+                        JSCValue *value = webkit_javascript_result_get_js_value(result);
+                        if (!jsc_value_is_string(value)) {
+                            return;
+                        }
+                        gchar *message = jsc_value_to_string(value);
+                        const Handler *handler = static_cast<Handler *>(data);
+                        handler->view->dispatchMessage(handler->name, QString::fromUtf8(message));
+                        g_free(message);
+                    }),
+                    new Handler{ this, name },
+                    +[](gpointer data, GClosure *) { delete static_cast<Handler *>(data); },
+                    GConnectFlags(0)));
+}
+
+void QLinuxWebViewPrivate::unregisterMessageHandler(const QString &name)
+{
+    const gulong id = m_messageHandlerIds.take(name);
+    if (!m_webview || !id) {
+        return;
+    }
+
+    WebKitUserContentManager *manager =
+            webkit_web_view_get_user_content_manager(static_cast<WebKitWebView *>(m_webview));
+    g_signal_handler_disconnect(manager, id);
+    webkit_user_content_manager_unregister_script_message_handler(manager,
+                                                                  name.toUtf8().constData());
+}
+
+static QImage imageFromSurface(cairo_surface_t *surface)
+{
+    cairo_surface_t *image = surface;
+    if (cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE
+        || cairo_image_surface_get_format(surface) != CAIRO_FORMAT_ARGB32) {
+        double x1, y1, x2, y2;
+        cairo_t *cr = cairo_create(surface);
+        cairo_clip_extents(cr, &x1, &y1, &x2, &y2);
+        cairo_destroy(cr);
+        image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, int(x2 - x1), int(y2 - y1));
+        cr = cairo_create(image);
+        cairo_set_source_surface(cr, surface, -x1, -y1);
+        cairo_paint(cr);
+        cairo_destroy(cr);
+    } else {
+        cairo_surface_reference(image);
+    }
+    cairo_surface_flush(image);
+
+    // CAIRO_FORMAT_ARGB32 is premultiplied native-endian ARGB, same as Qt's
+    const QImage result = QImage(cairo_image_surface_get_data(image),
+                                 cairo_image_surface_get_width(image),
+                                 cairo_image_surface_get_height(image),
+                                 cairo_image_surface_get_stride(image),
+                                 QImage::Format_ARGB32_Premultiplied)
+                                  .copy();
+    cairo_surface_destroy(image);
+    return result;
+}
+
+void QLinuxWebViewPrivate::setViewportSize(const QSize &size)
+{
+    // Only the offscreen toplevel, the plug follows the QNativeWebView
+    if (m_offscreen) {
+        gtk_widget_set_size_request(GTK_WIDGET(m_webview), size.width(), size.height());
+        gtk_window_resize(GTK_WINDOW(m_offscreen), size.width(), size.height());
+    }
+}
+
+void QLinuxWebViewPrivate::snapshot(const std::function<void(const QImage &)> &callback)
+{
+    if (!m_webview) {
+        callback(QImage());
+        return;
+    }
+    webkit_web_view_get_snapshot(
+            static_cast<WebKitWebView *>(m_webview), WEBKIT_SNAPSHOT_REGION_FULL_DOCUMENT,
+            WEBKIT_SNAPSHOT_OPTIONS_TRANSPARENT_BACKGROUND, nullptr,
+            +[](GObject *object, GAsyncResult *result, gpointer userData) {
+                std::function<void(const QImage &)> *callback =
+                        static_cast<std::function<void(const QImage &)> *>(userData);
+                GError *error = nullptr;
+                cairo_surface_t *surface = webkit_web_view_get_snapshot_finish(
+                        WEBKIT_WEB_VIEW(object), result, &error);
+                QImage image;
+                if (surface) {
+                    image = imageFromSurface(surface);
+                    cairo_surface_destroy(surface);
+                } else {
+                    qWarning() << "Failed to take snapshot:" << (error ? error->message : "");
+                    g_clear_error(&error);
+                }
+                (*callback)(image);
+                delete callback;
+            },
+            new std::function<void(const QImage &)>(callback));
+}
+
+void QLinuxWebViewPrivate::updateIcon()
+{
+    WebKitWebView *webview = static_cast<WebKitWebView *>(m_webview);
+    const QString host = QUrl(QString::fromUtf8(webkit_web_view_get_uri(webview))).host().toLower();
+    QCache<QString, QNativeWebCachedIcon> &icons = QNativeWebProfilePrivate::get(m_profile)->icons;
+    const QNativeWebCachedIcon *cached = icons.object(host);
+    cairo_surface_t *surface = webkit_web_view_get_favicon(webview);
+    if (!surface) {
+        // Show the cached icon of the host until the page's own icon is known
+        setIcon(cached ? cached->icon : QIcon());
+        return;
+    }
+
+    // Hash the pixels first so a host's icon is decoded into a QIcon only once
+    cairo_surface_flush(surface);
+    uint hash = 0;
+    if (cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE) {
+        const int size =
+                cairo_image_surface_get_stride(surface) * cairo_image_surface_get_height(surface);
+        hash = qHash(QByteArray::fromRawData(
+                reinterpret_cast<const char *>(cairo_image_surface_get_data(surface)), size));
+    }
+    if (cached && hash && cached->imageHash == hash) {
+        setIcon(cached->icon);
+        return;
+    }
+
+    QNativeWebCachedIcon *entry = new QNativeWebCachedIcon;
+    entry->icon = QIcon(QPixmap::fromImage(imageFromSurface(surface)));
+    entry->imageHash = hash;
+    setIcon(entry->icon);
+    if (!host.isEmpty()) {
+        icons.insert(host, entry);
+    } else {
+        delete entry;
+    }
 }
 
 void QLinuxWebViewPrivate::updateWindowGeometry()
@@ -153,8 +1108,162 @@ void QLinuxWebViewPrivate::updateWindowGeometry()
     }
 }
 
-void QLinuxWebViewPrivate::initialize()
+void QLinuxWebViewPrivate::onDownloadStarted(void *nativeDownload)
+{
+    WebKitDownload *download = static_cast<WebKitDownload *>(nativeDownload);
+    if (webkit_download_get_web_view(download) != m_webview) {
+        return;
+    }
+
+    if (m_resumingDownload) {
+        attachDownload(m_resumingDownload, download);
+        m_resumingDownload = nullptr;
+        return;
+    }
+
+    WebKitURIRequest *request = webkit_download_get_request(download);
+    const QUrl url(QString::fromUtf8(webkit_uri_request_get_uri(request)));
+    QNativeWebDownload *item = QNativeWebDownloadPrivate::create(url, this);
+    attachDownload(item, download);
+    addDownload(item);
+}
+
+void QLinuxWebViewPrivate::attachDownload(QNativeWebDownload *item, void *nativeDownload)
+{
+    WebKitDownload *download = static_cast<WebKitDownload *>(nativeDownload);
+    QNativeWebDownloadPrivate *d = QNativeWebDownloadPrivate::get(item);
+    if (d->releaseHandler) {
+        d->releaseHandler();
+    }
+
+    g_object_ref(download);
+    QPointer<QLinuxWebViewPrivate> instance = this;
+    d->cancelHandler = [download] { webkit_download_cancel(download); };
+    d->resumeHandler = [instance, item] {
+        if (instance) {
+            instance->resumeDownload(item);
+        }
+    };
+    d->releaseHandler = [download, item] {
+        g_signal_handlers_disconnect_by_data(download, item);
+        g_object_unref(download);
+    };
+
+    // WebKit writes the data straight to the destination file, we only pick the
+    // file and follow the progress
+    g_signal_connect_swapped(
+            download, "decide-destination",
+            G_CALLBACK(+[](QNativeWebDownload *item, gchar *suggestedFileName,
+                           WebKitDownload *download) -> gboolean {
+                QNativeWebDownloadPrivate *d = QNativeWebDownloadPrivate::get(item);
+                // A restarted download keeps its destination and starts over
+                if (!d->destination.isEmpty()) {
+                    QFile::remove(d->destination);
+                } else if (d->owner) {
+                    d->destination = d->owner->downloadDestination(
+                            d->url, QString::fromUtf8(suggestedFileName));
+                }
+                if (d->destination.isEmpty()) {
+                    webkit_download_cancel(download);
+                    return TRUE;
+                }
+                // Fails rather than replacing a file created since the name was chosen
+                const QByteArray uri = QUrl::fromLocalFile(d->destination).toString().toUtf8();
+                webkit_download_set_allow_overwrite(download, FALSE);
+                webkit_download_set_destination(download, uri.constData());
+                return TRUE;
+            }),
+            item);
+
+    g_signal_connect_swapped(
+            download, "received-data",
+            G_CALLBACK(+[](QNativeWebDownload *item, guint64 length, WebKitDownload *download) {
+                WebKitURIResponse *response = webkit_download_get_response(download);
+                const qint64 total =
+                        response ? qint64(webkit_uri_response_get_content_length(response)) : 0;
+                QNativeWebDownloadPrivate::get(item)->updateProgress(
+                        qint64(webkit_download_get_received_data_length(download)),
+                        total > 0 ? total : -1);
+            }),
+            item);
+
+    g_signal_connect_swapped(
+            download, "failed",
+            G_CALLBACK(+[](QNativeWebDownload *item, GError *error, WebKitDownload *download) {
+                QNativeWebDownloadPrivate *d = QNativeWebDownloadPrivate::get(item);
+                if (g_error_matches(error, WEBKIT_DOWNLOAD_ERROR,
+                                    WEBKIT_DOWNLOAD_ERROR_CANCELLED_BY_USER)) {
+                    d->setState(QNativeWebDownload::Cancelled);
+                } else {
+                    d->setState(QNativeWebDownload::Failed, QString::fromUtf8(error->message));
+                }
+            }),
+            item);
+
+    // Also emitted after failed
+    g_signal_connect_swapped(
+            download, "finished",
+            G_CALLBACK(+[](QNativeWebDownload *item, WebKitDownload *download) {
+                QNativeWebDownloadPrivate *d = QNativeWebDownloadPrivate::get(item);
+                if (d->state == QNativeWebDownload::InProgress) {
+                    d->receivedBytes = qint64(webkit_download_get_received_data_length(download));
+                    d->setState(QNativeWebDownload::Completed);
+                }
+            }),
+            item);
+}
+
+void QLinuxWebViewPrivate::resumeDownload(QNativeWebDownload *item)
 {
+    if (!m_webview) {
+        return;
+    }
+
+    // download-started may be emitted from within webkit_web_view_download_uri()
+    m_resumingDownload = item;
+    WebKitDownload *download =
+            webkit_web_view_download_uri(static_cast<WebKitWebView *>(m_webview),
+                                         item->url().toString().toUtf8().constData());
+    if (m_resumingDownload) {
+        attachDownload(item, download);
+        m_resumingDownload = nullptr;
+    }
+    g_object_unref(download);
+}
+
+void QLinuxWebViewPrivate::createNativeWindow()
+{
+    m_widget = gtk_plug_new(0);
+    GtkWidget *widget = (GtkWidget *)m_widget;
+    if (!widget) {
+        qWarning() << "Failed to create plug widget";
+        return;
+    }
+
+    // Move the web view from the offscreen toplevel into the plug,
+    // holding a reference so it survives being removed from its container
+    GtkWidget *webview = GTK_WIDGET(m_webview);
+    g_object_ref(webview);
+    if (m_offscreen) {
+        gtk_container_remove(GTK_CONTAINER(m_offscreen), webview);
+        gtk_widget_destroy((GtkWidget *)m_offscreen);
+        m_offscreen = nullptr;
+    }
+    gtk_container_add(GTK_CONTAINER(widget), webview);
+    g_object_unref(webview);
+
+    gtk_widget_show_all(widget);
+    gtk_widget_realize(widget);
+    void *hWnd = reinterpret_cast<void *>(gtk_plug_get_id(GTK_PLUG(widget)));
+    if (!hWnd) {
+        qWarning() << "Can not get plug widget handle";
+        return;
+    }
+
+    // Create a QWindow without a parent
+    // This window is embedded by QNativeWebView through a window container
+    m_window = QWindow::fromWinId(WId(hWnd));
+    m_window->setFlag(Qt::FramelessWindowHint); // No border
 
     connect(m_window, &QWindow::widthChanged, this, &QLinuxWebViewPrivate::updateWindowGeometry,
             Qt::QueuedConnection);
@@ -167,6 +1276,19 @@ void QLinuxWebViewPrivate::initialize()
                                  qDebug() << "webview container destroy";
                              }),
                              this);
+}
+
+void QLinuxWebViewPrivate::initialize()
+{
+    // downloads, reported by the web context for all of its views
+    g_signal_connect_swapped(
+            webkit_web_view_get_context(static_cast<WebKitWebView *>(m_webview)),
+            "download-started",
+            G_CALLBACK(+[](QLinuxWebViewPrivate *instance, WebKitDownload *download) {
+                instance->onDownloadStarted(download);
+            }),
+            this);
+
     g_signal_connect_swapped(m_webview, "destroy", G_CALLBACK(+[](QLinuxWebViewPrivate *instance) {
                                  qDebug() << "webview destroy";
                              }),
@@ -184,6 +1306,61 @@ void QLinuxWebViewPrivate::initialize()
                              }),
                              this);
 
+    // favicon change, also reset to null when a page from another host starts loading
+    g_signal_connect_swapped(m_webview, "notify::favicon",
+                             G_CALLBACK(+[](QLinuxWebViewPrivate *instance, GParamSpec *pspec) {
+                                 if (instance && instance->m_webview) {
+                                     instance->updateIcon();
+                                 }
+                             }),
+                             this);
+
+    // web process termination, the view stays blank until it is reloaded
+    g_signal_connect_swapped(
+            m_webview, "web-process-terminated",
+            G_CALLBACK(+[](QLinuxWebViewPrivate *instance,
+                           WebKitWebProcessTerminationReason reason) {
+                QNativeWebPage::RenderProcessTerminationReason terminationReason =
+                        QNativeWebPage::RenderProcessCrashed;
+                switch (reason) {
+                case WEBKIT_WEB_PROCESS_EXCEEDED_MEMORY_LIMIT:
+                    terminationReason = QNativeWebPage::RenderProcessExceededMemoryLimit;
+                    break;
+#if WEBKIT_CHECK_VERSION(2, 34, 0)
+                case WEBKIT_WEB_PROCESS_TERMINATED_BY_API:
+                    terminationReason = QNativeWebPage::RenderProcessTerminatedByApi;
+                    break;
+#endif
+                default:
+                    break;
+                }
+                instance->handleRenderProcessTerminated(terminationReason);
+            }),
+            this);
+
+    // navigation policy, decided here before the request is sent
+    g_signal_connect_swapped(
+            m_webview, "decide-policy",
+            G_CALLBACK(+[](QLinuxWebViewPrivate *instance, WebKitPolicyDecision *decision,
+                           WebKitPolicyDecisionType type) -> gboolean {
+                if (type != WEBKIT_POLICY_DECISION_TYPE_NAVIGATION_ACTION
+                    && type != WEBKIT_POLICY_DECISION_TYPE_NEW_WINDOW_ACTION) {
+                    return false;
+                }
+                WebKitNavigationAction *action =
+                        webkit_navigation_policy_decision_get_navigation_action(
+                                WEBKIT_NAVIGATION_POLICY_DECISION(decision));
+                WebKitURIRequest *request = webkit_navigation_action_get_request(action);
+                const QUrl url(QString::fromUtf8(webkit_uri_request_get_uri(request)));
+                if (instance->isNavigationAllowed(url)) {
+                    // WebKit's default handling
+                    return false;
+                }
+                webkit_policy_decision_ignore(decision);
+                return true;
+            }),
+            this);
+
     // title change
     g_signal_connect_swapped(m_webview, "notify::title",
                              G_CALLBACK(+[](QLinuxWebViewPrivate *instance, GParamSpec *pspec) {
@@ -224,8 +1401,8 @@ void QLinuxWebViewPrivate::initialize()
                         emit instance->loadStarted();
                         break;
                     case WEBKIT_LOAD_FINISHED:
-                        instance->m_error = "";
-                        emit instance->loadFinished(true);
+                        // Also emitted after load-failed, which has set m_error
+                        emit instance->loadFinished(instance->m_error.isEmpty());
                         break;
                     default:
                         break;
@@ -241,9 +1418,100 @@ void QLinuxWebViewPrivate::initialize()
                                  qDebug() << "load-failed";
                                  if (instance) {
                                      instance->m_error = error->message;
-                                     emit instance->loadFinished(false);
+                                     emit instance->errorOccurred(instance->m_error);
                                  }
                                  return false;
                              }),
                              this);
 }
+
+bool QLinuxWebViewPrivate::captureResources(bool enabled)
+{
+    if (!m_webview) {
+        return false;
+    }
+    if (!enabled) {
+        if (m_resourceHandlerId) {
+            g_signal_handler_disconnect(m_webview, m_resourceHandlerId);
+            m_resourceHandlerId = 0;
+        }
+        const QList<void *> resources = m_harResources.keys();
+        for (void *resource : resources) {
+            untrackResource(resource);
+        }
+        return true;
+    }
+    if (!m_resourceHandlerId) {
+        m_resourceHandlerId = g_signal_connect_swapped(
+                m_webview, "resource-load-started",
+                G_CALLBACK(+[](QLinuxWebViewPrivate *instance, WebKitWebResource *resource,
+                               WebKitURIRequest *request) {
+                    instance->trackResource(resource, request);
+                }),
+                this);
+    }
+    return true;
+}
+
+void QLinuxWebViewPrivate::trackResource(void *resource, void *request)
+{
+    QLinuxHarResource *tracked = new QLinuxHarResource;
+    tracked->restart(static_cast<WebKitURIRequest *>(request));
+    m_harResources.insert(resource, tracked);
+    g_object_ref(resource);
+
+    // Also sent for the first request, with the headers WebKit added meanwhile
+    g_signal_connect_swapped(
+            resource, "sent-request",
+            G_CALLBACK(+[](QLinuxWebViewPrivate *instance, WebKitURIRequest *request,
+                           WebKitURIResponse *redirectedResponse, WebKitWebResource *resource) {
+                QLinuxHarResource *tracked = instance->m_harResources.value(resource);
+                if (!tracked) {
+                    return;
+                }
+                if (redirectedResponse) {
+                    // Every hop of a redirect is an entry of its own
+                    instance->addHarEntry(tracked->entry(redirectedResponse));
+                    tracked->restart(request);
+                } else {
+                    tracked->request = harRequest(request);
+                }
+            }),
+            this);
+    g_signal_connect_swapped(
+            resource, "notify::response",
+            G_CALLBACK(+[](QLinuxWebViewPrivate *instance, GParamSpec *,
+                           WebKitWebResource *resource) {
+                if (QLinuxHarResource *tracked = instance->m_harResources.value(resource)) {
+                    tracked->wait = tracked->timer.elapsed();
+                }
+            }),
+            this);
+    g_signal_connect_swapped(
+            resource, "failed",
+            G_CALLBACK(+[](QLinuxWebViewPrivate *instance, GError *error,
+                           WebKitWebResource *resource) {
+                if (QLinuxHarResource *tracked = instance->m_harResources.value(resource)) {
+                    tracked->error = QString::fromUtf8(error->message);
+                }
+            }),
+            this);
+    // Emitted after failed too
+    g_signal_connect_swapped(
+            resource, "finished",
+            G_CALLBACK(+[](QLinuxWebViewPrivate *instance, WebKitWebResource *resource) {
+                if (QLinuxHarResource *tracked = instance->m_harResources.value(resource)) {
+                    instance->addHarEntry(
+                            tracked->entry(webkit_web_resource_get_response(resource)));
+                    instance->untrackResource(resource);
+                }
+            }),
+            this);
+}
+
+void QLinuxWebViewPrivate::untrackResource(void *resource)
+{
+    delete m_harResources.take(resource);
+    g_signal_handlers_disconnect_by_data(resource, this);
+    g_object_unref(resource);
+}
@@ -0,0 +1,245 @@
+#include "qnativehtmlrenderer.h"
+
+#include "qnativewebprofile.h"
+#include "private/qnativewebview_p.h"
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+
+#include <climits>
+
+namespace {
+
+// A snippet taking longer is given up, so one bad snippet can not stall the queue
+const int RenderTimeout = 5000;
+
+QByteArray cacheKey(const QString &html, int width)
+{
+    return QCryptographicHash::hash(html.toUtf8(), QCryptographicHash::Md5)
+            + QByteArray::number(width);
+}
+
+QString snippetDocument(const QString &html, const QString &css)
+{
+    return QStringLiteral("<!DOCTYPE html><html><head><meta charset=\"utf-8\">"
+                          "<style>html, body { margin: 0; background: transparent; }</style>"
+                          "<style>%1</style></head><body>%2</body></html>")
+            .arg(css, html);
+}
+
+} // namespace
+
+class QNativeHtmlRendererPrivate
+{
+public:
+    struct Job
+    {
+        QString html;
+        int width = 0;
+        QByteArray key;
+    };
+
+    void next();
+    // Stops the current job; callbacks still arriving for it are ignored
+    void abort();
+    void finish(const QImage &image);
+
+    QNativeHtmlRenderer *q_ptr = nullptr;
+    QNativeWebProfile *profile = nullptr;
+    QNativeWebViewPrivate *page = nullptr;
+    QString styleSheet;
+    // Costs are in KiB
+    QCache<QByteArray, QImage> cache{ 64 * 1024 };
+    QList<Job> queue;
+    QSet<QByteArray> queued;
+    bool rendering = false;
+    Job current;
+    int generation = 0;
+    QTimer timeout;
+    QElapsedTimer renderTimer;
+    QNativeHtmlRendererStatistics statistics;
+    qint64 renderTime = 0;
+};
+
+void QNativeHtmlRendererPrivate::next()
+{
+    if (rendering || queue.isEmpty()) {
+        return;
+    }
+    current = queue.takeFirst();
+    rendering = true;
+    ++generation;
+    renderTimer.start();
+    timeout.start();
+    // One pixel high, the document is as high as its content
+    page->setViewportSize(QSize(current.width, 1));
+    page->setHtml(snippetDocument(current.html, styleSheet));
+}
+
+void QNativeHtmlRendererPrivate::abort()
+{
+    ++generation;
+    rendering = false;
+    timeout.stop();
+    page->stop();
+}
+
+void QNativeHtmlRendererPrivate::finish(const QImage &image)
+{
+    const Job job = current;
+    ++generation;
+    rendering = false;
+    timeout.stop();
+    queued.remove(job.key);
+
+    if (!image.isNull()) {
+        const int cost = qMax(1, int(qint64(image.bytesPerLine()) * image.height() / 1024));
+        cache.insert(job.key, new QImage(image), cost);
+    }
+    ++statistics.rendered;
+    renderTime += renderTimer.nsecsElapsed();
+    emit q_ptr->imageReady(job.html, job.width, image);
+
+    // Not from within the backend's callback
+    QMetaObject::invokeMethod(q_ptr, [this] { next(); }, Qt::QueuedConnection);
+}
+
+QNativeHtmlRenderer::QNativeHtmlRenderer(QObject *parent)
+    : QObject(parent), d_ptr(new QNativeHtmlRendererPrivate)
+{
+    QNativeHtmlRendererPrivate *d = d_ptr;
+    d->q_ptr = this;
+    // No user content of other profiles and nothing written to disk
+    d->profile = new QNativeWebProfile(QNativeWebProfile::EphemeralStorage, this);
+    d->page = QNativeWebViewPrivate::create(d->profile, this);
+
+    d->timeout.setSingleShot(true);
+    d->timeout.setInterval(RenderTimeout);
+    connect(&d->timeout, &QTimer::timeout, this, [d] {
+        d->page->stop();
+        d->finish(QImage());
+    });
+
+    connect(d->page, &QNativeWebViewPrivate::loadFinished, this, [this, d](bool ok) {
+        if (!d->rendering) {
+            return;
+        }
+        if (!ok) {
+            d->finish(QImage());
+            return;
+        }
+        const int generation = d->generation;
+        QPointer<QNativeHtmlRenderer> self = this;
+        d->page->evaluateJavaScript(
+                QStringLiteral("document.documentElement.scrollHeight"),
+                [self, d, generation](const QVariant &result) {
+                    if (!self || generation != d->generation) {
+                        return;
+                    }
+                    const int height = qMax(1, result.toInt());
+                    d->page->snapshot([self, d, generation, height](const QImage &image) {
+                        if (!self || generation != d->generation) {
+                            return;
+                        }
+                        d->finish(image.isNull()
+                                          ? image
+                                          : image.copy(0, 0, d->current.width, height));
+                    });
+                });
+    });
+}
+
+QNativeHtmlRenderer::~QNativeHtmlRenderer()
+{
+    // The page needs its profile while it is destroyed
+    delete d_ptr->page;
+    delete d_ptr;
+}
+
+QImage QNativeHtmlRenderer::image(const QString &html, int width)
+{
+    QNativeHtmlRendererPrivate *d = d_ptr;
+    if (const QImage *cached = d->cache.object(cacheKey(html, width))) {
+        ++d->statistics.cacheHits;
+        return *cached;
+    }
+    ++d->statistics.cacheMisses;
+    render(html, width);
+    return QImage();
+}
+
+bool QNativeHtmlRenderer::contains(const QString &html, int width) const
+{
+    return d_ptr->cache.contains(cacheKey(html, width));
+}
+
+void QNativeHtmlRenderer::render(const QString &html, int width)
+{
+    QNativeHtmlRendererPrivate *d = d_ptr;
+    const QByteArray key = cacheKey(html, width);
+    if (width <= 0 || d->cache.contains(key) || d->queued.contains(key)) {
+        return;
+    }
+    d->queue.append({ html, width, key });
+    d->queued.insert(key);
+    d->next();
+}
+
+QString QNativeHtmlRenderer::styleSheet() const
+{
+    return d_ptr->styleSheet;
+}
+
+void QNativeHtmlRenderer::setStyleSheet(const QString &css)
+{
+    QNativeHtmlRendererPrivate *d = d_ptr;
+    if (css == d->styleSheet) {
+        return;
+    }
+    d->styleSheet = css;
+    d->cache.clear();
+    // The snippet being rendered is laid out again with the new style sheet
+    if (d->rendering) {
+        d->queue.prepend(d->current);
+        d->abort();
+    }
+    d->next();
+}
+
+qint64 QNativeHtmlRenderer::cacheLimit() const
+{
+    return qint64(d_ptr->cache.maxCost()) * 1024;
+}
+
+void QNativeHtmlRenderer::setCacheLimit(qint64 bytes)
+{
+    d_ptr->cache.setMaxCost(int(qBound<qint64>(1, bytes / 1024, INT_MAX)));
+}
+
+void QNativeHtmlRenderer::clearCache()
+{
+    d_ptr->cache.clear();
+}
+
+QNativeHtmlRendererStatistics QNativeHtmlRenderer::statistics() const
+{
+    QNativeHtmlRendererStatistics stats = d_ptr->statistics;
+    if (d_ptr->renderTime > 0) {
+        stats.throughput = stats.rendered * 1e9 / d_ptr->renderTime;
+    }
+    const quint64 lookups = stats.cacheHits + stats.cacheMisses;
+    if (lookups > 0) {
+        stats.hitRate = double(stats.cacheHits) / lookups;
+    }
+    return stats;
+}
+
+void QNativeHtmlRenderer::resetStatistics()
+{
+    d_ptr->statistics = QNativeHtmlRendererStatistics();
+    d_ptr->renderTime = 0;
+}
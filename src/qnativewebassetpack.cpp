@@ -0,0 +1,358 @@
+#include "qnativewebassetpack.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QHash>
+#include <QMimeDatabase>
+#include <QPointer>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const char Magic[8] = { 'Q', 'N', 'W', 'P', 'A', 'C', 'K', '\0' };
+const quint32 Version = 1;
+const qint64 HeaderSize = 32;
+const qint64 EntrySize = 56;
+
+struct Mapping
+{
+    QFile file;
+    uchar *data = nullptr;
+    qint64 size = 0;
+
+    ~Mapping()
+    {
+        if (data) {
+            file.unmap(data);
+        }
+    }
+};
+
+struct IndexEntry
+{
+    quint32 pathOffset;
+    quint32 pathSize;
+    quint32 mimeOffset;
+    quint32 mimeSize;
+    quint64 dataOffset;
+    quint64 storedSize;
+    quint64 originalSize;
+    quint32 flags;
+    quint64 etag;
+};
+
+IndexEntry readEntry(const uchar *p)
+{
+    IndexEntry entry;
+    entry.pathOffset = qFromLittleEndian<quint32>(p);
+    entry.pathSize = qFromLittleEndian<quint32>(p + 4);
+    entry.mimeOffset = qFromLittleEndian<quint32>(p + 8);
+    entry.mimeSize = qFromLittleEndian<quint32>(p + 12);
+    entry.dataOffset = qFromLittleEndian<quint64>(p + 16);
+    entry.storedSize = qFromLittleEndian<quint64>(p + 24);
+    entry.originalSize = qFromLittleEndian<quint64>(p + 32);
+    entry.flags = qFromLittleEndian<quint32>(p + 40);
+    entry.etag = qFromLittleEndian<quint64>(p + 48);
+    return entry;
+}
+
+bool isCompressible(const QByteArray &mimeType)
+{
+    return mimeType.startsWith("text/") || mimeType.contains("javascript")
+            || mimeType.contains("json") || mimeType.contains("xml") || mimeType.contains("svg")
+            || mimeType == "application/wasm";
+}
+
+typedef QHash<QString, QPointer<QNativeWebAssetPack>> PackRegistry;
+Q_GLOBAL_STATIC(PackRegistry, packRegistry)
+
+} // namespace
+
+class QNativeWebAssetPackPrivate
+{
+public:
+    std::shared_ptr<Mapping> mapping;
+    quint32 count = 0;
+    const uchar *index = nullptr;
+    const uchar *strings = nullptr;
+    quint64 stringsSize = 0;
+    QString errorString;
+};
+
+QNativeWebAssetPack::QNativeWebAssetPack(QObject *parent)
+    : QObject(parent), d_ptr(new QNativeWebAssetPackPrivate)
+{
+}
+
+QNativeWebAssetPack::~QNativeWebAssetPack()
+{
+    delete d_ptr;
+}
+
+bool QNativeWebAssetPack::open(const QString &fileName)
+{
+    close();
+
+    std::shared_ptr<Mapping> mapping = std::make_shared<Mapping>();
+    mapping->file.setFileName(fileName);
+    if (!mapping->file.open(QIODevice::ReadOnly)) {
+        d_ptr->errorString = mapping->file.errorString();
+        return false;
+    }
+    mapping->size = mapping->file.size();
+    if (mapping->size < HeaderSize) {
+        d_ptr->errorString = tr("File is too small to be an asset pack");
+        return false;
+    }
+    mapping->data = mapping->file.map(0, mapping->size);
+    if (!mapping->data) {
+        d_ptr->errorString = mapping->file.errorString();
+        return false;
+    }
+
+    const uchar *data = mapping->data;
+    if (std::memcmp(data, Magic, sizeof(Magic)) != 0
+        || qFromLittleEndian<quint32>(data + 8) != Version) {
+        d_ptr->errorString = tr("Not an asset pack or unsupported version");
+        return false;
+    }
+    const quint32 count = qFromLittleEndian<quint32>(data + 12);
+    const quint64 stringsOffset = qFromLittleEndian<quint64>(data + 16);
+    const quint64 stringsSize = qFromLittleEndian<quint64>(data + 24);
+    const quint64 fileSize = quint64(mapping->size);
+    if (HeaderSize + quint64(count) * EntrySize > fileSize || stringsOffset > fileSize
+        || stringsSize > fileSize - stringsOffset) {
+        d_ptr->errorString = tr("Corrupt asset pack header");
+        return false;
+    }
+
+    // Validate every entry once so lookups never need bounds checks
+    for (quint32 i = 0; i < count; ++i) {
+        const IndexEntry entry = readEntry(data + HeaderSize + i * EntrySize);
+        if (quint64(entry.pathOffset) + entry.pathSize > stringsSize
+            || quint64(entry.mimeOffset) + entry.mimeSize > stringsSize
+            || entry.dataOffset > fileSize || entry.storedSize > fileSize - entry.dataOffset) {
+            d_ptr->errorString = tr("Corrupt asset pack entry %1").arg(i);
+            return false;
+        }
+    }
+
+    d_ptr->mapping = mapping;
+    d_ptr->count = count;
+    d_ptr->index = data + HeaderSize;
+    d_ptr->strings = data + stringsOffset;
+    d_ptr->stringsSize = stringsSize;
+    d_ptr->errorString.clear();
+    return true;
+}
+
+void QNativeWebAssetPack::close()
+{
+    // Assets still in use keep the mapping alive through their storage
+    d_ptr->mapping.reset();
+    d_ptr->count = 0;
+    d_ptr->index = nullptr;
+    d_ptr->strings = nullptr;
+    d_ptr->stringsSize = 0;
+}
+
+bool QNativeWebAssetPack::isOpen() const
+{
+    return d_ptr->mapping != nullptr;
+}
+
+QString QNativeWebAssetPack::errorString() const
+{
+    return d_ptr->errorString;
+}
+
+int QNativeWebAssetPack::count() const
+{
+    return int(d_ptr->count);
+}
+
+QNativeWebAssetPack::Asset QNativeWebAssetPack::find(const QString &path) const
+{
+    Asset asset;
+    if (!d_ptr->mapping) {
+        return asset;
+    }
+
+    const QByteArray key = path.toUtf8();
+    quint32 low = 0;
+    quint32 high = d_ptr->count;
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        const IndexEntry entry = readEntry(d_ptr->index + middle * EntrySize);
+        const quint32 common = qMin<quint32>(entry.pathSize, quint32(key.size()));
+        int cmp = std::memcmp(d_ptr->strings + entry.pathOffset, key.constData(), common);
+        if (cmp == 0) {
+            cmp = entry.pathSize < quint32(key.size())
+                    ? -1
+                    : (entry.pathSize > quint32(key.size()) ? 1 : 0);
+        }
+        if (cmp < 0) {
+            low = middle + 1;
+        } else if (cmp > 0) {
+            high = middle;
+        } else {
+            asset.data = d_ptr->mapping->data + entry.dataOffset;
+            asset.size = qint64(entry.storedSize);
+            asset.originalSize = qint64(entry.originalSize);
+            asset.compressed = entry.flags & Compressed;
+            asset.mimeType = QByteArray(
+                    reinterpret_cast<const char *>(d_ptr->strings + entry.mimeOffset),
+                    int(entry.mimeSize));
+            asset.etag = '"' + QByteArray::number(entry.etag, 16).rightJustified(16, '0') + '"';
+            asset.storage = d_ptr->mapping;
+            return asset;
+        }
+    }
+    return asset;
+}
+
+bool QNativeWebAssetPack::build(const QString &sourceDirectory, const QString &packFileName,
+                                QString *errorString)
+{
+    struct Item
+    {
+        QByteArray path;
+        QByteArray mimeType;
+        QByteArray data;
+        quint64 originalSize;
+        quint64 etag;
+        bool compressed;
+    };
+
+    const QDir root(sourceDirectory);
+    if (!root.exists()) {
+        if (errorString) {
+            *errorString = tr("Directory %1 does not exist").arg(sourceDirectory);
+        }
+        return false;
+    }
+
+    QMimeDatabase mimeDatabase;
+    std::vector<Item> items;
+    QDirIterator it(root.absolutePath(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString filePath = it.next();
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            if (errorString) {
+                *errorString = file.errorString();
+            }
+            return false;
+        }
+
+        Item item;
+        item.path = root.relativeFilePath(filePath).toUtf8();
+        item.mimeType = mimeDatabase.mimeTypeForFile(filePath, QMimeDatabase::MatchExtension)
+                                .name()
+                                .toUtf8();
+        item.data = file.readAll();
+        item.originalSize = quint64(item.data.size());
+        item.etag = qFromBigEndian<quint64>(
+                QCryptographicHash::hash(item.data, QCryptographicHash::Sha1).constData());
+        item.compressed = false;
+        if (isCompressible(item.mimeType)) {
+            // qCompress() prefixes the zlib stream with a 4-byte length
+            const QByteArray compressed = qCompress(item.data, 9).mid(4);
+            if (compressed.size() < item.data.size() * 9 / 10) {
+                item.data = compressed;
+                item.compressed = true;
+            }
+        }
+        items.push_back(item);
+    }
+    std::sort(items.begin(), items.end(),
+              [](const Item &a, const Item &b) { return a.path < b.path; });
+
+    const quint64 count = items.size();
+    QByteArray index(int(count * EntrySize), '\0');
+    QByteArray strings;
+    const quint64 stringsOffset = HeaderSize + count * EntrySize;
+    for (const Item &item : items) {
+        strings += item.path;
+        strings += item.mimeType;
+    }
+    quint64 dataOffset = (stringsOffset + strings.size() + 7) & ~quint64(7);
+    const quint64 dataStart = dataOffset;
+
+    quint32 stringOffset = 0;
+    for (quint64 i = 0; i < count; ++i) {
+        const Item &item = items[i];
+        uchar *p = reinterpret_cast<uchar *>(index.data()) + i * EntrySize;
+        qToLittleEndian<quint32>(stringOffset, p);
+        qToLittleEndian<quint32>(quint32(item.path.size()), p + 4);
+        stringOffset += item.path.size();
+        qToLittleEndian<quint32>(stringOffset, p + 8);
+        qToLittleEndian<quint32>(quint32(item.mimeType.size()), p + 12);
+        stringOffset += item.mimeType.size();
+        qToLittleEndian<quint64>(dataOffset, p + 16);
+        qToLittleEndian<quint64>(quint64(item.data.size()), p + 24);
+        qToLittleEndian<quint64>(item.originalSize, p + 32);
+        qToLittleEndian<quint32>(item.compressed ? Compressed : 0, p + 40);
+        qToLittleEndian<quint32>(0, p + 44);
+        qToLittleEndian<quint64>(item.etag, p + 48);
+        dataOffset = (dataOffset + item.data.size() + 7) & ~quint64(7);
+    }
+
+    uchar header[HeaderSize];
+    std::memcpy(header, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(Version, header + 8);
+    qToLittleEndian<quint32>(quint32(count), header + 12);
+    qToLittleEndian<quint64>(stringsOffset, header + 16);
+    qToLittleEndian<quint64>(quint64(strings.size()), header + 24);
+
+    QSaveFile out(packFileName);
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (errorString) {
+            *errorString = out.errorString();
+        }
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(header), HeaderSize);
+    out.write(index);
+    out.write(strings);
+    out.write(QByteArray(int(dataStart - stringsOffset - strings.size()), '\0'));
+    for (const Item &item : items) {
+        out.write(item.data);
+        const int padding = int(((item.data.size() + 7) & ~7) - item.data.size());
+        out.write(QByteArray(padding, '\0'));
+    }
+    if (!out.commit()) {
+        if (errorString) {
+            *errorString = out.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+QString QNativeWebAssetPack::scheme()
+{
+    return QStringLiteral("app");
+}
+
+void QNativeWebAssetPack::install(const QString &host, QNativeWebAssetPack *pack)
+{
+    packRegistry()->insert(host.toLower(), pack);
+}
+
+void QNativeWebAssetPack::uninstall(const QString &host)
+{
+    packRegistry()->remove(host.toLower());
+}
+
+QNativeWebAssetPack *QNativeWebAssetPack::installed(const QString &host)
+{
+    return packRegistry()->value(host.toLower());
+}
@@ -0,0 +1,866 @@
+#include "qnativewebbridge.h"
+
+#include "private/qnativewebview_p.h"
+
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QDebug>
+#include <QMetaMethod>
+#include <QMetaProperty>
+#include <QPair>
+#include <QSet>
+#include <QTimer>
+
+namespace {
+
+const char HandlerName[] = "qnativewebbridge";
+
+// First element of every message from the page
+enum PageMessage { InitMessage, InvokeMessage, SetPropertyMessage, ConnectMessage,
+                   DisconnectMessage };
+// First element of every message to the page
+enum NativeMessage { ObjectsMessage, ResponseMessage, SignalMessage, PropertiesMessage };
+
+// Batches from native code larger than this go through postData(), smaller ones
+// cost less as the argument of a script
+const int PostDataBatchSize = 64 * 1024;
+
+// Batches are CBOR arrays of messages. The page posts them as strings with one
+// character per byte. It receives them as [document, sequence number, messages],
+// base64 encoded in a script or as the bytes of a postData() transfer, and
+// handles them in order whichever way they came. The document is the random id
+// the page sent with its init message; batches for an earlier one are dropped.
+// The message numbers are filled in from the PageMessage and NativeMessage enums.
+const char BridgeScript[] = R"JS((function() {
+    'use strict';
+    var handlers = window.webkit && window.webkit.messageHandlers;
+    var handler = handlers && handlers.qnativewebbridge;
+    if (!handler || window.qnativewebbridge) {
+        return;
+    }
+
+    var InitMessage = %1, InvokeMessage = %2, SetPropertyMessage = %3,
+        ConnectMessage = %4, DisconnectMessage = %5;
+    var ObjectsMessage = %6, ResponseMessage = %7, SignalMessage = %8,
+        PropertiesMessage = %9;
+
+    // The CBOR subset QCborValue writes: definite lengths and doubles
+    var utf8Encoder = new TextEncoder();
+    var utf8Decoder = new TextDecoder();
+
+    function Writer() {
+        this.bytes = new Uint8Array(256);
+        this.length = 0;
+    }
+    Writer.prototype.reserve = function(size) {
+        if (this.length + size > this.bytes.length) {
+            var bytes = new Uint8Array(Math.max(this.bytes.length * 2, this.length + size));
+            bytes.set(this.bytes.subarray(0, this.length));
+            this.bytes = bytes;
+        }
+    };
+    Writer.prototype.byte = function(value) {
+        this.reserve(1);
+        this.bytes[this.length++] = value;
+    };
+    Writer.prototype.raw = function(bytes) {
+        this.reserve(bytes.length);
+        this.bytes.set(bytes, this.length);
+        this.length += bytes.length;
+    };
+    Writer.prototype.head = function(major, value) {
+        major <<= 5;
+        if (value < 24) {
+            this.byte(major | value);
+        } else if (value < 0x100) {
+            this.byte(major | 24);
+            this.byte(value);
+        } else if (value < 0x10000) {
+            this.byte(major | 25);
+            this.byte(value >> 8);
+            this.byte(value & 0xff);
+        } else {
+            var wide = value >= 0x100000000;
+            this.byte(major | (wide ? 27 : 26));
+            this.reserve(8);
+            var view = new DataView(this.bytes.buffer);
+            if (wide) {
+                view.setUint32(this.length, Math.floor(value / 0x100000000));
+                this.length += 4;
+            }
+            view.setUint32(this.length, value >>> 0);
+            this.length += 4;
+        }
+    };
+    Writer.prototype.value = function(value) {
+        var i;
+        if (value === undefined) {
+            this.byte(0xf7);
+        } else if (value === null) {
+            this.byte(0xf6);
+        } else if (typeof value === 'boolean') {
+            this.byte(value ? 0xf5 : 0xf4);
+        } else if (typeof value === 'number') {
+            if (Number.isSafeInteger(value)) {
+                this.head(value < 0 ? 1 : 0, value < 0 ? -1 - value : value);
+            } else {
+                this.byte(0xfb);
+                this.reserve(8);
+                new DataView(this.bytes.buffer).setFloat64(this.length, value);
+                this.length += 8;
+            }
+        } else if (typeof value === 'string') {
+            var utf8 = utf8Encoder.encode(value);
+            this.head(3, utf8.length);
+            this.raw(utf8);
+        } else if (value instanceof ArrayBuffer || ArrayBuffer.isView(value)) {
+            var bytes = value instanceof ArrayBuffer
+                    ? new Uint8Array(value)
+                    : new Uint8Array(value.buffer, value.byteOffset, value.byteLength);
+            this.head(2, bytes.length);
+            this.raw(bytes);
+        } else if (Array.isArray(value)) {
+            this.head(4, value.length);
+            for (i = 0; i < value.length; ++i) {
+                this.value(value[i]);
+            }
+        } else if (typeof value === 'object') {
+            var keys = Object.keys(value);
+            this.head(5, keys.length);
+            for (i = 0; i < keys.length; ++i) {
+                this.value(keys[i]);
+                this.value(value[keys[i]]);
+            }
+        } else {
+            this.byte(0xf7);
+        }
+    };
+
+    function decode(bytes) {
+        var view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+        var offset = 0;
+        function argument(info) {
+            var value = info;
+            if (info === 24) {
+                value = bytes[offset];
+                offset += 1;
+            } else if (info === 25) {
+                value = view.getUint16(offset);
+                offset += 2;
+            } else if (info === 26) {
+                value = view.getUint32(offset);
+                offset += 4;
+            } else if (info === 27) {
+                value = view.getUint32(offset) * 0x100000000 + view.getUint32(offset + 4);
+                offset += 8;
+            }
+            return value;
+        }
+        function item() {
+            var initial = bytes[offset++];
+            var major = initial >> 5;
+            var value, i;
+            if (major === 7) {
+                switch (initial & 0x1f) {
+                case 20: return false;
+                case 21: return true;
+                case 22: return null;
+                case 26: value = view.getFloat32(offset); offset += 4; return value;
+                case 27: value = view.getFloat64(offset); offset += 8; return value;
+                }
+                return undefined;
+            }
+            var length = argument(initial & 0x1f);
+            switch (major) {
+            case 0:
+                return length;
+            case 1:
+                return -1 - length;
+            case 2:
+                value = bytes.slice(offset, offset + length);
+                offset += length;
+                return value;
+            case 3:
+                value = utf8Decoder.decode(bytes.subarray(offset, offset + length));
+                offset += length;
+                return value;
+            case 4:
+                value = new Array(length);
+                for (i = 0; i < length; ++i) {
+                    value[i] = item();
+                }
+                return value;
+            case 5:
+                value = {};
+                for (i = 0; i < length; ++i) {
+                    var key = item();
+                    value[key] = item();
+                }
+                return value;
+            }
+            // Tags, such as date times, decode as their content
+            return item();
+        }
+        return item();
+    }
+
+    var queue = [];
+    function flush() {
+        var writer = new Writer();
+        writer.value(queue);
+        queue = [];
+        var chunks = [];
+        for (var i = 0; i < writer.length; i += 0x2000) {
+            chunks.push(String.fromCharCode.apply(
+                    null, writer.bytes.subarray(i, Math.min(i + 0x2000, writer.length))));
+        }
+        handler.postMessage(chunks.join(''));
+    }
+    function send(message) {
+        // Everything sent during this turn of the event loop goes in one batch
+        if (!queue.length) {
+            Promise.resolve().then(flush);
+        }
+        queue.push(message);
+    }
+
+    var objects = {};
+    var calls = {};
+    var nextCall = 0;
+    var resolveReady;
+
+    function QtObject(name, description) {
+        var object = this;
+        var values = {};
+        var listeners = {};
+        Object.defineProperty(this, '__values', { value: values });
+        Object.defineProperty(this, '__listeners', { value: listeners });
+        description.methods.forEach(function(method) {
+            object[method[0]] = function() {
+                var args = Array.prototype.slice.call(arguments);
+                return new Promise(function(resolve, reject) {
+                    var id = nextCall++;
+                    calls[id] = [resolve, reject];
+                    send([InvokeMessage, id, name, method[1], args]);
+                });
+            };
+        });
+        description.signals.forEach(function(signal) {
+            var index = signal[1];
+            object[signal[0]] = {
+                connect: function(callback) {
+                    var list = listeners[index] = listeners[index] || [];
+                    if (!list.length) {
+                        send([ConnectMessage, name, index]);
+                    }
+                    list.push(callback);
+                },
+                disconnect: function(callback) {
+                    var list = listeners[index] || [];
+                    var position = list.indexOf(callback);
+                    if (position >= 0) {
+                        list.splice(position, 1);
+                        if (!list.length) {
+                            send([DisconnectMessage, name, index]);
+                        }
+                    }
+                }
+            };
+        });
+        description.properties.forEach(function(property) {
+            var index = property[1];
+            values[index] = property[2];
+            Object.defineProperty(object, property[0], {
+                enumerable: true,
+                get: function() { return values[index]; },
+                set: function(value) {
+                    values[index] = value;
+                    send([SetPropertyMessage, name, index, value]);
+                }
+            });
+        });
+    }
+
+    var documentId = Math.random().toString(36).slice(2);
+    // Batches that arrived ahead of an earlier one, by sequence number
+    var nextBatch = 0;
+    var early = {};
+
+    function receiveBytes(bytes) {
+        var batch = decode(bytes);
+        if (batch[0] !== documentId) {
+            return;
+        }
+        early[batch[1]] = batch[2];
+        while (early.hasOwnProperty(nextBatch)) {
+            var messages = early[nextBatch];
+            delete early[nextBatch++];
+            messages.forEach(handle);
+        }
+    }
+
+    function receive(data) {
+        var binary = atob(data);
+        var bytes = new Uint8Array(binary.length);
+        for (var i = 0; i < binary.length; ++i) {
+            bytes[i] = binary.charCodeAt(i);
+        }
+        receiveBytes(bytes);
+    }
+
+    // qnativewebdata may be defined by a script that runs after this one
+    function listen() {
+        window.qnativewebdata.addListener('qnativewebbridge', function(buffer) {
+            receiveBytes(new Uint8Array(buffer));
+        });
+    }
+    if (window.qnativewebdata) {
+        listen();
+    } else {
+        window.addEventListener('qnativewebdata', listen, { once: true });
+    }
+
+    function handle(message) {
+        var object, call, list;
+        switch (message[0]) {
+        case ObjectsMessage:
+            Object.keys(message[1]).forEach(function(name) {
+                objects[name] = new QtObject(name, message[1][name]);
+            });
+            resolveReady(objects);
+            break;
+        case ResponseMessage:
+            call = calls[message[1]];
+            delete calls[message[1]];
+            if (call && message.length > 3) {
+                call[1](new Error(message[3]));
+            } else if (call) {
+                call[0](message[2]);
+            }
+            break;
+        case SignalMessage:
+            object = objects[message[1]];
+            list = object && object.__listeners[message[2]];
+            if (list) {
+                list.slice().forEach(function(callback) {
+                    callback.apply(object, message[3]);
+                });
+            }
+            break;
+        case PropertiesMessage:
+            object = objects[message[1]];
+            if (object) {
+                Object.keys(message[2]).forEach(function(index) {
+                    object.__values[index] = message[2][index];
+                });
+            }
+            break;
+        }
+    }
+
+    window.qnativewebbridge = {
+        objects: objects,
+        ready: new Promise(function(resolve) { resolveReady = resolve; }),
+        __receive: receive
+    };
+    send([InitMessage, documentId]);
+})();
+)JS";
+
+QString bridgeScript()
+{
+    return QString::fromUtf8(BridgeScript)
+            .arg(InitMessage)
+            .arg(InvokeMessage)
+            .arg(SetPropertyMessage)
+            .arg(ConnectMessage)
+            .arg(DisconnectMessage)
+            .arg(ObjectsMessage)
+            .arg(ResponseMessage)
+            .arg(SignalMessage)
+            .arg(PropertiesMessage);
+}
+
+QVariant convertTo(const QVariant &value, int type)
+{
+    if (type == QMetaType::QVariant) {
+        return value;
+    }
+    QVariant result = value;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    if (!result.convert(QMetaType(type))) {
+        result = QVariant(QMetaType(type));
+    }
+#else
+    if (!result.convert(type)) {
+        result = QVariant(type, nullptr);
+    }
+#endif
+    return result;
+}
+
+QVariant fromArgument(int type, const void *argument)
+{
+    if (type == QMetaType::QVariant) {
+        return *static_cast<const QVariant *>(argument);
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return QVariant(QMetaType(type), argument);
+#else
+    return QVariant(type, argument);
+#endif
+}
+
+} // namespace
+
+// Receives every signal the bridge listens to. QObject::connect() needs a slot
+// with matching arguments, so the handler implements qt_metacall() itself and
+// reads the arguments through the signal's QMetaMethod.
+class QNativeWebBridgeSignalHandler : public QObject
+{
+public:
+    explicit QNativeWebBridgeSignalHandler(QNativeWebBridgePrivate *bridge) : m_bridge(bridge) { }
+
+    void connectSignal(QObject *object, int signalIndex)
+    {
+        QMetaObject::connect(object, signalIndex, this, QObject::staticMetaObject.methodCount(),
+                             Qt::DirectConnection);
+    }
+    void disconnectSignal(QObject *object, int signalIndex)
+    {
+        QMetaObject::disconnect(object, signalIndex, this,
+                                QObject::staticMetaObject.methodCount());
+    }
+
+    int qt_metacall(QMetaObject::Call call, int id, void **arguments) override;
+
+private:
+    QNativeWebBridgePrivate *m_bridge;
+};
+
+class QNativeWebBridgePrivate
+{
+public:
+    struct Object
+    {
+        QObject *object = nullptr;
+        // Property indexes by notify signal index
+        QHash<int, QList<int>> notifiedProperties;
+        QSet<int> changedProperties;
+        // Pages with listeners, by signal index
+        QHash<int, QSet<QNativeWebViewPrivate *>> subscribers;
+    };
+
+    QCborMap describe(const QObject *object) const;
+    void receive(QNativeWebViewPrivate *page, const QString &message);
+    QCborValue invoke(QObject *object, int methodIndex, const QCborArray &arguments,
+                      QString *error) const;
+    void subscribe(QNativeWebViewPrivate *page, const QString &name, int signalIndex);
+    void unsubscribe(QNativeWebViewPrivate *page, const QString &name, int signalIndex);
+    void unsubscribeAll(QNativeWebViewPrivate *page);
+    void signalEmitted(QObject *sender, int signalIndex, void **arguments);
+    void post(QNativeWebViewPrivate *page, const QCborValue &message);
+    void scheduleFlush();
+    void flush();
+
+    QHash<QString, Object> objects;
+    QHash<QObject *, QString> names;
+    QList<QNativeWebViewPrivate *> pages;
+    QHash<QNativeWebViewPrivate *, QCborArray> outgoing;
+    // Document of each page and the number of its next batch
+    QHash<QNativeWebViewPrivate *, QPair<QString, qint64>> sequences;
+    QNativeWebBridgeSignalHandler signalHandler{ this };
+    bool flushScheduled = false;
+};
+
+int QNativeWebBridgeSignalHandler::qt_metacall(QMetaObject::Call call, int id, void **arguments)
+{
+    id = QObject::qt_metacall(call, id, arguments);
+    if (id < 0) {
+        return id;
+    }
+    if (call == QMetaObject::InvokeMetaMethod) {
+        if (id == 0) {
+            m_bridge->signalEmitted(sender(), senderSignalIndex(), arguments);
+        }
+        --id;
+    }
+    return id;
+}
+
+QCborMap QNativeWebBridgePrivate::describe(const QObject *object) const
+{
+    const QMetaObject *metaObject = object->metaObject();
+    QCborArray methods;
+    QCborArray signalList;
+    QSet<QByteArray> methodNames;
+    QSet<QByteArray> signalNames;
+    // Overloads share a stub, the first one declared is called; with default
+    // arguments that is the one taking all of them
+    for (int i = QObject::staticMetaObject.methodCount(); i < metaObject->methodCount(); ++i) {
+        const QMetaMethod method = metaObject->method(i);
+        const QByteArray name = method.name();
+        if (method.methodType() == QMetaMethod::Signal) {
+            if (!signalNames.contains(name)) {
+                signalNames.insert(name);
+                signalList.append(QCborArray{ QString::fromLatin1(name), i });
+            }
+        } else if (method.access() == QMetaMethod::Public
+                   && method.methodType() != QMetaMethod::Constructor
+                   && !methodNames.contains(name)) {
+            methodNames.insert(name);
+            methods.append(QCborArray{ QString::fromLatin1(name), i });
+        }
+    }
+
+    QCborArray properties;
+    for (int i = 0; i < metaObject->propertyCount(); ++i) {
+        const QMetaProperty property = metaObject->property(i);
+        properties.append(QCborArray{ QString::fromLatin1(property.name()), i,
+                                      QCborValue::fromVariant(property.read(object)) });
+    }
+
+    QCborMap description;
+    description.insert(QStringLiteral("methods"), methods);
+    description.insert(QStringLiteral("signals"), signalList);
+    description.insert(QStringLiteral("properties"), properties);
+    return description;
+}
+
+void QNativeWebBridgePrivate::receive(QNativeWebViewPrivate *page, const QString &message)
+{
+    // One character per byte
+    const QCborArray batch = QCborValue::fromCbor(message.toLatin1()).toArray();
+    for (const QCborValue &value : batch) {
+        const QCborArray request = value.toArray();
+        switch (request.at(0).toInteger()) {
+        case InitMessage: {
+            // A new document, the listeners of the previous one are gone
+            unsubscribeAll(page);
+            outgoing.remove(page);
+            sequences[page] = qMakePair(request.at(1).toString(), qint64(0));
+            QCborMap descriptions;
+            for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+                descriptions.insert(it.key(), describe(it->object));
+            }
+            post(page, QCborArray{ ObjectsMessage, descriptions });
+            break;
+        }
+        case InvokeMessage: {
+            QString error;
+            QCborValue result;
+            QObject *object = objects.value(request.at(2).toString()).object;
+            if (object) {
+                result = invoke(object, int(request.at(3).toInteger()), request.at(4).toArray(),
+                                &error);
+            } else {
+                error = QStringLiteral("No object named %1").arg(request.at(2).toString());
+            }
+            QCborArray response{ ResponseMessage, request.at(1), result };
+            if (!error.isEmpty()) {
+                response.append(error);
+            }
+            post(page, response);
+            break;
+        }
+        case SetPropertyMessage: {
+            QObject *object = objects.value(request.at(1).toString()).object;
+            const int index = int(request.at(2).toInteger());
+            if (object && index >= 0 && index < object->metaObject()->propertyCount()) {
+                const QMetaProperty property = object->metaObject()->property(index);
+                if (property.isWritable()) {
+                    property.write(object,
+                                   convertTo(request.at(3).toVariant(), property.userType()));
+                }
+            }
+            break;
+        }
+        case ConnectMessage:
+            subscribe(page, request.at(1).toString(), int(request.at(2).toInteger()));
+            break;
+        case DisconnectMessage:
+            unsubscribe(page, request.at(1).toString(), int(request.at(2).toInteger()));
+            break;
+        }
+    }
+}
+
+QCborValue QNativeWebBridgePrivate::invoke(QObject *object, int methodIndex,
+                                           const QCborArray &arguments, QString *error) const
+{
+    const QMetaMethod method = object->metaObject()->method(methodIndex);
+    if (methodIndex < QObject::staticMetaObject.methodCount() || !method.isValid()
+        || method.methodType() == QMetaMethod::Signal
+        || method.access() != QMetaMethod::Public) {
+        *error = QStringLiteral("No such method");
+        return QCborValue();
+    }
+    // The limit of QMetaMethod::invoke()
+    if (method.parameterCount() > 10) {
+        *error = QStringLiteral("Too many parameters");
+        return QCborValue();
+    }
+
+    const QList<QByteArray> types = method.parameterTypes();
+    QVariant values[10];
+    QGenericArgument parameters[10];
+    for (int i = 0; i < method.parameterCount(); ++i) {
+        const int type = method.parameterType(i);
+        if (type == QMetaType::UnknownType) {
+            *error = QStringLiteral("Unsupported parameter type %1")
+                             .arg(QString::fromLatin1(types.at(i)));
+            return QCborValue();
+        }
+        // Missing arguments are default constructed
+        values[i] = convertTo(arguments.at(i).toVariant(), type);
+        parameters[i] = QGenericArgument(types.at(i).constData(),
+                                         type == QMetaType::QVariant
+                                                 ? static_cast<const void *>(&values[i])
+                                                 : values[i].constData());
+    }
+
+    QVariant result;
+    QGenericReturnArgument returnArgument;
+    const int returnType = method.returnType();
+    if (returnType == QMetaType::QVariant) {
+        returnArgument = QGenericReturnArgument(method.typeName(), &result);
+    } else if (returnType != QMetaType::Void && returnType != QMetaType::UnknownType) {
+        result = convertTo(QVariant(), returnType);
+        returnArgument = QGenericReturnArgument(method.typeName(), result.data());
+    }
+    if (!method.invoke(object, Qt::DirectConnection, returnArgument, parameters[0], parameters[1],
+                       parameters[2], parameters[3], parameters[4], parameters[5], parameters[6],
+                       parameters[7], parameters[8], parameters[9])) {
+        *error = QStringLiteral("Failed to invoke %1")
+                         .arg(QString::fromLatin1(method.methodSignature()));
+        return QCborValue();
+    }
+    return QCborValue::fromVariant(result);
+}
+
+void QNativeWebBridgePrivate::subscribe(QNativeWebViewPrivate *page, const QString &name,
+                                        int signalIndex)
+{
+    auto it = objects.find(name);
+    if (it == objects.end() || signalIndex < 0
+        || signalIndex >= it->object->metaObject()->methodCount()
+        || it->object->metaObject()->method(signalIndex).methodType() != QMetaMethod::Signal) {
+        return;
+    }
+    QSet<QNativeWebViewPrivate *> &pages = it->subscribers[signalIndex];
+    // Notify signals are always connected
+    if (pages.isEmpty() && !it->notifiedProperties.contains(signalIndex)) {
+        signalHandler.connectSignal(it->object, signalIndex);
+    }
+    pages.insert(page);
+}
+
+void QNativeWebBridgePrivate::unsubscribe(QNativeWebViewPrivate *page, const QString &name,
+                                          int signalIndex)
+{
+    auto it = objects.find(name);
+    if (it == objects.end() || !it->subscribers.contains(signalIndex)) {
+        return;
+    }
+    QSet<QNativeWebViewPrivate *> &pages = it->subscribers[signalIndex];
+    pages.remove(page);
+    if (pages.isEmpty()) {
+        it->subscribers.remove(signalIndex);
+        if (!it->notifiedProperties.contains(signalIndex)) {
+            signalHandler.disconnectSignal(it->object, signalIndex);
+        }
+    }
+}
+
+void QNativeWebBridgePrivate::unsubscribeAll(QNativeWebViewPrivate *page)
+{
+    for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+        const QList<int> signalIndexes = it->subscribers.keys();
+        for (const int signalIndex : signalIndexes) {
+            unsubscribe(page, it.key(), signalIndex);
+        }
+    }
+}
+
+void QNativeWebBridgePrivate::signalEmitted(QObject *sender, int signalIndex, void **arguments)
+{
+    auto it = objects.find(names.value(sender));
+    if (it == objects.end()) {
+        return;
+    }
+
+    // Property values are read when the batch is sent
+    const QList<int> properties = it->notifiedProperties.value(signalIndex);
+    for (const int index : properties) {
+        it->changedProperties.insert(index);
+    }
+
+    const QSet<QNativeWebViewPrivate *> subscribers = it->subscribers.value(signalIndex);
+    if (!subscribers.isEmpty()) {
+        const QMetaMethod signal = sender->metaObject()->method(signalIndex);
+        QCborArray values;
+        for (int i = 0; i < signal.parameterCount(); ++i) {
+            values.append(QCborValue::fromVariant(
+                    fromArgument(signal.parameterType(i), arguments[i + 1])));
+        }
+        const QCborArray message{ SignalMessage, it.key(), signalIndex, values };
+        for (QNativeWebViewPrivate *page : subscribers) {
+            outgoing[page].append(message);
+        }
+    }
+    if (!properties.isEmpty() || !subscribers.isEmpty()) {
+        scheduleFlush();
+    }
+}
+
+void QNativeWebBridgePrivate::post(QNativeWebViewPrivate *page, const QCborValue &message)
+{
+    outgoing[page].append(message);
+    scheduleFlush();
+}
+
+void QNativeWebBridgePrivate::scheduleFlush()
+{
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QTimer::singleShot(0, &signalHandler, [this] { flush(); });
+    }
+}
+
+void QNativeWebBridgePrivate::flush()
+{
+    flushScheduled = false;
+
+    // Every page gets the final value of each property changed during the turn
+    for (auto it = objects.begin(); it != objects.end(); ++it) {
+        if (it->changedProperties.isEmpty()) {
+            continue;
+        }
+        const QMetaObject *metaObject = it->object->metaObject();
+        QCborMap values;
+        for (const int index : qAsConst(it->changedProperties)) {
+            values.insert(index,
+                          QCborValue::fromVariant(metaObject->property(index).read(it->object)));
+        }
+        it->changedProperties.clear();
+        const QCborArray message{ PropertiesMessage, it.key(), values };
+        for (QNativeWebViewPrivate *page : qAsConst(pages)) {
+            outgoing[page].append(message);
+        }
+    }
+
+    const QHash<QNativeWebViewPrivate *, QCborArray> batches = outgoing;
+    outgoing.clear();
+    for (auto it = batches.cbegin(); it != batches.cend(); ++it) {
+        if (!pages.contains(it.key())) {
+            continue;
+        }
+        QPair<QString, qint64> &sequence = sequences[it.key()];
+        const QByteArray batch =
+                QCborValue(QCborArray{ sequence.first, sequence.second++, it.value() })
+                        .toCbor();
+        if (batch.size() > PostDataBatchSize) {
+            it.key()->postData(QLatin1String(HandlerName), batch, 0);
+            continue;
+        }
+        it.key()->evaluateJavaScript(
+                QStringLiteral("window.qnativewebbridge && window.qnativewebbridge.__receive('%1')")
+                        .arg(QString::fromLatin1(batch.toBase64())));
+    }
+}
+
+QNativeWebBridge::QNativeWebBridge(QObject *parent)
+    : QObject(parent), d_ptr(new QNativeWebBridgePrivate)
+{
+}
+
+QNativeWebBridge::~QNativeWebBridge()
+{
+    for (QNativeWebViewPrivate *page : qAsConst(d_ptr->pages)) {
+        page->removeMessageHandler(QLatin1String(HandlerName));
+    }
+    delete d_ptr;
+}
+
+void QNativeWebBridge::registerObject(const QString &name, QObject *object)
+{
+    Q_D(QNativeWebBridge);
+    if (!object || d->objects.contains(name) || d->names.contains(object)) {
+        qWarning() << "Cannot register" << object << "as" << name;
+        return;
+    }
+
+    QNativeWebBridgePrivate::Object entry;
+    entry.object = object;
+    const QMetaObject *metaObject = object->metaObject();
+    for (int i = 0; i < metaObject->propertyCount(); ++i) {
+        const QMetaProperty property = metaObject->property(i);
+        if (property.hasNotifySignal()) {
+            entry.notifiedProperties[property.notifySignalIndex()].append(i);
+        }
+    }
+    for (auto it = entry.notifiedProperties.cbegin(); it != entry.notifiedProperties.cend(); ++it) {
+        d->signalHandler.connectSignal(object, it.key());
+    }
+    connect(object, &QObject::destroyed, this, &QNativeWebBridge::deregisterObject);
+
+    d->objects.insert(name, entry);
+    d->names.insert(object, name);
+}
+
+void QNativeWebBridge::deregisterObject(QObject *object)
+{
+    Q_D(QNativeWebBridge);
+    const QString name = d->names.take(object);
+    if (name.isNull()) {
+        return;
+    }
+    d->objects.remove(name);
+    QObject::disconnect(object, nullptr, &d->signalHandler, nullptr);
+    disconnect(object, &QObject::destroyed, this, &QNativeWebBridge::deregisterObject);
+}
+
+QHash<QString, QObject *> QNativeWebBridge::registeredObjects() const
+{
+    Q_D(const QNativeWebBridge);
+    QHash<QString, QObject *> result;
+    for (auto it = d->objects.cbegin(); it != d->objects.cend(); ++it) {
+        result.insert(it.key(), it->object);
+    }
+    return result;
+}
+
+void QNativeWebBridge::attach(QNativeWebViewPrivate *page)
+{
+    Q_D(QNativeWebBridge);
+    if (d->pages.contains(page)) {
+        return;
+    }
+    d->pages.append(page);
+    connect(page, &QObject::destroyed, this, [d, page] {
+        d->pages.removeAll(page);
+        d->outgoing.remove(page);
+        d->sequences.remove(page);
+        d->unsubscribeAll(page);
+    });
+    // Large batches are posted as data
+    page->enableDataChannel();
+    page->addMessageHandler(
+            QLatin1String(HandlerName),
+            [d, page](const QString &message) { d->receive(page, message); },
+            bridgeScript());
+}
+
+void QNativeWebBridge::detach(QNativeWebViewPrivate *page)
+{
+    Q_D(QNativeWebBridge);
+    if (!d->pages.removeAll(page)) {
+        return;
+    }
+    disconnect(page, &QObject::destroyed, this, nullptr);
+    d->outgoing.remove(page);
+    d->sequences.remove(page);
+    d->unsubscribeAll(page);
+    page->removeMessageHandler(QLatin1String(HandlerName));
+}
@@ -0,0 +1,177 @@
+#include "private/qnativewebconsolebuffer_p.h"
+
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+namespace {
+
+// Size of the longest prefix of at most maxSize bytes that does not split a
+// UTF-8 sequence
+int truncatedSize(const QByteArray &text, int maxSize)
+{
+    int size = qMin(text.size(), maxSize);
+    if (size < text.size()) {
+        while (size > 0 && (uchar(text.at(size)) & 0xc0) == 0x80) {
+            --size;
+        }
+    }
+    return size;
+}
+
+// Appends to a line buffer without allocating
+struct LineWriter
+{
+    char buffer[512];
+    int size = 0;
+
+    void append(const char *text, int length)
+    {
+        length = qMin(length, int(sizeof(buffer)) - size);
+        std::memcpy(buffer + size, text, length);
+        size += length;
+    }
+    void append(const char *text) { append(text, int(std::strlen(text))); }
+    void append(qint64 number)
+    {
+        char digits[24];
+        int count = 0;
+        const bool negative = number < 0;
+        quint64 value = negative ? quint64(-(number + 1)) + 1 : quint64(number);
+        do {
+            digits[sizeof(digits) - ++count] = char('0' + value % 10);
+            value /= 10;
+        } while (value);
+        if (negative) {
+            digits[sizeof(digits) - ++count] = '-';
+        }
+        append(digits + sizeof(digits) - count, count);
+    }
+};
+
+void writeAll(int fd, const char *data, int size)
+{
+    while (size > 0) {
+#ifdef Q_OS_WIN
+        const int written = _write(fd, data, unsigned(size));
+#else
+        const int written = int(::write(fd, data, size_t(size)));
+#endif
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+} // namespace
+
+QNativeWebConsoleBuffer::QNativeWebConsoleBuffer(int capacity)
+    : m_capacity(qMax(1, capacity)), m_slots(new Slot[m_capacity])
+{
+}
+
+void QNativeWebConsoleBuffer::append(QNativeWebConsoleMessage::Level level, qint64 timestamp,
+                                     const QByteArray &message, const QByteArray &source,
+                                     int line, int column)
+{
+    const quint64 position = m_head.load(std::memory_order_relaxed);
+    Slot &slot = m_slots[position % m_capacity];
+    slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestamp = timestamp;
+    slot.line = line;
+    slot.column = column;
+    slot.level = quint8(level);
+    slot.messageSize = quint8(truncatedSize(message, MessageSize));
+    std::memcpy(slot.message, message.constData(), slot.messageSize);
+    slot.sourceSize = quint8(truncatedSize(source, SourceSize));
+    std::memcpy(slot.source, source.constData(), slot.sourceSize);
+
+    slot.sequence.store(2 * position + 2, std::memory_order_release);
+    m_head.store(position + 1, std::memory_order_release);
+}
+
+bool QNativeWebConsoleBuffer::read(quint64 position, Slot *copy) const
+{
+    const Slot &slot = m_slots[position % m_capacity];
+    const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != 2 * position + 2) {
+        return false;
+    }
+    copy->timestamp = slot.timestamp;
+    copy->line = slot.line;
+    copy->column = slot.column;
+    copy->level = slot.level;
+    copy->messageSize = qMin<quint8>(slot.messageSize, MessageSize);
+    std::memcpy(copy->message, slot.message, copy->messageSize);
+    copy->sourceSize = qMin<quint8>(slot.sourceSize, SourceSize);
+    std::memcpy(copy->source, slot.source, copy->sourceSize);
+    // The copy is only good if the writer did not start on the slot meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+QList<QNativeWebConsoleMessage> QNativeWebConsoleBuffer::drain()
+{
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    if (head - m_tail > quint64(m_capacity)) {
+        m_dropped += head - m_capacity - m_tail;
+        m_tail = head - m_capacity;
+    }
+
+    QList<QNativeWebConsoleMessage> messages;
+    messages.reserve(int(head - m_tail));
+    Slot slot;
+    for (; m_tail < head; ++m_tail) {
+        if (!read(m_tail, &slot)) {
+            ++m_dropped;
+            continue;
+        }
+        QNativeWebConsoleMessage message;
+        message.level = QNativeWebConsoleMessage::Level(slot.level);
+        message.timestamp = slot.timestamp;
+        message.message = QString::fromUtf8(slot.message, slot.messageSize);
+        message.source = QString::fromUtf8(slot.source, slot.sourceSize);
+        message.line = slot.line;
+        message.column = slot.column;
+        messages.append(message);
+    }
+    return messages;
+}
+
+void QNativeWebConsoleBuffer::dump(int fd) const
+{
+    static const char *const levels[] = { "debug", "info", "warning", "error" };
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    const quint64 first = head > quint64(m_capacity) ? head - m_capacity : 0;
+    Slot slot;
+    for (quint64 position = first; position < head; ++position) {
+        if (!read(position, &slot)) {
+            continue;
+        }
+        // <timestamp> <level> [<source>:<line>:<column>] <message>
+        LineWriter line;
+        line.append(slot.timestamp);
+        line.append(" ");
+        line.append(levels[qMin<int>(slot.level, 3)]);
+        line.append(" ");
+        if (slot.sourceSize > 0) {
+            line.append(slot.source, slot.sourceSize);
+            line.append(":");
+            line.append(qint64(slot.line));
+            line.append(":");
+            line.append(qint64(slot.column));
+            line.append(" ");
+        }
+        line.append(slot.message, slot.messageSize);
+        line.append("\n");
+        writeAll(fd, line.buffer, line.size);
+    }
+}
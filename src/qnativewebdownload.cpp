@@ -0,0 +1,128 @@
+#include "private/qnativewebdownload_p.h"
+#include "private/qnativewebview_p.h"
+
+QNativeWebDownload *QNativeWebDownloadPrivate::create(const QUrl &url,
+                                                      QNativeWebViewPrivate *owner)
+{
+    QNativeWebDownloadPrivate *d = new QNativeWebDownloadPrivate;
+    d->owner = owner;
+    d->url = url;
+    d->clock.start();
+    return new QNativeWebDownload(d, owner);
+}
+
+void QNativeWebDownloadPrivate::updateProgress(qint64 received, qint64 total, bool force)
+{
+    receivedBytes = received;
+    totalBytes = total;
+    if (!force && lastProgress.isValid() && lastProgress.elapsed() < progressInterval) {
+        return;
+    }
+    lastProgress.start();
+    emit q_ptr->downloadProgress(receivedBytes, totalBytes);
+}
+
+void QNativeWebDownloadPrivate::setState(QNativeWebDownload::State newState,
+                                         const QString &error)
+{
+    if (state == newState) {
+        return;
+    }
+    state = newState;
+    errorString = error;
+    if (state != QNativeWebDownload::InProgress) {
+        duration = clock.elapsed();
+        // Deliver the final numbers that throttling may have held back
+        updateProgress(receivedBytes, totalBytes, true);
+    }
+    emit q_ptr->stateChanged(state);
+    if (state != QNativeWebDownload::InProgress) {
+        emit q_ptr->finished();
+    }
+}
+
+void QNativeWebDownloadPrivate::restart()
+{
+    receivedBytes = 0;
+    totalBytes = -1;
+    duration = -1;
+    clock.start();
+    lastProgress.invalidate();
+    setState(QNativeWebDownload::InProgress);
+}
+
+QNativeWebDownload::QNativeWebDownload(QNativeWebDownloadPrivate *d, QObject *parent)
+    : QObject(parent), d_ptr(d)
+{
+    d_ptr->q_ptr = this;
+}
+
+QNativeWebDownload::~QNativeWebDownload()
+{
+    if (d_ptr->releaseHandler) {
+        d_ptr->releaseHandler();
+    }
+    QNativeWebViewPrivate::releaseDownloadDestination(d_ptr->destination);
+    delete d_ptr;
+}
+
+QUrl QNativeWebDownload::url() const
+{
+    return d_ptr->url;
+}
+
+QString QNativeWebDownload::destination() const
+{
+    return d_ptr->destination;
+}
+
+QNativeWebDownload::State QNativeWebDownload::state() const
+{
+    return d_ptr->state;
+}
+
+QString QNativeWebDownload::errorString() const
+{
+    return d_ptr->errorString;
+}
+
+qint64 QNativeWebDownload::receivedBytes() const
+{
+    return d_ptr->receivedBytes;
+}
+
+qint64 QNativeWebDownload::totalBytes() const
+{
+    return d_ptr->totalBytes;
+}
+
+double QNativeWebDownload::bytesPerSecond() const
+{
+    const qint64 elapsed = d_ptr->duration >= 0 ? d_ptr->duration : d_ptr->clock.elapsed();
+    return elapsed > 0 ? d_ptr->receivedBytes * 1000.0 / elapsed : 0;
+}
+
+int QNativeWebDownload::progressInterval() const
+{
+    return d_ptr->progressInterval;
+}
+
+void QNativeWebDownload::setProgressInterval(int msecs)
+{
+    d_ptr->progressInterval = qMax(0, msecs);
+}
+
+void QNativeWebDownload::cancel()
+{
+    if (d_ptr->state == InProgress && d_ptr->cancelHandler) {
+        d_ptr->cancelHandler();
+    }
+}
+
+void QNativeWebDownload::resume()
+{
+    if (d_ptr->state != InProgress && d_ptr->state != Completed && d_ptr->resumeHandler) {
+        d_ptr->restart();
+        d_ptr->resumeHandler();
+    }
+}
@@ -0,0 +1,64 @@
+#include "private/qnativewebharwriter_p.h"
+
+#include <QFileDevice>
+#include <QJsonDocument>
+
+void QNativeWebHarWriter::begin()
+{
+    const QJsonObject creator{
+        { QStringLiteral("name"), QStringLiteral("QtNativeWebView") },
+        { QStringLiteral("version"), QStringLiteral(QNATIVEWEBVIEW_VERSION) }
+    };
+    write("{\"log\":{\"version\":\"1.2\",\"creator\":"
+          + QJsonDocument(creator).toJson(QJsonDocument::Compact) + ",\"entries\":[\n");
+}
+
+void QNativeWebHarWriter::addEntry(const QJsonObject &entry)
+{
+    QByteArray data = QJsonDocument(entry).toJson(QJsonDocument::Compact);
+    if (!m_firstEntry) {
+        data.prepend(",\n");
+    }
+    m_firstEntry = false;
+    write(data);
+    // What was captured survives a crash of a long capture
+    if (QFileDevice *file = qobject_cast<QFileDevice *>(m_device)) {
+        file->flush();
+    }
+}
+
+void QNativeWebHarWriter::addPage(const QJsonObject &page)
+{
+    if (!m_pages.isOpen() && !m_pages.open()) {
+        qWarning("QNativeWebHarWriter: page records are dropped: %s",
+                 qPrintable(m_pages.errorString()));
+        return;
+    }
+    if (!m_firstPage) {
+        m_pages.write(",\n");
+    }
+    m_firstPage = false;
+    m_pages.write(QJsonDocument(page).toJson(QJsonDocument::Compact));
+}
+
+void QNativeWebHarWriter::finish()
+{
+    write("\n],\"pages\":[\n");
+    if (m_pages.isOpen()) {
+        m_pages.seek(0);
+        while (!m_pages.atEnd()) {
+            write(m_pages.read(64 * 1024));
+        }
+        m_pages.resize(0);
+        m_pages.close();
+    }
+    write("\n]}}\n");
+    m_firstPage = true;
+}
+
+void QNativeWebHarWriter::write(const QByteArray &data)
+{
+    if (m_device) {
+        m_device->write(data);
+    }
+}
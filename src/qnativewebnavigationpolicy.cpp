@@ -0,0 +1,337 @@
+#include "qnativewebnavigationpolicy.h"
+#include "qnativewebassetpack.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int NoDecision = -1;
+
+// Schemes of the data pages are handed by the library itself, besides asset packs
+const char *const InternalSchemes[] = { "qnwdata" };
+
+// Compiled trie: the children of a node are consecutive edges sorted by label,
+// the root's children are top-level domains
+struct TrieNode
+{
+    int firstEdge = 0;
+    int edgeCount = 0;
+    int decision = NoDecision;
+};
+
+struct TrieEdge
+{
+    QByteArray label;
+    int node;
+};
+
+struct TrieBuildNode
+{
+    std::map<QByteArray, std::unique_ptr<TrieBuildNode>> children;
+    int decision = NoDecision;
+};
+
+struct PrefixRule
+{
+    QString prefix;
+    int decision;
+};
+
+// ASCII-compatible lowercase host without wildcard and trailing dot, or empty
+QByteArray normalizedDomain(QString domain)
+{
+    domain = domain.trimmed().toLower();
+    if (domain.startsWith(QLatin1String("*."))) {
+        domain.remove(0, 2);
+    } else if (domain.startsWith(QLatin1Char('.'))) {
+        domain.remove(0, 1);
+    }
+    if (domain.endsWith(QLatin1Char('.'))) {
+        domain.chop(1);
+    }
+    if (domain.isEmpty() || domain.contains(QLatin1String(".."))) {
+        return QByteArray();
+    }
+    return QUrl::toAce(domain);
+}
+
+bool isInternalScheme(const QString &scheme)
+{
+    if (scheme.compare(QNativeWebAssetPack::scheme(), Qt::CaseInsensitive) == 0) {
+        return true;
+    }
+    for (const char *internal : InternalSchemes) {
+        if (scheme.compare(QLatin1String(internal), Qt::CaseInsensitive) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+class QNativeWebNavigationPolicyPrivate
+{
+public:
+    // Called after every change, except while loading a file
+    void changed();
+    void compile();
+    int matchDomain(const QByteArray &host) const;
+    int matchPrefix(const QByteArray &host, const QString &url) const;
+
+    QNativeWebNavigationPolicy::Decision defaultDecision = QNativeWebNavigationPolicy::Allow;
+    QHash<QByteArray, int> domainRules;
+    QHash<QString, int> prefixRules;
+    bool loading = false;
+
+    // The root alone until rules are compiled
+    std::vector<TrieNode> nodes = std::vector<TrieNode>(1);
+    std::vector<TrieEdge> edges;
+    // By host, longest prefix first
+    QHash<QByteArray, std::vector<PrefixRule>> prefixesByHost;
+
+    QNativeWebNavigationStatistics statistics;
+};
+
+void QNativeWebNavigationPolicyPrivate::changed()
+{
+    if (!loading) {
+        compile();
+    }
+}
+
+void QNativeWebNavigationPolicyPrivate::compile()
+{
+    QElapsedTimer timer;
+    timer.start();
+    TrieBuildNode root;
+    for (auto it = domainRules.cbegin(); it != domainRules.cend(); ++it) {
+        TrieBuildNode *node = &root;
+        const QList<QByteArray> labels = it.key().split('.');
+        for (auto label = labels.crbegin(); label != labels.crend(); ++label) {
+            std::unique_ptr<TrieBuildNode> &child = node->children[*label];
+            if (!child) {
+                child.reset(new TrieBuildNode);
+            }
+            node = child.get();
+        }
+        node->decision = it.value();
+    }
+
+    // Breadth first, so that the children of every node are consecutive
+    nodes.assign(1, TrieNode());
+    edges.clear();
+    std::vector<std::pair<const TrieBuildNode *, int>> queue{ { &root, 0 } };
+    for (size_t i = 0; i < queue.size(); ++i) {
+        const TrieBuildNode *source = queue[i].first;
+        const int index = queue[i].second;
+        nodes[index].decision = source->decision;
+        nodes[index].firstEdge = int(edges.size());
+        nodes[index].edgeCount = int(source->children.size());
+        for (const auto &child : source->children) {
+            const int childIndex = int(nodes.size());
+            nodes.emplace_back();
+            edges.push_back({ child.first, childIndex });
+            queue.emplace_back(child.second.get(), childIndex);
+        }
+    }
+
+    prefixesByHost.clear();
+    for (auto it = prefixRules.cbegin(); it != prefixRules.cend(); ++it) {
+        const QByteArray host = QUrl(it.key()).host(QUrl::FullyEncoded).toLatin1();
+        prefixesByHost[host].push_back({ it.key(), it.value() });
+    }
+    for (auto it = prefixesByHost.begin(); it != prefixesByHost.end(); ++it) {
+        std::sort(it->begin(), it->end(), [](const PrefixRule &a, const PrefixRule &b) {
+            return a.prefix.size() > b.prefix.size();
+        });
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    statistics.totalCompileTime += elapsed;
+    statistics.maxCompileTime = qMax(statistics.maxCompileTime, elapsed);
+}
+
+int QNativeWebNavigationPolicyPrivate::matchDomain(const QByteArray &host) const
+{
+    int decision = NoDecision;
+    int node = 0;
+    int end = host.size();
+    while (end > 0) {
+        const int start = host.lastIndexOf('.', end - 1) + 1;
+        // Compared in place, without copying the label
+        const QByteArray label = QByteArray::fromRawData(host.constData() + start, end - start);
+        const auto first = edges.cbegin() + nodes[node].firstEdge;
+        const auto last = first + nodes[node].edgeCount;
+        const auto edge = std::lower_bound(
+                first, last, label,
+                [](const TrieEdge &edge, const QByteArray &label) { return edge.label < label; });
+        if (edge == last || edge->label != label) {
+            break;
+        }
+        node = edge->node;
+        if (nodes[node].decision != NoDecision) {
+            decision = nodes[node].decision;
+        }
+        end = start - 1;
+    }
+    return decision;
+}
+
+int QNativeWebNavigationPolicyPrivate::matchPrefix(const QByteArray &host, const QString &url) const
+{
+    const auto rules = prefixesByHost.constFind(host);
+    if (rules == prefixesByHost.cend()) {
+        return NoDecision;
+    }
+    for (const PrefixRule &rule : *rules) {
+        if (url.startsWith(rule.prefix)) {
+            return rule.decision;
+        }
+    }
+    return NoDecision;
+}
+
+QNativeWebNavigationPolicy::QNativeWebNavigationPolicy(QObject *parent)
+    : QObject(parent), d_ptr(new QNativeWebNavigationPolicyPrivate)
+{
+}
+
+QNativeWebNavigationPolicy::~QNativeWebNavigationPolicy()
+{
+    delete d_ptr;
+}
+
+QNativeWebNavigationPolicy::Decision QNativeWebNavigationPolicy::defaultDecision() const
+{
+    return d_ptr->defaultDecision;
+}
+
+void QNativeWebNavigationPolicy::setDefaultDecision(Decision decision)
+{
+    d_ptr->defaultDecision = decision;
+}
+
+bool QNativeWebNavigationPolicy::addDomainRule(const QString &domain, Decision decision)
+{
+    const QByteArray normalized = normalizedDomain(domain);
+    if (normalized.isEmpty()) {
+        return false;
+    }
+    d_ptr->domainRules.insert(normalized, decision);
+    d_ptr->changed();
+    return true;
+}
+
+bool QNativeWebNavigationPolicy::addUrlPrefixRule(const QString &prefix, Decision decision)
+{
+    const QUrl url(prefix.trimmed(), QUrl::StrictMode);
+    if (!url.isValid() || url.scheme().isEmpty()) {
+        return false;
+    }
+    // Same form as the URLs passed to decide()
+    d_ptr->prefixRules.insert(url.toString(QUrl::FullyEncoded), decision);
+    d_ptr->changed();
+    return true;
+}
+
+bool QNativeWebNavigationPolicy::loadRules(const QString &fileName, QString *errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+
+    // Compiled once for the whole file, including the rules read before an error
+    d_ptr->loading = true;
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && !file.atEnd()) {
+        ++lineNumber;
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+        const int space = line.indexOf(QLatin1Char(' '));
+        const QString action = line.left(space);
+        const QString rule = line.mid(space + 1).trimmed();
+        ok = space > 0;
+        if (ok) {
+            Decision decision = Allow;
+            if (action == QLatin1String("deny")) {
+                decision = Deny;
+            } else if (action != QLatin1String("allow")) {
+                ok = false;
+            }
+            if (ok) {
+                ok = rule.contains(QLatin1String("://")) ? addUrlPrefixRule(rule, decision)
+                                                         : addDomainRule(rule, decision);
+            }
+        }
+        if (!ok && errorString) {
+            *errorString = tr("%1:%2: invalid rule").arg(fileName).arg(lineNumber);
+        }
+    }
+    d_ptr->loading = false;
+    d_ptr->compile();
+    return ok;
+}
+
+void QNativeWebNavigationPolicy::clear()
+{
+    d_ptr->domainRules.clear();
+    d_ptr->prefixRules.clear();
+    d_ptr->changed();
+}
+
+int QNativeWebNavigationPolicy::ruleCount() const
+{
+    return d_ptr->domainRules.size() + d_ptr->prefixRules.size();
+}
+
+QNativeWebNavigationPolicy::Decision QNativeWebNavigationPolicy::decide(const QUrl &url)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray host = url.host(QUrl::FullyEncoded).toLatin1();
+    if (host.endsWith('.')) {
+        host.chop(1);
+    }
+    Decision result = Allow;
+    if (!host.isEmpty() && !isInternalScheme(url.scheme())) {
+        int decision = d_ptr->matchPrefix(host, url.toString(QUrl::FullyEncoded));
+        if (decision == NoDecision) {
+            decision = d_ptr->matchDomain(host);
+        }
+        result = decision == NoDecision ? d_ptr->defaultDecision : Decision(decision);
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    QNativeWebNavigationStatistics &stats = d_ptr->statistics;
+    ++(result == Allow ? stats.allowed : stats.denied);
+    stats.totalDecisionTime += elapsed;
+    stats.maxDecisionTime = qMax(stats.maxDecisionTime, elapsed);
+    if (result == Deny) {
+        emit navigationDenied(url);
+    }
+    return result;
+}
+
+QNativeWebNavigationStatistics QNativeWebNavigationPolicy::statistics() const
+{
+    return d_ptr->statistics;
+}
+
+void QNativeWebNavigationPolicy::resetStatistics()
+{
+    d_ptr->statistics = QNativeWebNavigationStatistics();
+}
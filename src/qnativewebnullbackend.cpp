@@ -0,0 +1,77 @@
+#include "qnativewebnullbackend.h"
+
+#include <QCoreApplication>
+#include <QPointer>
+
+QNativeWebNullBackend::QNativeWebNullBackend(QObject *parent) : QObject(parent) { }
+
+QNativeWebNullBackend *QNativeWebNullBackend::instance()
+{
+    static QPointer<QNativeWebNullBackend> backend;
+    if (!backend) {
+        backend = new QNativeWebNullBackend(QCoreApplication::instance());
+    }
+    return backend;
+}
+
+void QNativeWebNullBackend::setLoadResult(const QUrl &url, bool ok, const QString &title)
+{
+    m_loadResults.insert(url, { ok, title });
+}
+
+void QNativeWebNullBackend::setScriptResult(const QString &script, const QVariant &result)
+{
+    m_scriptResults.insert(script, result);
+}
+
+void QNativeWebNullBackend::setDefaultScriptResult(const QVariant &result)
+{
+    m_defaultScriptResult = result;
+}
+
+void QNativeWebNullBackend::clearResults()
+{
+    m_loadResults.clear();
+    m_scriptResults.clear();
+    m_defaultScriptResult.clear();
+}
+
+void QNativeWebNullBackend::setCallCapacity(int capacity)
+{
+    const QList<Call> kept = calls();
+    m_callCapacity = qMax(1, capacity);
+    clearCalls();
+    for (int i = qMax(0, kept.size() - m_callCapacity); i < kept.size(); ++i) {
+        m_calls.append(kept.at(i));
+    }
+}
+
+QList<QNativeWebNullBackend::Call> QNativeWebNullBackend::calls() const
+{
+    QList<Call> calls;
+    calls.reserve(m_calls.size());
+    for (int i = 0; i < m_calls.size(); ++i) {
+        calls.append(m_calls.at((m_firstCall + i) % m_calls.size()));
+    }
+    return calls;
+}
+
+void QNativeWebNullBackend::clearCalls()
+{
+    m_calls.clear();
+    m_firstCall = 0;
+}
+
+void QNativeWebNullBackend::record(const QObject *page, const QString &method,
+                                   const QVariantList &arguments)
+{
+    if (!m_recording) {
+        return;
+    }
+    if (m_calls.size() < m_callCapacity) {
+        m_calls.append({ page, method, arguments });
+    } else {
+        m_calls[m_firstCall] = { page, method, arguments };
+        m_firstCall = (m_firstCall + 1) % m_calls.size();
+    }
+}
@@ -0,0 +1,394 @@
+#include "qnativewebpage.h"
+
+#include "private/qnullwebview.h"
+
+#ifdef Q_OS_WIN
+#  include "private/qwebview2webview.h"
+#endif
+
+#ifdef Q_OS_LINUX
+#  include "private/qlinuxwebview.h"
+#endif
+
+#ifdef Q_OS_MACOS
+#  include "private/qdarwinwebview.h"
+#endif
+
+#include <QDebug>
+#include <QMap>
+
+namespace {
+
+struct BackendRegistry
+{
+    QMap<QString, QNativeWebViewPrivate::BackendFactory> factories;
+    QString defaultBackend;
+};
+
+template<typename Backend>
+QNativeWebViewPrivate *createBackend(QNativeWebProfile *profile, QObject *parent)
+{
+    return new Backend(profile, parent);
+}
+
+BackendRegistry *backendRegistry()
+{
+    static BackendRegistry registry = [] {
+        BackendRegistry registry;
+        registry.factories.insert(QStringLiteral("null"), createBackend<QNullWebViewPrivate>);
+#ifdef Q_OS_WIN
+        registry.defaultBackend = QStringLiteral("webview2");
+        registry.factories.insert(registry.defaultBackend,
+                                  createBackend<QWebView2WebViewPrivate>);
+#endif
+#ifdef Q_OS_LINUX
+        registry.defaultBackend = QStringLiteral("webkitgtk");
+        registry.factories.insert(registry.defaultBackend, createBackend<QLinuxWebViewPrivate>);
+#endif
+#ifdef Q_OS_MACOS
+        registry.defaultBackend = QStringLiteral("wkwebview");
+        registry.factories.insert(registry.defaultBackend, createBackend<QDarwinWebViewPrivate>);
+#endif
+        const QString requested = qEnvironmentVariable("QNATIVEWEBVIEW_BACKEND");
+        if (registry.factories.contains(requested)) {
+            registry.defaultBackend = requested;
+        } else if (!requested.isEmpty()) {
+            qWarning() << "Unknown QNativeWebView backend" << requested;
+        }
+        return registry;
+    }();
+    return &registry;
+}
+
+} // namespace
+
+void QNativeWebViewPrivate::registerBackend(const QString &name, const BackendFactory &factory)
+{
+    backendRegistry()->factories.insert(name, factory);
+}
+
+QStringList QNativeWebViewPrivate::backends()
+{
+    return backendRegistry()->factories.keys();
+}
+
+QString QNativeWebViewPrivate::defaultBackend()
+{
+    return backendRegistry()->defaultBackend;
+}
+
+bool QNativeWebViewPrivate::setDefaultBackend(const QString &name)
+{
+    BackendRegistry *registry = backendRegistry();
+    if (!registry->factories.contains(name)) {
+        return false;
+    }
+    registry->defaultBackend = name;
+    return true;
+}
+
+QNativeWebViewPrivate *QNativeWebViewPrivate::create(QNativeWebProfile *profile, QObject *parent)
+{
+    const BackendRegistry *registry = backendRegistry();
+    // Platforms without an engine get the null backend
+    const QString name = registry->factories.contains(registry->defaultBackend)
+            ? registry->defaultBackend
+            : QStringLiteral("null");
+    QNativeWebViewPrivate *backend = registry->factories.value(name)(profile, parent);
+    backend->m_backendName = name;
+    return backend;
+}
+
+QNativeWebPage::QNativeWebPage(QObject *parent)
+    : QNativeWebPage(QNativeWebProfile::defaultProfile(), parent)
+{
+}
+
+QNativeWebPage::QNativeWebPage(QNativeWebProfile *profile, QObject *parent)
+    : QObject(parent),
+      d_ptr(QNativeWebViewPrivate::create(profile ? profile : QNativeWebProfile::defaultProfile(),
+                                          this))
+{
+    connect(d_ptr, &QNativeWebViewPrivate::loadStarted, this, &QNativeWebPage::loadStarted);
+    connect(d_ptr, &QNativeWebViewPrivate::loadProgress, this, &QNativeWebPage::loadProgress);
+    connect(d_ptr, &QNativeWebViewPrivate::loadFinished, this, &QNativeWebPage::loadFinished);
+    connect(d_ptr, &QNativeWebViewPrivate::titleChanged, this, &QNativeWebPage::titleChanged);
+    connect(d_ptr, &QNativeWebViewPrivate::statusBarMessage, this,
+            &QNativeWebPage::statusBarMessage);
+    connect(d_ptr, &QNativeWebViewPrivate::linkClicked, this, &QNativeWebPage::linkClicked);
+    connect(d_ptr, &QNativeWebViewPrivate::iconChanged, this, &QNativeWebPage::iconChanged);
+    connect(d_ptr, &QNativeWebViewPrivate::urlChanged, this, &QNativeWebPage::urlChanged);
+    connect(d_ptr, &QNativeWebViewPrivate::errorOccurred, this, &QNativeWebPage::errorOccurred);
+    connect(d_ptr, &QNativeWebViewPrivate::downloadRequested, this,
+            &QNativeWebPage::downloadRequested);
+    connect(d_ptr, &QNativeWebViewPrivate::renderProcessTerminated, this,
+            &QNativeWebPage::renderProcessTerminated);
+    connect(d_ptr, &QNativeWebViewPrivate::renderProcessRecovered, this,
+            &QNativeWebPage::renderProcessRecovered);
+    connect(d_ptr, &QNativeWebViewPrivate::metricsCollected, this,
+            &QNativeWebPage::metricsCollected);
+}
+
+QNativeWebPage::~QNativeWebPage() { }
+
+QStringList QNativeWebPage::availableBackends()
+{
+    return QNativeWebViewPrivate::backends();
+}
+
+QString QNativeWebPage::defaultBackend()
+{
+    return QNativeWebViewPrivate::defaultBackend();
+}
+
+bool QNativeWebPage::setDefaultBackend(const QString &name)
+{
+    return QNativeWebViewPrivate::setDefaultBackend(name);
+}
+
+QString QNativeWebPage::backend() const
+{
+    return d_ptr->backendName();
+}
+
+QString QNativeWebPage::errorString() const
+{
+    return d_ptr->errorString();
+}
+
+QNativeWebSettings *QNativeWebPage::settings() const
+{
+    return d_ptr->settings();
+}
+
+QNativeWebProfile *QNativeWebPage::profile() const
+{
+    return d_ptr->profile();
+}
+
+QIcon QNativeWebPage::icon() const
+{
+    return d_ptr->icon();
+}
+
+QString QNativeWebPage::userAgent() const
+{
+    return d_ptr->userAgent();
+}
+
+bool QNativeWebPage::setUserAgent(const QString &userAgent)
+{
+    return d_ptr->setUserAgent(userAgent);
+}
+
+void QNativeWebPage::allCookies(const std::function<void(const QJsonObject &)> &callback)
+{
+    d_ptr->allCookies(callback);
+}
+
+bool QNativeWebPage::setCookie(const QString &domain, const QString &name, const QString &value)
+{
+    return d_ptr->setCookie(domain, name, value);
+}
+
+void QNativeWebPage::deleteCookie(const QString &domain, const QString &name)
+{
+    d_ptr->deleteCookie(domain, name);
+}
+
+void QNativeWebPage::deleteAllCookies()
+{
+    d_ptr->deleteAllCookies();
+}
+
+void QNativeWebPage::evaluateJavaScript(const QString &scriptSource,
+                                        const std::function<void(const QVariant &)> &callback)
+{
+    d_ptr->evaluateJavaScript(scriptSource, callback);
+}
+
+void QNativeWebPage::pageSource(const std::function<void(const QByteArray &)> &callback)
+{
+    d_ptr->pageSource(callback);
+}
+
+void QNativeWebPage::plainText(const std::function<void(const QString &)> &callback)
+{
+    d_ptr->plainText(callback);
+}
+
+void QNativeWebPage::setDownloadPolicy(const QNativeWebDownloadPolicy &policy)
+{
+    d_ptr->setDownloadPolicy(policy);
+}
+
+QList<QNativeWebDownload *> QNativeWebPage::downloads() const
+{
+    return d_ptr->downloads();
+}
+
+QNativeWebDownloadStatistics QNativeWebPage::downloadStatistics() const
+{
+    return d_ptr->downloadStatistics();
+}
+
+void QNativeWebPage::setRenderProcessRecovery(int maxRestarts, int intervalMsecs)
+{
+    d_ptr->setRenderProcessRecovery(maxRestarts, intervalMsecs);
+}
+
+void QNativeWebPage::setWebBridge(QNativeWebBridge *bridge)
+{
+    d_ptr->setWebBridge(bridge);
+}
+
+QNativeWebBridge *QNativeWebPage::webBridge() const
+{
+    return d_ptr->webBridge();
+}
+
+void QNativeWebPage::setNavigationPolicy(QNativeWebNavigationPolicy *policy)
+{
+    d_ptr->setNavigationPolicy(policy);
+}
+
+QNativeWebNavigationPolicy *QNativeWebPage::navigationPolicy() const
+{
+    return d_ptr->navigationPolicy();
+}
+
+void QNativeWebPage::postData(const QString &channel, const QByteArray &data, int chunkSize)
+{
+    d_ptr->postData(channel, data, chunkSize);
+}
+
+QNativeWebStreamReader *QNativeWebPage::streamJavaScript(const QString &producer)
+{
+    return d_ptr->streamJavaScript(producer);
+}
+
+void QNativeWebPage::setMetricsCollectionEnabled(bool enabled)
+{
+    d_ptr->setMetricsCollectionEnabled(enabled);
+}
+
+bool QNativeWebPage::isMetricsCollectionEnabled() const
+{
+    return d_ptr->isMetricsCollectionEnabled();
+}
+
+QNativeWebPageMetrics QNativeWebPage::metrics() const
+{
+    return d_ptr->metrics();
+}
+
+void QNativeWebPage::setConsoleCapacity(int capacity)
+{
+    d_ptr->setConsoleCapacity(capacity);
+}
+
+int QNativeWebPage::consoleCapacity() const
+{
+    return d_ptr->consoleCapacity();
+}
+
+QList<QNativeWebConsoleMessage> QNativeWebPage::drainConsoleMessages()
+{
+    return d_ptr->drainConsoleMessages();
+}
+
+quint64 QNativeWebPage::droppedConsoleMessages() const
+{
+    return d_ptr->droppedConsoleMessages();
+}
+
+void QNativeWebPage::dumpConsoleMessages(int fd) const
+{
+    d_ptr->dumpConsoleMessages(fd);
+}
+
+void QNativeWebPage::setQueryCacheEnabled(bool enabled)
+{
+    d_ptr->setQueryCacheEnabled(enabled);
+}
+
+bool QNativeWebPage::isQueryCacheEnabled() const
+{
+    return d_ptr->isQueryCacheEnabled();
+}
+
+void QNativeWebPage::evaluateCachedJavaScript(const QString &query,
+                                              const std::function<void(const QVariant &)> &callback)
+{
+    d_ptr->evaluateCachedJavaScript(query, callback);
+}
+
+QNativeWebQueryCacheStatistics QNativeWebPage::queryCacheStatistics() const
+{
+    return d_ptr->queryCacheStatistics();
+}
+
+void QNativeWebPage::resetQueryCacheStatistics()
+{
+    d_ptr->resetQueryCacheStatistics();
+}
+
+void QNativeWebPage::setVirtualTimeEnabled(bool enabled)
+{
+    d_ptr->setVirtualTimeEnabled(enabled);
+}
+
+bool QNativeWebPage::isVirtualTimeEnabled() const
+{
+    return d_ptr->isVirtualTimeEnabled();
+}
+
+void QNativeWebPage::advanceVirtualTime(int msecs, const std::function<void(double)> &callback)
+{
+    d_ptr->advanceVirtualTime(msecs, callback);
+}
+
+bool QNativeWebPage::startHarCapture(QIODevice *device)
+{
+    return d_ptr->startHarCapture(device);
+}
+
+void QNativeWebPage::stopHarCapture()
+{
+    d_ptr->stopHarCapture();
+}
+
+bool QNativeWebPage::isHarCapturing() const
+{
+    return d_ptr->isHarCapturing();
+}
+
+void QNativeWebPage::load(const QUrl &url)
+{
+    d_ptr->load(url);
+}
+
+void QNativeWebPage::setHtml(const QString &html, const QUrl &baseUrl)
+{
+    d_ptr->setHtml(html, baseUrl);
+}
+
+void QNativeWebPage::stop()
+{
+    d_ptr->stop();
+}
+
+void QNativeWebPage::back()
+{
+    d_ptr->back();
+}
+
+void QNativeWebPage::forward()
+{
+    d_ptr->forward();
+}
+
+void QNativeWebPage::reload()
+{
+    d_ptr->reload();
+}
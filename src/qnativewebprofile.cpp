@@ -0,0 +1,410 @@
+#include "private/qnativewebprofile_p.h"
+#include "private/qnativewebview_p.h"
+
+#ifdef Q_OS_LINUX
+#  include "private/qlinuxwebcontext.h"
+#endif
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QUrl>
+
+#include <algorithm>
+#include <memory>
+
+QString QNativeWebProfilePrivate::styleSheetScript(const QString &css)
+{
+    // Quote the css as a JSON string literal
+    QByteArray literal = QJsonDocument(QJsonArray{ css }).toJson(QJsonDocument::Compact);
+    literal = literal.mid(1, literal.size() - 2);
+    return QStringLiteral("(function() {"
+                          "var style = document.createElement('style');"
+                          "style.textContent = %1;"
+                          "(document.head || document.documentElement).appendChild(style);"
+                          "})();")
+            .arg(QString::fromUtf8(literal));
+}
+
+void QNativeWebProfilePrivate::setCookies(const QList<QNetworkCookie> &cookieList)
+{
+    QHash<QString, QHash<QString, QNetworkCookie>> updated;
+    for (const QNetworkCookie &cookie : cookieList) {
+        updated[cookie.domain()].insert(QString::fromUtf8(cookie.name()), cookie);
+    }
+
+    QList<QNetworkCookie> removed;
+    QList<QNetworkCookie> added;
+    for (auto domain = cookies.cbegin(); domain != cookies.cend(); ++domain) {
+        const QHash<QString, QNetworkCookie> updatedDomain = updated.value(domain.key());
+        for (auto it = domain.value().cbegin(); it != domain.value().cend(); ++it) {
+            const auto found = updatedDomain.constFind(it.key());
+            if (found == updatedDomain.cend() || *found != it.value()) {
+                removed.append(it.value());
+            }
+        }
+    }
+    for (auto domain = updated.cbegin(); domain != updated.cend(); ++domain) {
+        const QHash<QString, QNetworkCookie> oldDomain = cookies.value(domain.key());
+        for (auto it = domain.value().cbegin(); it != domain.value().cend(); ++it) {
+            const auto found = oldDomain.constFind(it.key());
+            if (found == oldDomain.cend() || *found != it.value()) {
+                added.append(it.value());
+            }
+        }
+    }
+
+    cookies = updated;
+    for (const QNetworkCookie &cookie : qAsConst(removed)) {
+        emit q_ptr->cookieChanged(cookie, QNativeWebProfile::CookieRemoved);
+    }
+    for (const QNetworkCookie &cookie : qAsConst(added)) {
+        emit q_ptr->cookieChanged(cookie, QNativeWebProfile::CookieAdded);
+    }
+}
+
+QJsonObject QNativeWebProfilePrivate::cookiesToJson() const
+{
+    QJsonObject result;
+    for (auto domain = cookies.cbegin(); domain != cookies.cend(); ++domain) {
+        // Each domain object is built once and inserted whole
+        QJsonObject jsonDomain;
+        for (const QNetworkCookie &cookie : domain.value()) {
+            const bool session = cookie.isSessionCookie();
+            jsonDomain.insert(QString::fromUtf8(cookie.name()),
+                              QJsonObject{
+                                      { "value", QString::fromUtf8(cookie.value()) },
+                                      { "path", cookie.path() },
+                                      { "expires",
+                                        session ? 0.0
+                                                : cookie.expirationDate().toMSecsSinceEpoch()
+                                                        / 1000.0 },
+                                      { "httpOnly", cookie.isHttpOnly() },
+                                      { "secure", cookie.isSecure() },
+                                      { "session", session },
+                              });
+        }
+        result.insert(domain.key(), jsonDomain);
+    }
+    return result;
+}
+
+void QNativeWebProfilePrivate::recordOriginUse(const QUrl &url)
+{
+    const QString host = url.host().toLower();
+    if (!host.isEmpty()) {
+        originUse.insert(host, QDateTime::currentDateTimeUtc());
+    }
+}
+
+void QNativeWebProfilePrivate::maybeEvict()
+{
+    if (websiteDataQuota <= 0 || evicting
+        || (lastEviction.isValid() && lastEviction.elapsed() < evictionInterval)) {
+        return;
+    }
+    q_ptr->evictWebsiteData();
+}
+
+// The profile with a quota among those sharing the backend's default store
+static QNativeWebProfile *&sharedStoreQuotaProfile()
+{
+    static QNativeWebProfile *profile = nullptr;
+    return profile;
+}
+
+static QDateTime lastUse(const QHash<QString, QDateTime> &originUse, const QString &origin)
+{
+    // Backends may group the data of subdomains under their registrable domain
+    QDateTime result = originUse.value(origin);
+    const QString suffix = QLatin1Char('.') + origin;
+    for (auto it = originUse.cbegin(); it != originUse.cend(); ++it) {
+        if (it.key().endsWith(suffix) && it.value() > result) {
+            result = it.value();
+        }
+    }
+    return result;
+}
+
+QNativeWebProfile::QNativeWebProfile(QObject *parent) : QNativeWebProfile(PersistentStorage, parent)
+{
+}
+
+QNativeWebProfile::QNativeWebProfile(StorageMode storageMode, QObject *parent)
+    : QObject(parent), d_ptr(new QNativeWebProfilePrivate)
+{
+    d_ptr->q_ptr = this;
+    d_ptr->storageMode = storageMode;
+    d_ptr->createBackend(QNativeWebViewPrivate::defaultBackend());
+}
+
+QNativeWebProfile::QNativeWebProfile(const QString &storageName, QObject *parent)
+    : QObject(parent), d_ptr(new QNativeWebProfilePrivate)
+{
+    d_ptr->q_ptr = this;
+    d_ptr->storageName = storageName;
+    d_ptr->createBackend(QNativeWebViewPrivate::defaultBackend());
+}
+
+QNativeWebProfile::~QNativeWebProfile()
+{
+    if (sharedStoreQuotaProfile() == this) {
+        sharedStoreQuotaProfile() = nullptr;
+    }
+    delete d_ptr->backend;
+    delete d_ptr;
+}
+
+void QNativeWebProfilePrivate::createBackend(const QString &name)
+{
+    delete backend;
+    backendName = name;
+#ifdef Q_OS_LINUX
+    // The null backend and others without profile state start no web context
+    if (name == QLatin1String("webkitgtk")) {
+        backend = new QLinuxWebContext(q_ptr);
+        if (proxy.type() != QNetworkProxy::DefaultProxy) {
+            backend->setProxy(proxy);
+        }
+        return;
+    }
+#endif
+    backend = new QNativeWebProfileBackend(q_ptr);
+}
+
+QNativeWebProfile::StorageMode QNativeWebProfile::storageMode() const
+{
+    return d_ptr->storageMode;
+}
+
+QString QNativeWebProfile::storageName() const
+{
+    return d_ptr->storageName;
+}
+
+QNativeWebProfile *QNativeWebProfile::defaultProfile()
+{
+    static QPointer<QNativeWebProfile> profile;
+    if (!profile) {
+        profile = new QNativeWebProfile(QCoreApplication::instance());
+    }
+    return profile;
+}
+
+int QNativeWebProfile::addUserScript(const QString &source, InjectionTime injectionTime,
+                                     bool allFrames)
+{
+    QNativeWebUserContent content;
+    content.id = d_ptr->nextId++;
+    content.source = source;
+    content.injectionTime = injectionTime;
+    content.allFrames = allFrames;
+    d_ptr->userContent.append(content);
+    emit userContentChanged();
+    return content.id;
+}
+
+int QNativeWebProfile::addUserStyleSheet(const QString &css, bool allFrames)
+{
+    QNativeWebUserContent content;
+    content.id = d_ptr->nextId++;
+    content.styleSheet = true;
+    content.source = css;
+    content.allFrames = allFrames;
+    d_ptr->userContent.append(content);
+    emit userContentChanged();
+    return content.id;
+}
+
+bool QNativeWebProfile::removeUserContent(int id)
+{
+    for (int i = 0; i < d_ptr->userContent.size(); ++i) {
+        if (d_ptr->userContent.at(i).id == id) {
+            d_ptr->userContent.removeAt(i);
+            emit userContentChanged();
+            return true;
+        }
+    }
+    return false;
+}
+
+void QNativeWebProfile::clearUserContent()
+{
+    if (!d_ptr->userContent.isEmpty()) {
+        d_ptr->userContent.clear();
+        emit userContentChanged();
+    }
+}
+
+QNetworkCookie QNativeWebProfile::cookie(const QString &domain, const QString &name) const
+{
+    auto it = d_ptr->cookies.constFind(domain);
+    if (it == d_ptr->cookies.cend() && !domain.startsWith(QLatin1Char('.'))) {
+        // Domain cookies are stored with a leading dot
+        it = d_ptr->cookies.constFind(QLatin1Char('.') + domain);
+    }
+    return it != d_ptr->cookies.cend() ? it->value(name) : QNetworkCookie();
+}
+
+QList<QNetworkCookie> QNativeWebProfile::cookies() const
+{
+    QList<QNetworkCookie> result;
+    for (const QHash<QString, QNetworkCookie> &domain : d_ptr->cookies) {
+        for (const QNetworkCookie &cookie : domain) {
+            result.append(cookie);
+        }
+    }
+    return result;
+}
+
+QIcon QNativeWebProfile::cachedIcon(const QUrl &url) const
+{
+    const QNativeWebCachedIcon *cached = d_ptr->icons.object(url.host().toLower());
+    return cached ? cached->icon : QIcon();
+}
+
+void QNativeWebProfile::websiteDataUsage(
+        WebsiteDataTypes types, const std::function<void(const QList<WebsiteData> &)> &callback)
+{
+    QPointer<QNativeWebProfile> profile = this;
+    d_ptr->backend->websiteDataUsage(types, [profile, callback](QList<WebsiteData> records) {
+        if (!profile) {
+            return;
+        }
+        for (WebsiteData &record : records) {
+            record.lastUsed = lastUse(profile->d_ptr->originUse, record.origin);
+        }
+        if (callback) {
+            callback(records);
+        }
+    });
+}
+
+void QNativeWebProfile::removeWebsiteData(WebsiteDataTypes types, const QStringList &origins,
+                                          const std::function<void()> &callback)
+{
+    d_ptr->backend->removeWebsiteData(types, origins, [callback] {
+        if (callback) {
+            callback();
+        }
+    });
+}
+
+void QNativeWebProfile::clearWebsiteData(WebsiteDataTypes types, const QDateTime &since,
+                                         const std::function<void()> &callback)
+{
+    d_ptr->backend->clearWebsiteData(types, since, [callback] {
+        if (callback) {
+            callback();
+        }
+    });
+}
+
+qint64 QNativeWebProfile::websiteDataQuota() const
+{
+    return d_ptr->websiteDataQuota;
+}
+
+void QNativeWebProfile::setWebsiteDataQuota(qint64 bytes)
+{
+    const qint64 quota = qMax<qint64>(0, bytes);
+    if (d_ptr->backend->sharesWebsiteData()) {
+        QNativeWebProfile *&holder = sharedStoreQuotaProfile();
+        if (quota > 0 && holder && holder != this) {
+            qWarning() << "QNativeWebProfile: another profile sharing the default website data "
+                          "store already has a quota";
+            return;
+        }
+        if (quota > 0) {
+            holder = this;
+        } else if (holder == this) {
+            holder = nullptr;
+        }
+    }
+    d_ptr->websiteDataQuota = quota;
+}
+
+int QNativeWebProfile::evictionInterval() const
+{
+    return d_ptr->evictionInterval;
+}
+
+void QNativeWebProfile::setEvictionInterval(int msecs)
+{
+    d_ptr->evictionInterval = qMax(0, msecs);
+}
+
+void QNativeWebProfile::evictWebsiteData(const std::function<void(qint64 bytesFreed)> &callback)
+{
+    if (d_ptr->websiteDataQuota <= 0 || d_ptr->evicting) {
+        if (callback) {
+            callback(0);
+        }
+        return;
+    }
+
+    d_ptr->evicting = true;
+    d_ptr->lastEviction.start();
+    QPointer<QNativeWebProfile> profile = this;
+    websiteDataUsage(AllWebsiteData, [profile, callback](QList<WebsiteData> records) {
+        qint64 total = 0;
+        for (const WebsiteData &record : qAsConst(records)) {
+            total += record.size;
+        }
+        const qint64 quota = profile->d_ptr->websiteDataQuota;
+        if (total <= quota) {
+            profile->d_ptr->evicting = false;
+            if (callback) {
+                callback(0);
+            }
+            return;
+        }
+
+        // Least recently used first, origins never seen by this profile before all others
+        std::stable_sort(records.begin(), records.end(),
+                         [](const WebsiteData &a, const WebsiteData &b) {
+                             return a.lastUsed.isValid() != b.lastUsed.isValid()
+                                     ? !a.lastUsed.isValid()
+                                     : a.lastUsed < b.lastUsed;
+                         });
+        const qint64 target = quota / 10 * 9;
+        QStringList origins;
+        qint64 freed = 0;
+        for (const WebsiteData &record : qAsConst(records)) {
+            if (total - freed <= target) {
+                break;
+            }
+            origins.append(record.origin);
+            freed += record.size;
+        }
+
+        profile->removeWebsiteData(AllWebsiteData, origins, [profile, origins, freed, callback] {
+            if (!profile) {
+                return;
+            }
+            profile->d_ptr->evicting = false;
+            emit profile->websiteDataEvicted(origins, freed);
+            if (callback) {
+                callback(freed);
+            }
+        });
+    });
+}
+
+QNetworkProxy QNativeWebProfile::proxy() const
+{
+    return d_ptr->proxy;
+}
+
+void QNativeWebProfile::setProxy(const QNetworkProxy &proxy)
+{
+    d_ptr->proxy = proxy;
+    if (proxy.type() != QNetworkProxy::DefaultProxy && d_ptr->backend->sharesWebsiteData()) {
+        qWarning() << "The proxy of" << this << "applies to the pages of every profile sharing"
+                   << "the default website data store; use a named or ephemeral profile to"
+                   << "proxy only its own pages";
+    }
+    d_ptr->backend->setProxy(proxy);
+}
@@ -0,0 +1,755 @@
+#include "qnativewebreplayproxy.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkCookieJar>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QSet>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrlQuery>
+
+namespace {
+
+typedef QList<QPair<QByteArray, QByteArray>> HeaderList;
+
+// "QNWR"
+const quint32 ArchiveMagic = 0x514e5752;
+const quint32 ArchiveVersion = 1;
+// Offset of the index and the magic again
+const qint64 TrailerSize = 12;
+// Longest request head accepted
+const int MaxHeadSize = 64 * 1024;
+// Bandwidth shaping sends a slice of the rate at this interval
+const int ShapingInterval = 10;
+
+struct ArchiveEntry
+{
+    QByteArray key;
+    qint32 status = 0;
+    QByteArray reason;
+    HeaderList headers;
+    QByteArray body;
+};
+
+QDataStream &operator<<(QDataStream &stream, const ArchiveEntry &entry)
+{
+    stream << entry.key << entry.status << entry.reason << quint32(entry.headers.size());
+    for (const QPair<QByteArray, QByteArray> &header : entry.headers) {
+        stream << header.first << header.second;
+    }
+    return stream << entry.body;
+}
+
+QDataStream &operator>>(QDataStream &stream, ArchiveEntry &entry)
+{
+    quint32 headerCount = 0;
+    stream >> entry.key >> entry.status >> entry.reason >> headerCount;
+    entry.headers.clear();
+    for (quint32 i = 0; i < headerCount && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray name;
+        QByteArray value;
+        stream >> name >> value;
+        entry.headers.append(qMakePair(name, value));
+    }
+    return stream >> entry.body;
+}
+
+// Headers that only concern one connection, not forwarded nor recorded
+bool isHopByHop(const QByteArray &name)
+{
+    static const char *const names[] = {
+        "connection", "keep-alive", "proxy-connection", "proxy-authenticate",
+        "proxy-authorization", "te", "trailer", "transfer-encoding", "upgrade"
+    };
+    for (const char *hopByHop : names) {
+        if (qstricmp(name.constData(), hopByHop) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QByteArray headerValue(const HeaderList &headers, const char *name)
+{
+    for (const QPair<QByteArray, QByteArray> &header : headers) {
+        if (qstricmp(header.first.constData(), name) == 0) {
+            return header.second;
+        }
+    }
+    return QByteArray();
+}
+
+QByteArray requestKey(const QByteArray &method, QUrl url, const QByteArray &body,
+                      const QStringList &ignoredQueryParameters)
+{
+    if (!ignoredQueryParameters.isEmpty() && url.hasQuery()) {
+        QUrlQuery query(url);
+        for (const QString &name : ignoredQueryParameters) {
+            query.removeAllQueryItems(name);
+        }
+        // No "?" is left when every parameter is ignored
+        url.setQuery(query.isEmpty() ? QString() : query.query(QUrl::FullyEncoded),
+                     QUrl::StrictMode);
+    }
+    QByteArray key = method + ' ' + url.adjusted(QUrl::RemoveFragment).toEncoded();
+    if (!body.isEmpty()) {
+        key += ' ' + QCryptographicHash::hash(body, QCryptographicHash::Sha1).toHex();
+    }
+    return key;
+}
+
+// Responses by request key in an archive file:
+//
+//     magic, version, entries..., index, index offset, magic
+//
+// The index lists the offsets of the entries of every key in recording order.
+// It is written when recording stops; an archive without one, e.g. after a
+// crash, is indexed by reading all of its entries.
+class ReplayArchive
+{
+public:
+    bool create(const QString &path, QString *error);
+    bool open(const QString &path, QString *error);
+    void close();
+
+    bool isRecording() const { return m_recording; }
+    int count() const { return m_count; }
+
+    void append(const ArchiveEntry &entry);
+    // The next response for key, false if the archive has none
+    bool next(const QByteArray &key, ArchiveEntry *entry);
+
+private:
+    bool readIndex();
+    void scanEntries();
+
+    QFile m_file;
+    QDataStream m_stream;
+    bool m_recording = false;
+    int m_count = 0;
+    QHash<QByteArray, QVector<qint64>> m_index;
+    // Responses served so far by key
+    QHash<QByteArray, int> m_served;
+};
+
+bool ReplayArchive::create(const QString &path, QString *error)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = m_file.errorString();
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_5_0);
+    m_stream << ArchiveMagic << ArchiveVersion;
+    m_recording = true;
+    return true;
+}
+
+bool ReplayArchive::open(const QString &path, QString *error)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        *error = m_file.errorString();
+        return false;
+    }
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    m_stream >> magic >> version;
+    if (magic != ArchiveMagic || version != ArchiveVersion) {
+        *error = QStringLiteral("%1 is not a replay archive").arg(path);
+        close();
+        return false;
+    }
+    if (!readIndex()) {
+        scanEntries();
+    }
+    return true;
+}
+
+bool ReplayArchive::readIndex()
+{
+    const qint64 size = m_file.size();
+    if (size < 8 + TrailerSize || !m_file.seek(size - TrailerSize)) {
+        return false;
+    }
+    qint64 indexOffset = 0;
+    quint32 magic = 0;
+    m_stream >> indexOffset >> magic;
+    if (magic != ArchiveMagic || indexOffset < 8 || indexOffset > size - TrailerSize
+        || !m_file.seek(indexOffset)) {
+        return false;
+    }
+
+    quint32 keys = 0;
+    m_stream >> keys;
+    for (quint32 i = 0; i < keys && m_stream.status() == QDataStream::Ok; ++i) {
+        QByteArray key;
+        QVector<qint64> offsets;
+        m_stream >> key >> offsets;
+        m_count += offsets.size();
+        m_index.insert(key, offsets);
+    }
+    if (m_stream.status() != QDataStream::Ok) {
+        m_stream.resetStatus();
+        m_index.clear();
+        m_count = 0;
+        return false;
+    }
+    return true;
+}
+
+void ReplayArchive::scanEntries()
+{
+    m_file.seek(8);
+    ArchiveEntry entry;
+    while (!m_file.atEnd()) {
+        const qint64 offset = m_file.pos();
+        m_stream >> entry;
+        if (m_stream.status() != QDataStream::Ok) {
+            // A truncated last entry
+            m_stream.resetStatus();
+            break;
+        }
+        m_index[entry.key].append(offset);
+        ++m_count;
+    }
+}
+
+void ReplayArchive::close()
+{
+    if (m_recording) {
+        const qint64 indexOffset = m_file.pos();
+        m_stream << quint32(m_index.size());
+        for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+            m_stream << it.key() << it.value();
+        }
+        m_stream << indexOffset << ArchiveMagic;
+    }
+    m_stream.setDevice(nullptr);
+    m_file.close();
+    m_recording = false;
+    m_count = 0;
+    m_index.clear();
+    m_served.clear();
+}
+
+void ReplayArchive::append(const ArchiveEntry &entry)
+{
+    if (!m_recording) {
+        return;
+    }
+    m_index[entry.key].append(m_file.pos());
+    m_stream << entry;
+    // Entries of a crashed run are recovered by scanEntries()
+    m_file.flush();
+    ++m_count;
+}
+
+bool ReplayArchive::next(const QByteArray &key, ArchiveEntry *entry)
+{
+    const auto it = m_index.constFind(key);
+    if (m_recording || it == m_index.cend() || it->isEmpty()) {
+        return false;
+    }
+    int &served = m_served[key];
+    const qint64 offset = it->at(qMin(served, it->size() - 1));
+    ++served;
+    if (!m_file.seek(offset)) {
+        return false;
+    }
+    m_stream >> *entry;
+    if (m_stream.status() != QDataStream::Ok) {
+        m_stream.resetStatus();
+        return false;
+    }
+    return true;
+}
+
+class NullCookieJar : public QNetworkCookieJar
+{
+public:
+    using QNetworkCookieJar::QNetworkCookieJar;
+
+    // The pages send and store their own cookies
+    QList<QNetworkCookie> cookiesForUrl(const QUrl &) const override { return {}; }
+    bool setCookiesFromUrl(const QList<QNetworkCookie> &, const QUrl &) override
+    {
+        return false;
+    }
+};
+
+} // namespace
+
+class QNativeWebReplayConnection;
+
+class QNativeWebReplayProxyPrivate
+{
+public:
+    struct Request
+    {
+        QByteArray method;
+        QUrl url;
+        HeaderList headers;
+        QByteArray body;
+    };
+
+    void handle(QNativeWebReplayConnection *connection, const Request &request);
+    void record(QNativeWebReplayConnection *connection, const Request &request,
+                const QByteArray &key);
+    void replay(QNativeWebReplayConnection *connection, const Request &request,
+                const QByteArray &key);
+
+    QNativeWebReplayProxy *q_ptr = nullptr;
+    QNativeWebReplayProxy::Mode mode = QNativeWebReplayProxy::Record;
+    QTcpServer server;
+    ReplayArchive archive;
+    QNetworkAccessManager *network = nullptr;
+    QSet<QNativeWebReplayConnection *> connections;
+    QString errorString;
+    int latency = 0;
+    qint64 bandwidth = 0;
+    QStringList ignoredQueryParameters;
+    QNativeWebReplayProxyStatistics statistics;
+};
+
+// One client connection: reads its requests one at a time, hands them to the
+// proxy and writes the responses, shaped as configured
+class QNativeWebReplayConnection : public QObject
+{
+public:
+    QNativeWebReplayConnection(QTcpSocket *socket, QNativeWebReplayProxyPrivate *proxy);
+    ~QNativeWebReplayConnection();
+
+    void respond(int status, const QByteArray &reason, const HeaderList &headers,
+                 const QByteArray &body, bool shaped);
+    void respondError(int status, const QByteArray &reason);
+
+private:
+    void readRequests();
+    void tunnel(const QByteArray &authority);
+    void writeShaped();
+    void finishResponse();
+
+    QNativeWebReplayProxyPrivate *m_proxy;
+    QTcpSocket *m_socket;
+    QByteArray m_buffer;
+    // A request is handled, following ones wait in m_buffer
+    bool m_busy = false;
+    bool m_closeAfterResponse = false;
+    QByteArray m_pending;
+    QTimer m_shaping;
+    QTcpSocket *m_upstream = nullptr;
+    bool m_tunnelOpen = false;
+};
+
+QNativeWebReplayConnection::QNativeWebReplayConnection(QTcpSocket *socket,
+                                                       QNativeWebReplayProxyPrivate *proxy)
+    : QObject(proxy->q_ptr), m_proxy(proxy), m_socket(socket)
+{
+    socket->setParent(this);
+    m_proxy->connections.insert(this);
+    m_shaping.setInterval(ShapingInterval);
+    connect(&m_shaping, &QTimer::timeout, this, [this] { writeShaped(); });
+    connect(socket, &QTcpSocket::readyRead, this, [this] { readRequests(); });
+    connect(socket, &QTcpSocket::disconnected, this, &QObject::deleteLater);
+}
+
+QNativeWebReplayConnection::~QNativeWebReplayConnection()
+{
+    m_proxy->connections.remove(this);
+}
+
+void QNativeWebReplayConnection::readRequests()
+{
+    if (m_upstream) {
+        if (m_tunnelOpen) {
+            m_upstream->write(m_socket->readAll());
+        } else {
+            m_buffer += m_socket->readAll();
+        }
+        return;
+    }
+    m_buffer += m_socket->readAll();
+    if (m_busy) {
+        return;
+    }
+
+    const int headEnd = m_buffer.indexOf("\r\n\r\n");
+    if (headEnd < 0) {
+        if (m_buffer.size() > MaxHeadSize) {
+            m_closeAfterResponse = true;
+            respondError(431, "Request Header Fields Too Large");
+        }
+        return;
+    }
+
+    const QList<QByteArray> lines = m_buffer.left(headEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() != 3) {
+        m_buffer.clear();
+        m_closeAfterResponse = true;
+        respondError(400, "Bad Request");
+        return;
+    }
+
+    QNativeWebReplayProxyPrivate::Request request;
+    request.method = requestLine.at(0);
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines.at(i).indexOf(':');
+        if (colon > 0) {
+            request.headers.append(qMakePair(lines.at(i).left(colon).trimmed(),
+                                             lines.at(i).mid(colon + 1).trimmed()));
+        }
+    }
+
+    if (request.method == "CONNECT") {
+        m_buffer.remove(0, headEnd + 4);
+        tunnel(requestLine.at(1));
+        return;
+    }
+
+    if (!headerValue(request.headers, "transfer-encoding").isEmpty()) {
+        m_buffer.clear();
+        m_closeAfterResponse = true;
+        respondError(411, "Length Required");
+        return;
+    }
+    const int bodySize = headerValue(request.headers, "content-length").toInt();
+    if (m_buffer.size() < headEnd + 4 + bodySize) {
+        return;
+    }
+    request.body = m_buffer.mid(headEnd + 4, bodySize);
+    m_buffer.remove(0, headEnd + 4 + bodySize);
+
+    // Absolute form from browsers, origin form when asked directly
+    const QByteArray target = requestLine.at(1);
+    request.url = target.startsWith('/')
+            ? QUrl::fromEncoded("http://" + headerValue(request.headers, "host") + target)
+            : QUrl::fromEncoded(target);
+    const QByteArray connection = headerValue(request.headers, "connection").toLower()
+            + headerValue(request.headers, "proxy-connection").toLower();
+    m_closeAfterResponse = requestLine.at(2) == "HTTP/1.0" ? !connection.contains("keep-alive")
+                                                           : connection.contains("close");
+    if (!request.url.isValid() || request.url.host().isEmpty()) {
+        m_closeAfterResponse = true;
+        respondError(400, "Bad Request");
+        return;
+    }
+
+    m_busy = true;
+    m_proxy->handle(this, request);
+}
+
+void QNativeWebReplayConnection::tunnel(const QByteArray &authority)
+{
+    ++m_proxy->statistics.tunnels;
+    m_closeAfterResponse = true;
+    if (m_proxy->mode == QNativeWebReplayProxy::Replay) {
+        respondError(502, "Bad Gateway");
+        return;
+    }
+
+    const int colon = authority.lastIndexOf(':');
+    m_busy = true;
+    m_upstream = new QTcpSocket(this);
+    connect(m_upstream, &QTcpSocket::connected, this, [this] {
+        m_tunnelOpen = true;
+        m_socket->write("HTTP/1.1 200 Connection Established\r\n\r\n");
+        m_upstream->write(m_buffer);
+        m_buffer.clear();
+    });
+    connect(m_upstream, &QTcpSocket::readyRead, this,
+            [this] { m_socket->write(m_upstream->readAll()); });
+    connect(m_upstream, &QTcpSocket::stateChanged, this,
+            [this](QAbstractSocket::SocketState state) {
+                if (state != QAbstractSocket::UnconnectedState) {
+                    return;
+                }
+                if (!m_tunnelOpen) {
+                    m_socket->write("HTTP/1.1 502 Bad Gateway\r\nContent-Length: 0\r\n\r\n");
+                }
+                m_socket->disconnectFromHost();
+            });
+    m_upstream->connectToHost(QString::fromLatin1(authority.left(colon)),
+                              quint16(authority.mid(colon + 1).toUInt()));
+}
+
+void QNativeWebReplayConnection::respond(int status, const QByteArray &reason,
+                                         const HeaderList &headers, const QByteArray &body,
+                                         bool shaped)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason + "\r\n";
+    for (const QPair<QByteArray, QByteArray> &header : headers) {
+        response += header.first + ": " + header.second + "\r\n";
+    }
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += m_closeAfterResponse ? "Connection: close\r\n\r\n"
+                                     : "Connection: keep-alive\r\n\r\n";
+    response += body;
+    m_proxy->statistics.bytesServed += body.size();
+
+    if (!shaped || (m_proxy->latency <= 0 && m_proxy->bandwidth <= 0)) {
+        m_socket->write(response);
+        finishResponse();
+        return;
+    }
+    m_pending = response;
+    QTimer::singleShot(qMax(0, m_proxy->latency), this, [this] {
+        if (m_proxy->bandwidth <= 0) {
+            m_socket->write(m_pending);
+            m_pending.clear();
+            finishResponse();
+            return;
+        }
+        writeShaped();
+        m_shaping.start();
+    });
+}
+
+void QNativeWebReplayConnection::respondError(int status, const QByteArray &reason)
+{
+    respond(status, reason, { qMakePair(QByteArray("Content-Type"), QByteArray("text/plain")) },
+            reason + '\n', false);
+}
+
+void QNativeWebReplayConnection::writeShaped()
+{
+    const qint64 slice = qMax<qint64>(1, m_proxy->bandwidth * ShapingInterval / 1000);
+    m_socket->write(m_pending.left(int(qMin<qint64>(slice, m_pending.size()))));
+    m_pending.remove(0, int(qMin<qint64>(slice, m_pending.size())));
+    if (m_pending.isEmpty()) {
+        m_shaping.stop();
+        finishResponse();
+    }
+}
+
+void QNativeWebReplayConnection::finishResponse()
+{
+    m_busy = false;
+    if (m_closeAfterResponse) {
+        m_socket->disconnectFromHost();
+        return;
+    }
+    // The next request may be buffered already
+    if (!m_buffer.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this] { readRequests(); }, Qt::QueuedConnection);
+    }
+}
+
+void QNativeWebReplayProxyPrivate::handle(QNativeWebReplayConnection *connection,
+                                          const Request &request)
+{
+    ++statistics.requests;
+    const QByteArray key =
+            requestKey(request.method, request.url, request.body, ignoredQueryParameters);
+    if (mode == QNativeWebReplayProxy::Record) {
+        record(connection, request, key);
+    } else {
+        replay(connection, request, key);
+    }
+}
+
+void QNativeWebReplayProxyPrivate::record(QNativeWebReplayConnection *connection,
+                                          const Request &request, const QByteArray &key)
+{
+    QNetworkRequest forwarded(request.url);
+    for (const QPair<QByteArray, QByteArray> &header : request.headers) {
+        if (!isHopByHop(header.first) && qstricmp(header.first.constData(), "host") != 0) {
+            forwarded.setRawHeader(header.first, header.second);
+        }
+    }
+    // Without it the network access manager asks for gzip and decodes it
+    if (!forwarded.hasRawHeader("Accept-Encoding")) {
+        forwarded.setRawHeader("Accept-Encoding", "identity");
+    }
+    // Redirects are recorded and followed by the page
+    forwarded.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                           QNetworkRequest::ManualRedirectPolicy);
+
+    QNetworkReply *reply = network->sendCustomRequest(forwarded, request.method, request.body);
+    QPointer<QNativeWebReplayConnection> target = connection;
+    QObject::connect(reply, &QNetworkReply::finished, q_ptr, [this, reply, target, key] {
+        reply->deleteLater();
+        const QVariant status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+        if (!status.isValid()) {
+            if (target) {
+                target->respondError(502, "Bad Gateway");
+            }
+            return;
+        }
+
+        ArchiveEntry entry;
+        entry.key = key;
+        entry.status = status.toInt();
+        entry.reason = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray();
+        for (const QPair<QByteArray, QByteArray> &header : reply->rawHeaderPairs()) {
+            if (isHopByHop(header.first)
+                || qstricmp(header.first.constData(), "content-length") == 0) {
+                continue;
+            }
+            // Repeated headers are joined, Set-Cookie with newlines
+            for (const QByteArray &value : header.second.split('\n')) {
+                entry.headers.append(qMakePair(header.first, value));
+            }
+        }
+        entry.body = reply->readAll();
+        archive.append(entry);
+        ++statistics.recorded;
+        if (target) {
+            target->respond(entry.status, entry.reason, entry.headers, entry.body, false);
+        }
+    });
+}
+
+void QNativeWebReplayProxyPrivate::replay(QNativeWebReplayConnection *connection,
+                                          const Request &request, const QByteArray &key)
+{
+    ArchiveEntry entry;
+    if (!archive.next(key, &entry)) {
+        ++statistics.missed;
+        connection->respondError(404, "Not Found");
+        emit q_ptr->requestMissed(QString::fromLatin1(request.method), request.url);
+        return;
+    }
+    ++statistics.replayed;
+    connection->respond(entry.status, entry.reason, entry.headers, entry.body, true);
+}
+
+QNativeWebReplayProxy::QNativeWebReplayProxy(QObject *parent)
+    : QObject(parent), d_ptr(new QNativeWebReplayProxyPrivate)
+{
+    QNativeWebReplayProxyPrivate *d = d_ptr;
+    d->q_ptr = this;
+    d->network = new QNetworkAccessManager(this);
+    d->network->setCookieJar(new NullCookieJar(d->network));
+    connect(&d->server, &QTcpServer::newConnection, this, [d] {
+        while (QTcpSocket *socket = d->server.nextPendingConnection()) {
+            new QNativeWebReplayConnection(socket, d);
+        }
+    });
+}
+
+QNativeWebReplayProxy::~QNativeWebReplayProxy()
+{
+    stop();
+    delete d_ptr;
+}
+
+bool QNativeWebReplayProxy::start(Mode mode, const QString &archivePath, quint16 port)
+{
+    QNativeWebReplayProxyPrivate *d = d_ptr;
+    stop();
+    d->mode = mode;
+    const bool opened = mode == Record ? d->archive.create(archivePath, &d->errorString)
+                                       : d->archive.open(archivePath, &d->errorString);
+    if (!opened) {
+        return false;
+    }
+    if (!d->server.listen(QHostAddress::LocalHost, port)) {
+        d->errorString = d->server.errorString();
+        d->archive.close();
+        return false;
+    }
+    d->errorString.clear();
+    return true;
+}
+
+void QNativeWebReplayProxy::stop()
+{
+    QNativeWebReplayProxyPrivate *d = d_ptr;
+    d->server.close();
+    // Recordings still on their way are not archived
+    const QList<QNetworkReply *> replies = d->network->findChildren<QNetworkReply *>();
+    for (QNetworkReply *reply : replies) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+    qDeleteAll(d->connections.values());
+    d->archive.close();
+}
+
+bool QNativeWebReplayProxy::isRunning() const
+{
+    return d_ptr->server.isListening();
+}
+
+QNativeWebReplayProxy::Mode QNativeWebReplayProxy::mode() const
+{
+    return d_ptr->mode;
+}
+
+quint16 QNativeWebReplayProxy::port() const
+{
+    return d_ptr->server.serverPort();
+}
+
+QNetworkProxy QNativeWebReplayProxy::networkProxy() const
+{
+    if (!isRunning()) {
+        return QNetworkProxy(QNetworkProxy::DefaultProxy);
+    }
+    return QNetworkProxy(QNetworkProxy::HttpProxy, QStringLiteral("127.0.0.1"), port());
+}
+
+QString QNativeWebReplayProxy::errorString() const
+{
+    return d_ptr->errorString;
+}
+
+int QNativeWebReplayProxy::entryCount() const
+{
+    return d_ptr->archive.count();
+}
+
+int QNativeWebReplayProxy::latency() const
+{
+    return d_ptr->latency;
+}
+
+void QNativeWebReplayProxy::setLatency(int msecs)
+{
+    d_ptr->latency = qMax(0, msecs);
+}
+
+qint64 QNativeWebReplayProxy::bandwidth() const
+{
+    return d_ptr->bandwidth;
+}
+
+void QNativeWebReplayProxy::setBandwidth(qint64 bytesPerSecond)
+{
+    d_ptr->bandwidth = qMax<qint64>(0, bytesPerSecond);
+}
+
+QStringList QNativeWebReplayProxy::ignoredQueryParameters() const
+{
+    return d_ptr->ignoredQueryParameters;
+}
+
+void QNativeWebReplayProxy::setIgnoredQueryParameters(const QStringList &names)
+{
+    d_ptr->ignoredQueryParameters = names;
+}
+
+QNativeWebReplayProxyStatistics QNativeWebReplayProxy::statistics() const
+{
+    return d_ptr->statistics;
+}
+
+void QNativeWebReplayProxy::resetStatistics()
+{
+    d_ptr->statistics = QNativeWebReplayProxyStatistics();
+}
@@ -0,0 +1,446 @@
+#include "qnativewebscheduler.h"
+#include "qnativewebpage.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QQueue>
+#include <QStringList>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+// Four buckets per power of two, which gives ~19% resolution up to ~9 hours
+const int LatencyBuckets = 100;
+
+int latencyBucket(qint64 msecs)
+{
+    if (msecs < 1) {
+        return 0;
+    }
+    const int bucket = int(std::log2(double(msecs)) * 4) + 1;
+    return qMin(bucket, LatencyBuckets - 1);
+}
+
+int bucketUpperBound(int bucket)
+{
+    if (bucket == 0) {
+        return 0;
+    }
+    return int(std::ceil(std::exp2(bucket / 4.0)));
+}
+
+struct Entry
+{
+    quint64 id = 0;
+    QNativeWebJob job;
+    QString host;
+    int attempt = 0;
+    // Scheduler clock at the first dispatch, so retries count towards latency
+    qint64 firstDispatch = -1;
+};
+
+struct Slot
+{
+    QNativeWebPage *page = nullptr;
+    QTimer *timer = nullptr;
+    bool busy = false;
+    bool loadStarted = false;
+    int jobsServed = 0;
+    // Bumped whenever a job ends, to drop late signals and script results
+    quint64 generation = 0;
+    Entry entry;
+    QList<QMetaObject::Connection> connections;
+};
+
+} // namespace
+
+class QNativeWebSchedulerPrivate
+{
+public:
+    explicit QNativeWebSchedulerPrivate(QNativeWebScheduler *q) : q_ptr(q) { }
+    ~QNativeWebSchedulerPrivate();
+
+    void enqueue(const Entry &entry, bool front);
+    void schedule();
+    bool takeNext(Entry *entry);
+    Slot *acquireSlot();
+    QNativeWebPage *createPage();
+    void start(Slot *slot, const Entry &entry);
+    void finish(Slot *slot, bool ok, const QVariant &result, const QString &error);
+    int percentile(double fraction) const;
+
+    QNativeWebScheduler *q_ptr;
+
+    int m_maxConcurrentJobs = 4;
+    int m_maxJobsPerHost = 2;
+    int m_maxRetries = 2;
+    int m_retryBackoff = 1000;
+    int m_jobsPerPage = 100;
+    QNativeWebSettings::PerformanceProfile m_profile =
+            QNativeWebSettings::LightweightViewerProfile;
+
+    quint64 m_nextId = 1;
+    // Pending entries per host, and the hosts that have any in round-robin order
+    QHash<QString, QQueue<Entry>> m_hostQueues;
+    QStringList m_hostOrder;
+    QHash<QString, int> m_activePerHost;
+    int m_pending = 0;
+    int m_delayed = 0;
+    int m_active = 0;
+    quint64 m_clearEpoch = 0;
+    QList<Slot *> m_pool;
+
+    QElapsedTimer m_clock;
+    quint64 m_succeeded = 0;
+    quint64 m_failed = 0;
+    quint64 m_retried = 0;
+    quint64 m_latencyHistogram[LatencyBuckets] = {};
+    double m_latencySum = 0;
+    int m_maxLatency = 0;
+};
+
+QNativeWebSchedulerPrivate::~QNativeWebSchedulerPrivate()
+{
+    for (Slot *slot : qAsConst(m_pool)) {
+        delete slot->page;
+        delete slot;
+    }
+}
+
+void QNativeWebSchedulerPrivate::enqueue(const Entry &entry, bool front)
+{
+    QQueue<Entry> &queue = m_hostQueues[entry.host];
+    if (queue.isEmpty()) {
+        m_hostOrder.append(entry.host);
+    }
+    if (front) {
+        queue.prepend(entry);
+    } else {
+        queue.enqueue(entry);
+    }
+    ++m_pending;
+}
+
+void QNativeWebSchedulerPrivate::schedule()
+{
+    while (m_active < m_maxConcurrentJobs && m_pending > 0) {
+        Entry entry;
+        if (!takeNext(&entry)) {
+            // Every host with pending jobs is at its limit
+            break;
+        }
+        start(acquireSlot(), entry);
+    }
+}
+
+bool QNativeWebSchedulerPrivate::takeNext(Entry *entry)
+{
+    const int hosts = m_hostOrder.size();
+    for (int i = 0; i < hosts; ++i) {
+        const QString host = m_hostOrder.takeFirst();
+        if (m_activePerHost.value(host) < m_maxJobsPerHost) {
+            QQueue<Entry> &queue = m_hostQueues[host];
+            *entry = queue.dequeue();
+            --m_pending;
+            if (queue.isEmpty()) {
+                m_hostQueues.remove(host);
+            } else {
+                m_hostOrder.append(host);
+            }
+            return true;
+        }
+        m_hostOrder.append(host);
+    }
+    return false;
+}
+
+Slot *QNativeWebSchedulerPrivate::acquireSlot()
+{
+    for (Slot *slot : qAsConst(m_pool)) {
+        if (!slot->busy) {
+            if (slot->jobsServed >= m_jobsPerPage) {
+                delete slot->page;
+                slot->page = createPage();
+                slot->jobsServed = 0;
+            }
+            return slot;
+        }
+    }
+
+    Slot *slot = new Slot;
+    slot->page = createPage();
+    slot->timer = new QTimer(q_ptr);
+    slot->timer->setSingleShot(true);
+    QObject::connect(slot->timer, &QTimer::timeout, q_ptr,
+                     [this, slot] { finish(slot, false, QVariant(), QStringLiteral("Timeout")); });
+    m_pool.append(slot);
+    return slot;
+}
+
+QNativeWebPage *QNativeWebSchedulerPrivate::createPage()
+{
+    QNativeWebPage *page = new QNativeWebPage(q_ptr);
+    page->settings()->applyPerformanceProfile(m_profile);
+    return page;
+}
+
+void QNativeWebSchedulerPrivate::start(Slot *slot, const Entry &entry)
+{
+    slot->busy = true;
+    slot->loadStarted = false;
+    slot->entry = entry;
+    if (slot->entry.firstDispatch < 0) {
+        slot->entry.firstDispatch = m_clock.elapsed();
+    }
+    ++slot->jobsServed;
+    ++m_active;
+    ++m_activePerHost[entry.host];
+
+    const quint64 generation = slot->generation;
+    QNativeWebPage *page = slot->page;
+    slot->connections << QObject::connect(page, &QNativeWebPage::loadStarted, q_ptr,
+                                          [slot] { slot->loadStarted = true; });
+    slot->connections << QObject::connect(
+            page, &QNativeWebPage::loadFinished, q_ptr, [this, slot, generation](bool ok) {
+                // Ignore the tail of the page's previous navigation
+                if (!slot->loadStarted || slot->generation != generation) {
+                    return;
+                }
+                slot->loadStarted = false;
+                if (!ok) {
+                    finish(slot, false, QVariant(), slot->page->errorString());
+                    return;
+                }
+                if (slot->entry.job.script.isEmpty()) {
+                    finish(slot, true, QVariant(), QString());
+                    return;
+                }
+                slot->page->evaluateJavaScript(
+                        slot->entry.job.script, [this, slot, generation](const QVariant &result) {
+                            if (slot->generation == generation) {
+                                finish(slot, true, result, QString());
+                            }
+                        });
+            });
+
+    slot->timer->start(entry.job.timeout);
+    page->load(entry.job.url);
+}
+
+void QNativeWebSchedulerPrivate::finish(Slot *slot, bool ok, const QVariant &result,
+                                        const QString &error)
+{
+    for (const QMetaObject::Connection &connection : qAsConst(slot->connections)) {
+        QObject::disconnect(connection);
+    }
+    slot->connections.clear();
+    slot->timer->stop();
+    slot->busy = false;
+    ++slot->generation;
+    if (!ok) {
+        slot->page->stop();
+    }
+
+    const Entry entry = slot->entry;
+    --m_active;
+    if (--m_activePerHost[entry.host] <= 0) {
+        m_activePerHost.remove(entry.host);
+    }
+
+    if (!ok && entry.attempt < m_maxRetries) {
+        Entry retry = entry;
+        ++retry.attempt;
+        ++m_retried;
+        ++m_delayed;
+        const int delay = m_retryBackoff * (1 << qMin(retry.attempt - 1, 16));
+        const quint64 epoch = m_clearEpoch;
+        QTimer::singleShot(delay, q_ptr, [this, retry, epoch] {
+            if (epoch != m_clearEpoch) {
+                return;
+            }
+            --m_delayed;
+            enqueue(retry, true);
+            schedule();
+        });
+    } else {
+        const qint64 latency = qMax<qint64>(0, m_clock.elapsed() - entry.firstDispatch);
+        ++m_latencyHistogram[latencyBucket(latency)];
+        m_latencySum += latency;
+        m_maxLatency = qMax(m_maxLatency, int(latency));
+        if (ok) {
+            ++m_succeeded;
+        } else {
+            ++m_failed;
+        }
+        emit q_ptr->jobFinished(entry.id, entry.job.url, ok, result, error);
+    }
+
+    schedule();
+    if (m_active == 0 && m_pending == 0 && m_delayed == 0) {
+        emit q_ptr->idle();
+    }
+}
+
+int QNativeWebSchedulerPrivate::percentile(double fraction) const
+{
+    const quint64 total = m_succeeded + m_failed;
+    if (total == 0) {
+        return 0;
+    }
+    const quint64 target = quint64(std::ceil(fraction * total));
+    quint64 count = 0;
+    for (int i = 0; i < LatencyBuckets; ++i) {
+        count += m_latencyHistogram[i];
+        if (count >= target) {
+            return qMin(bucketUpperBound(i), m_maxLatency);
+        }
+    }
+    return m_maxLatency;
+}
+
+QNativeWebScheduler::QNativeWebScheduler(QObject *parent)
+    : QObject(parent), d_ptr(new QNativeWebSchedulerPrivate(this))
+{
+}
+
+QNativeWebScheduler::~QNativeWebScheduler()
+{
+    delete d_ptr;
+}
+
+int QNativeWebScheduler::maxConcurrentJobs() const
+{
+    return d_ptr->m_maxConcurrentJobs;
+}
+
+void QNativeWebScheduler::setMaxConcurrentJobs(int count)
+{
+    d_ptr->m_maxConcurrentJobs = qMax(1, count);
+    d_ptr->schedule();
+}
+
+int QNativeWebScheduler::maxJobsPerHost() const
+{
+    return d_ptr->m_maxJobsPerHost;
+}
+
+void QNativeWebScheduler::setMaxJobsPerHost(int count)
+{
+    d_ptr->m_maxJobsPerHost = qMax(1, count);
+    d_ptr->schedule();
+}
+
+int QNativeWebScheduler::maxRetries() const
+{
+    return d_ptr->m_maxRetries;
+}
+
+void QNativeWebScheduler::setMaxRetries(int count)
+{
+    d_ptr->m_maxRetries = qMax(0, count);
+}
+
+int QNativeWebScheduler::retryBackoff() const
+{
+    return d_ptr->m_retryBackoff;
+}
+
+void QNativeWebScheduler::setRetryBackoff(int msecs)
+{
+    d_ptr->m_retryBackoff = qMax(0, msecs);
+}
+
+int QNativeWebScheduler::jobsPerPage() const
+{
+    return d_ptr->m_jobsPerPage;
+}
+
+void QNativeWebScheduler::setJobsPerPage(int count)
+{
+    d_ptr->m_jobsPerPage = qMax(1, count);
+}
+
+QNativeWebSettings::PerformanceProfile QNativeWebScheduler::performanceProfile() const
+{
+    return d_ptr->m_profile;
+}
+
+void QNativeWebScheduler::setPerformanceProfile(QNativeWebSettings::PerformanceProfile profile)
+{
+    d_ptr->m_profile = profile;
+    for (Slot *slot : qAsConst(d_ptr->m_pool)) {
+        slot->page->settings()->applyPerformanceProfile(profile);
+    }
+}
+
+quint64 QNativeWebScheduler::enqueue(const QNativeWebJob &job)
+{
+    if (!d_ptr->m_clock.isValid()) {
+        d_ptr->m_clock.start();
+    }
+
+    Entry entry;
+    entry.id = d_ptr->m_nextId++;
+    entry.job = job;
+    entry.host = job.url.host().toLower();
+    d_ptr->enqueue(entry, false);
+    d_ptr->schedule();
+    return entry.id;
+}
+
+void QNativeWebScheduler::clear()
+{
+    d_ptr->m_hostQueues.clear();
+    d_ptr->m_hostOrder.clear();
+    d_ptr->m_pending = 0;
+    d_ptr->m_delayed = 0;
+    ++d_ptr->m_clearEpoch;
+}
+
+int QNativeWebScheduler::queueDepth() const
+{
+    return d_ptr->m_pending + d_ptr->m_delayed;
+}
+
+int QNativeWebScheduler::activeJobs() const
+{
+    return d_ptr->m_active;
+}
+
+QNativeWebScheduler::Statistics QNativeWebScheduler::statistics() const
+{
+    Statistics stats;
+    stats.succeeded = d_ptr->m_succeeded;
+    stats.failed = d_ptr->m_failed;
+    stats.retried = d_ptr->m_retried;
+    stats.queueDepth = queueDepth();
+    stats.activeJobs = d_ptr->m_active;
+
+    const quint64 finished = d_ptr->m_succeeded + d_ptr->m_failed;
+    if (d_ptr->m_clock.isValid() && d_ptr->m_clock.elapsed() > 0) {
+        stats.throughput = finished * 1000.0 / d_ptr->m_clock.elapsed();
+    }
+    if (finished > 0) {
+        stats.meanLatency = d_ptr->m_latencySum / finished;
+    }
+    stats.p50Latency = d_ptr->percentile(0.5);
+    stats.p90Latency = d_ptr->percentile(0.9);
+    stats.p99Latency = d_ptr->percentile(0.99);
+    stats.maxLatency = d_ptr->m_maxLatency;
+    return stats;
+}
+
+void QNativeWebScheduler::resetStatistics()
+{
+    d_ptr->m_succeeded = 0;
+    d_ptr->m_failed = 0;
+    d_ptr->m_retried = 0;
+    std::fill(std::begin(d_ptr->m_latencyHistogram), std::end(d_ptr->m_latencyHistogram), 0);
+    d_ptr->m_latencySum = 0;
+    d_ptr->m_maxLatency = 0;
+    d_ptr->m_clock.start();
+}
@@ -0,0 +1,145 @@
+#include "qnativewebsettings.h"
+
+class QNativeWebSettingsPrivate
+{
+public:
+    bool javaScriptEnabled = true;
+    bool autoLoadImages = true;
+    bool webGLEnabled = true;
+    bool mediaAutoplayEnabled = true;
+    QNativeWebSettings::HardwareAccelerationPolicy hardwareAccelerationPolicy =
+            QNativeWebSettings::HardwareAccelerationOnDemand;
+    bool smoothScrollingEnabled = true;
+    bool allowFileAccess = true;
+};
+
+QNativeWebSettings::QNativeWebSettings(QObject *parent)
+    : QObject(parent), d_ptr(new QNativeWebSettingsPrivate)
+{
+}
+
+QNativeWebSettings::~QNativeWebSettings()
+{
+    delete d_ptr;
+}
+
+bool QNativeWebSettings::javaScriptEnabled() const
+{
+    return d_ptr->javaScriptEnabled;
+}
+
+void QNativeWebSettings::setJavaScriptEnabled(bool enabled)
+{
+    if (d_ptr->javaScriptEnabled != enabled) {
+        d_ptr->javaScriptEnabled = enabled;
+        emit settingsChanged();
+    }
+}
+
+bool QNativeWebSettings::autoLoadImages() const
+{
+    return d_ptr->autoLoadImages;
+}
+
+void QNativeWebSettings::setAutoLoadImages(bool enabled)
+{
+    if (d_ptr->autoLoadImages != enabled) {
+        d_ptr->autoLoadImages = enabled;
+        emit settingsChanged();
+    }
+}
+
+bool QNativeWebSettings::webGLEnabled() const
+{
+    return d_ptr->webGLEnabled;
+}
+
+void QNativeWebSettings::setWebGLEnabled(bool enabled)
+{
+    if (d_ptr->webGLEnabled != enabled) {
+        d_ptr->webGLEnabled = enabled;
+        emit settingsChanged();
+    }
+}
+
+bool QNativeWebSettings::mediaAutoplayEnabled() const
+{
+    return d_ptr->mediaAutoplayEnabled;
+}
+
+void QNativeWebSettings::setMediaAutoplayEnabled(bool enabled)
+{
+    if (d_ptr->mediaAutoplayEnabled != enabled) {
+        d_ptr->mediaAutoplayEnabled = enabled;
+        emit settingsChanged();
+    }
+}
+
+QNativeWebSettings::HardwareAccelerationPolicy
+QNativeWebSettings::hardwareAccelerationPolicy() const
+{
+    return d_ptr->hardwareAccelerationPolicy;
+}
+
+void QNativeWebSettings::setHardwareAccelerationPolicy(HardwareAccelerationPolicy policy)
+{
+    if (d_ptr->hardwareAccelerationPolicy != policy) {
+        d_ptr->hardwareAccelerationPolicy = policy;
+        emit settingsChanged();
+    }
+}
+
+bool QNativeWebSettings::smoothScrollingEnabled() const
+{
+    return d_ptr->smoothScrollingEnabled;
+}
+
+void QNativeWebSettings::setSmoothScrollingEnabled(bool enabled)
+{
+    if (d_ptr->smoothScrollingEnabled != enabled) {
+        d_ptr->smoothScrollingEnabled = enabled;
+        emit settingsChanged();
+    }
+}
+
+bool QNativeWebSettings::allowFileAccess() const
+{
+    return d_ptr->allowFileAccess;
+}
+
+void QNativeWebSettings::setAllowFileAccess(bool allow)
+{
+    if (d_ptr->allowFileAccess != allow) {
+        d_ptr->allowFileAccess = allow;
+        emit settingsChanged();
+    }
+}
+
+void QNativeWebSettings::applyPerformanceProfile(PerformanceProfile profile)
+{
+    // Write the fields directly so the backend sees a single change
+    switch (profile) {
+    case DefaultProfile:
+        d_ptr->webGLEnabled = true;
+        d_ptr->mediaAutoplayEnabled = true;
+        d_ptr->hardwareAccelerationPolicy = HardwareAccelerationOnDemand;
+        d_ptr->smoothScrollingEnabled = true;
+        break;
+    case LightweightViewerProfile:
+        d_ptr->webGLEnabled = false;
+        d_ptr->mediaAutoplayEnabled = false;
+        d_ptr->hardwareAccelerationPolicy = HardwareAccelerationOnDemand;
+        d_ptr->smoothScrollingEnabled = false;
+        break;
+    case CpuOnlyKioskProfile:
+        // Accelerated compositing without a GPU falls back to llvmpipe,
+        // which costs far more CPU than the non-composited path
+        d_ptr->webGLEnabled = false;
+        d_ptr->mediaAutoplayEnabled = false;
+        d_ptr->hardwareAccelerationPolicy = HardwareAccelerationNever;
+        d_ptr->smoothScrollingEnabled = false;
+        break;
+    }
+
+    emit settingsChanged();
+}
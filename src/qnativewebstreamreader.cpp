@@ -0,0 +1,136 @@
+#include "private/qnativewebstreamreader_p.h"
+
+#include <cstring>
+
+QNativeWebStreamReader *QNativeWebStreamReaderPrivate::create(QObject *owner)
+{
+    return new QNativeWebStreamReader(new QNativeWebStreamReaderPrivate, owner);
+}
+
+void QNativeWebStreamReaderPrivate::append(const QByteArray &chunk)
+{
+    if (finished) {
+        return;
+    }
+    chunks.append(chunk);
+    buffered += chunk.size();
+    emit q_ptr->readyRead();
+}
+
+void QNativeWebStreamReaderPrivate::finish(const QString &error)
+{
+    if (finished) {
+        return;
+    }
+    finished = true;
+    if (!error.isEmpty()) {
+        q_ptr->setErrorString(error);
+    }
+    emit q_ptr->readChannelFinished();
+    emit q_ptr->finished();
+}
+
+void QNativeWebStreamReaderPrivate::grantCredit()
+{
+    crediting = false;
+    const quint64 credit = consumed + quint64(window);
+    if (finished || credit <= granted) {
+        return;
+    }
+    granted = credit;
+    if (creditHandler) {
+        creditHandler(credit);
+    }
+}
+
+QNativeWebStreamReader::QNativeWebStreamReader(QNativeWebStreamReaderPrivate *d, QObject *parent)
+    : QIODevice(parent), d_ptr(d)
+{
+    d_ptr->q_ptr = this;
+    // Chunks are read from where they arrived, without a second buffer
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+QNativeWebStreamReader::~QNativeWebStreamReader()
+{
+    if (d_ptr->releaseHandler) {
+        d_ptr->releaseHandler();
+    }
+    delete d_ptr;
+}
+
+qint64 QNativeWebStreamReader::bytesAvailable() const
+{
+    return d_ptr->buffered + QIODevice::bytesAvailable();
+}
+
+bool QNativeWebStreamReader::atEnd() const
+{
+    return d_ptr->finished && bytesAvailable() == 0;
+}
+
+bool QNativeWebStreamReader::isFinished() const
+{
+    return d_ptr->finished;
+}
+
+int QNativeWebStreamReader::window() const
+{
+    return d_ptr->window;
+}
+
+void QNativeWebStreamReader::setWindow(int chunks)
+{
+    d_ptr->window = qMax(1, chunks);
+    d_ptr->grantCredit();
+}
+
+void QNativeWebStreamReader::cancel()
+{
+    QNativeWebStreamReaderPrivate *d = d_ptr;
+    if (d->finished) {
+        return;
+    }
+    if (d->cancelHandler) {
+        d->cancelHandler();
+    }
+    d->finish(tr("Cancelled"));
+}
+
+qint64 QNativeWebStreamReader::readData(char *data, qint64 maxSize)
+{
+    QNativeWebStreamReaderPrivate *d = d_ptr;
+    if (d->chunks.isEmpty()) {
+        return d->finished ? -1 : 0;
+    }
+
+    qint64 read = 0;
+    const quint64 consumed = d->consumed;
+    while (read < maxSize && !d->chunks.isEmpty()) {
+        const QByteArray &chunk = d->chunks.first();
+        const qint64 size = qMin<qint64>(maxSize - read, chunk.size() - d->offset);
+        std::memcpy(data + read, chunk.constData() + d->offset, size_t(size));
+        read += size;
+        d->offset += int(size);
+        if (d->offset == chunk.size()) {
+            d->chunks.removeFirst();
+            d->offset = 0;
+            ++d->consumed;
+        }
+    }
+    d->buffered -= read;
+
+    // One credit update for all the reads of an event loop iteration
+    if (d->consumed != consumed && !d->crediting) {
+        d->crediting = true;
+        QMetaObject::invokeMethod(this, [d] { d->grantCredit(); }, Qt::QueuedConnection);
+    }
+    return read;
+}
+
+qint64 QNativeWebStreamReader::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
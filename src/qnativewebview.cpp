@@ -1,34 +1,718 @@
 #include "qnativewebview.h"
 
+#include "qnativewebpage.h"
+#include "private/qnativewebview_p.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QWindow>
 
-#ifdef Q_OS_WIN
-#  include "private/qwebview2webview.h"
-#endif
+namespace {
+
+const char DataHandlerName[] = "qnativewebdata";
+
+// Page side of postData(). Listeners get an ArrayBuffer per chunk and
+// { offset, total, last }. Chunks are fetched one after the other from the
+// backend's URL, or pushed by the view after the page acknowledged the previous.
+// Scripts that run before this one can wait for its "qnativewebdata" event.
+const char DataScript[] = R"JS((function() {
+    'use strict';
+    var handlers = window.webkit && window.webkit.messageHandlers;
+    var handler = handlers && handlers.qnativewebdata;
+    if (!handler || window.qnativewebdata) {
+        return;
+    }
+
+    var listeners = {};
+    var pushed = {};
+
+    function deliver(transfer, buffer) {
+        var info = {
+            offset: transfer.offset,
+            total: transfer.total,
+            last: transfer.offset + buffer.byteLength >= transfer.total
+        };
+        transfer.offset += buffer.byteLength;
+        (listeners[transfer.channel] || []).slice().forEach(function(listener) {
+            listener(buffer, info);
+        });
+        return info.last;
+    }
+
+    function fetchChunk(transfer, url, index) {
+        fetch(url + '/' + index).then(function(response) {
+            if (!response.ok) {
+                throw new Error(response.status + ' ' + response.statusText);
+            }
+            return response.arrayBuffer();
+        }).then(function(buffer) {
+            if (!deliver(transfer, buffer)) {
+                fetchChunk(transfer, url, index + 1);
+            }
+        }).catch(function(error) {
+            console.error('qnativewebdata: ' + transfer.channel + ': ' + error.message);
+        });
+    }
+
+    window.qnativewebdata = {
+        addListener: function(channel, listener) {
+            (listeners[channel] = listeners[channel] || []).push(listener);
+        },
+        removeListener: function(channel, listener) {
+            var list = listeners[channel] || [];
+            var position = list.indexOf(listener);
+            if (position >= 0) {
+                list.splice(position, 1);
+            }
+        },
+        __start: function(id, channel, total, url) {
+            var transfer = { channel: channel, total: total, offset: 0 };
+            if (url) {
+                fetchChunk(transfer, url, 0);
+            } else {
+                pushed[id] = transfer;
+            }
+        },
+        __push: function(id, data) {
+            var transfer = pushed[id];
+            if (!transfer) {
+                return;
+            }
+            var binary = atob(data);
+            var bytes = new Uint8Array(binary.length);
+            for (var i = 0; i < binary.length; ++i) {
+                bytes[i] = binary.charCodeAt(i);
+            }
+            if (deliver(transfer, bytes.buffer)) {
+                delete pushed[id];
+            } else {
+                handler.postMessage(String(id));
+            }
+        }
+    };
+    window.dispatchEvent(new Event('qnativewebdata'));
+})();
+)JS";
+
+const char MetricsHandlerName[] = "qnativewebmetrics";
+
+// Collects paint timings, layout shifts, long tasks and the time between
+// animation frames, and sends a snapshot at most once a second while anything
+// changed and when the document is hidden. Entry types the engine does not
+// support are skipped.
+const char MetricsScript[] = R"JS((function() {
+    'use strict';
+    var handlers = window.webkit && window.webkit.messageHandlers;
+    var handler = handlers && handlers.qnativewebmetrics;
+    if (!handler || window.__qnativewebmetrics) {
+        return;
+    }
+    window.__qnativewebmetrics = true;
+
+    // Upper bounds of the frame time buckets in milliseconds, the last is open
+    var bounds = [8, 16, 33, 50, 100, 250];
+    var metrics = {
+        document: Math.random().toString(36).slice(2),
+        fcp: -1,
+        lcp: -1,
+        cls: 0,
+        longTasks: 0,
+        longTaskTime: 0,
+        frames: [0, 0, 0, 0, 0, 0, 0]
+    };
+    var dirty = false;
+
+    function observe(type, callback) {
+        try {
+            new PerformanceObserver(function(list) {
+                list.getEntries().forEach(callback);
+                dirty = true;
+            }).observe({ type: type, buffered: true });
+        } catch (e) {
+        }
+    }
+    observe('paint', function(entry) {
+        if (entry.name === 'first-contentful-paint') {
+            metrics.fcp = entry.startTime;
+        }
+    });
+    observe('largest-contentful-paint', function(entry) {
+        metrics.lcp = entry.startTime;
+    });
+    observe('layout-shift', function(entry) {
+        if (!entry.hadRecentInput) {
+            metrics.cls += entry.value;
+        }
+    });
+    observe('longtask', function(entry) {
+        ++metrics.longTasks;
+        metrics.longTaskTime += entry.duration;
+    });
+
+    var lastFrame = 0;
+    function frame(time) {
+        if (lastFrame) {
+            var delta = time - lastFrame;
+            var bucket = 0;
+            while (bucket < bounds.length && delta > bounds[bucket]) {
+                ++bucket;
+            }
+            ++metrics.frames[bucket];
+            dirty = true;
+        }
+        lastFrame = time;
+        requestAnimationFrame(frame);
+    }
+    requestAnimationFrame(frame);
+
+    function send() {
+        if (!dirty) {
+            return;
+        }
+        dirty = false;
+        metrics.url = location.href;
+        try {
+            handler.postMessage(JSON.stringify(metrics));
+        } catch (e) {
+            // Collection was disabled
+        }
+    }
+    setInterval(send, 1000);
+    window.addEventListener('pagehide', send);
+    document.addEventListener('visibilitychange', function() {
+        // Hidden documents get no frames, the gap is not a frame time
+        lastFrame = 0;
+        if (document.visibilityState === 'hidden') {
+            send();
+        }
+    });
+})();
+)JS";
+
+const char ConsoleHandlerName[] = "qnativewebconsole";
+
+// Wraps the console methods and listens for uncaught errors. Messages are sent
+// in batches a quarter second apart, the caller's location is only looked up
+// from a stack trace for warnings and errors.
+const char ConsoleScript[] = R"JS((function() {
+    'use strict';
+    var handlers = window.webkit && window.webkit.messageHandlers;
+    var handler = handlers && handlers.qnativewebconsole;
+    if (!handler || window.__qnativewebconsole) {
+        return;
+    }
+    window.__qnativewebconsole = true;
+
+    // The native ring keeps fewer, so a full batch drops the oldest in the page
+    var maxBatch = 256;
+    var maxText = 1024;
+    var batch = [];
+    var scheduled = false;
+
+    function text(args) {
+        var parts = [];
+        for (var i = 0; i < args.length; ++i) {
+            var arg = args[i];
+            var json;
+            if (typeof arg !== 'string' && !(arg instanceof Error)) {
+                try {
+                    json = JSON.stringify(arg);
+                } catch (e) {
+                }
+            }
+            parts.push(json === undefined ? String(arg) : json);
+        }
+        return parts.join(' ').slice(0, maxText);
+    }
+
+    // First frame outside of this script, whose functions are named with a
+    // marker, in both "at f (url:line:column)" and "f@url:line:column" traces
+    function __qnwcCaller() {
+        var frames = String(new Error().stack || '').split('\n');
+        for (var i = 0; i < frames.length; ++i) {
+            var match = /([^\s(@]+):(\d+):(\d+)\)?\s*$/.exec(frames[i]);
+            if (match && frames[i].indexOf('__qnwc') < 0) {
+                return [match[1], +match[2], +match[3]];
+            }
+        }
+        return null;
+    }
+
+    function flush() {
+        scheduled = false;
+        if (!batch.length) {
+            return;
+        }
+        var sending = batch;
+        batch = [];
+        try {
+            handler.postMessage(JSON.stringify(sending));
+        } catch (e) {
+            // Capture was turned off
+        }
+    }
+
+    function add(level, message, location) {
+        if (batch.length >= maxBatch) {
+            batch.shift();
+        }
+        location = location || ['', 0, 0];
+        batch.push([level, Date.now(), message, location[0], location[1], location[2]]);
+        if (!scheduled) {
+            scheduled = true;
+            setTimeout(flush, 250);
+        }
+    }
+
+    var levels = { debug: 0, log: 1, info: 1, warn: 2, error: 3 };
+    Object.keys(levels).forEach(function(name) {
+        var original = console[name];
+        if (typeof original !== 'function') {
+            return;
+        }
+        console[name] = function __qnwcConsole() {
+            var level = levels[name];
+            add(level, text(arguments), level >= 2 ? __qnwcCaller() : null);
+            return original.apply(this, arguments);
+        };
+    });
+    window.addEventListener('error', function(event) {
+        add(3, event.message || 'Error',
+            [event.filename || '', event.lineno || 0, event.colno || 0]);
+    });
+    window.addEventListener('unhandledrejection', function(event) {
+        add(3, 'Unhandled rejection: ' + text([event.reason]), null);
+    });
+    window.addEventListener('pagehide', flush);
+})();
+)JS";
+
+const char StreamHandlerName[] = "qnativewebstream";
+
+// Page side of streamJavaScript(). The stream sends "<id>:t:<text>" and
+// "<id>:b:<base64>" chunks, "<id>:e" at the end and "<id>:x:<error>". A chunk
+// is only sent once the reader granted credit for it, so writes wait for the
+// reader instead of queueing the whole result in messages.
+const char StreamScript[] = R"JS((function() {
+    'use strict';
+    var handlers = window.webkit && window.webkit.messageHandlers;
+    var handler = handlers && handlers.qnativewebstream;
+    if (!handler || window.__qnativewebstream) {
+        return;
+    }
+
+    // Characters or bytes per chunk, larger writes are split
+    var ChunkSize = 192 * 1024;
+    var streams = {};
+
+    function post(stream, type, payload) {
+        handler.postMessage(stream.id + ':' + type + (payload === undefined ? '' : ':' + payload));
+    }
+
+    function base64(bytes) {
+        var binary = '';
+        for (var i = 0; i < bytes.length; i += 8192) {
+            binary += String.fromCharCode.apply(null, bytes.subarray(i, i + 8192));
+        }
+        return btoa(binary);
+    }
+
+    // Resolves once the reader has credit for another chunk
+    function credited(stream) {
+        return new Promise(function(resolve, reject) {
+            if (stream.error) {
+                reject(stream.error);
+            } else if (stream.sent < stream.credit) {
+                resolve();
+            } else {
+                stream.waiter = { resolve: resolve, reject: reject };
+            }
+        });
+    }
+
+    function Stream(id) {
+        this.id = id;
+        this.sent = 0;
+        this.credit = 0;
+        this.waiter = null;
+        this.error = null;
+        this.done = false;
+        // Writes are sent in order, each after the previous
+        this.tail = Promise.resolve();
+    }
+
+    Stream.prototype.write = function(data) {
+        var stream = this;
+        if (stream.done || stream.error) {
+            return Promise.reject(stream.error || new Error('The stream is closed'));
+        }
+        var type = 't';
+        var parts = [];
+        if (typeof data === 'string') {
+            for (var i = 0, end; i < data.length; i = end) {
+                end = Math.min(i + ChunkSize, data.length);
+                // Surrogate pairs stay in one chunk
+                var last = data.charCodeAt(end - 1);
+                if (end < data.length && last >= 0xD800 && last <= 0xDBFF) {
+                    --end;
+                }
+                parts.push(data.slice(i, end));
+            }
+        } else {
+            var bytes = data instanceof ArrayBuffer
+                    ? new Uint8Array(data)
+                    : new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+            type = 'b';
+            for (var j = 0; j < bytes.length; j += ChunkSize) {
+                parts.push(bytes.subarray(j, j + ChunkSize));
+            }
+        }
+        parts.forEach(function(part) {
+            stream.tail = stream.tail.then(function() {
+                return credited(stream);
+            }).then(function() {
+                ++stream.sent;
+                post(stream, type, type === 'b' ? base64(part) : part);
+            });
+        });
+        return stream.tail;
+    };
+
+    function fail(stream, error) {
+        stream.error = error;
+        delete streams[stream.id];
+        if (stream.waiter) {
+            stream.waiter.reject(error);
+            stream.waiter = null;
+        }
+    }
+
+    Object.defineProperty(window, '__qnativewebstream', {
+        value: {
+            start: function(id, producer) {
+                var stream = new Stream(id);
+                streams[id] = stream;
+                var writer = { write: stream.write.bind(stream) };
+                Promise.resolve().then(function() {
+                    return producer(writer);
+                }).then(function() {
+                    return stream.tail;
+                }).then(function() {
+                    stream.done = true;
+                    delete streams[id];
+                    post(stream, 'e');
+                }, function(error) {
+                    if (!stream.error) {
+                        fail(stream, error);
+                        post(stream, 'x', String(error && error.message || error));
+                    }
+                });
+            },
+            grant: function(id, credit) {
+                var stream = streams[id];
+                if (stream && credit > stream.credit) {
+                    stream.credit = credit;
+                    if (stream.waiter && stream.sent < stream.credit) {
+                        stream.waiter.resolve();
+                        stream.waiter = null;
+                    }
+                }
+            },
+            cancel: function(id) {
+                if (streams[id]) {
+                    fail(streams[id], new Error('The reader was closed'));
+                }
+            }
+        }
+    });
+})();
+)JS";
 
-#ifdef Q_OS_LINUX
-#  include "private/qlinuxwebview.h"
-#endif
+const char QueryHandlerName[] = "qnativewebquery";
 
-#ifdef Q_OS_MACOS
-#  include "private/qdarwinwebview.h"
-#endif
+// Counts DOM epochs: every batch of mutations and every input or change event
+// starts a new one. Only the first change after a cached query has read the
+// epoch is reported, later ones can not invalidate anything more.
+const char QueryScript[] = R"JS((function() {
+    'use strict';
+    var handlers = window.webkit && window.webkit.messageHandlers;
+    var handler = handlers && handlers.qnativewebquery;
+    if (!handler || window.__qnativewebquery) {
+        return;
+    }
+
+    var document_ = Math.random().toString(36).slice(2);
+    var epoch = 0;
+    var armed = false;
+
+    function bump() {
+        ++epoch;
+        if (armed) {
+            armed = false;
+            try {
+                handler.postMessage(document_ + ':' + epoch);
+            } catch (e) {
+                // The cache was turned off
+            }
+        }
+    }
+
+    Object.defineProperty(window, '__qnativewebquery', {
+        value: {
+            arm: function() {
+                armed = true;
+                return document_ + ':' + epoch;
+            }
+        }
+    });
+    new MutationObserver(bump).observe(document, {
+        subtree: true,
+        childList: true,
+        attributes: true,
+        characterData: true
+    });
+    // Form values change without mutations
+    document.addEventListener('input', bump, true);
+    document.addEventListener('change', bump, true);
+})();
+)JS";
+
+const char VirtualTimeHandlerName[] = "qnativewebvirtualtime";
+
+// Replaces the page's clocks and timers with a virtual clock that only moves
+// when advanced. An advance runs the due timers in order, one virtual instant
+// per task so promise reactions settle in between, and reports
+// "<advance>:<virtual time>" once the target is reached.
+const char VirtualTimeScript[] = R"JS((function() {
+    'use strict';
+    var handlers = window.webkit && window.webkit.messageHandlers;
+    var handler = handlers && handlers.qnativewebvirtualtime;
+    if (!handler || window.__qnativewebvirtualtime) {
+        return;
+    }
+
+    var RealDate = Date;
+    var realSetTimeout = window.setTimeout;
+    var dateOrigin = RealDate.now();
+    var performanceOrigin = performance.now();
+    var FrameInterval = 1000 / 60;
+    var elapsed = 0;
+
+    // Sorted by due time, then by creation
+    var queue = [];
+    var timers = {};
+    var nextId = 1;
+    var sequence = 0;
+    var frameCallbacks = [];
+    var frameTimer = 0;
+
+    function schedule(timer) {
+        timer.sequence = ++sequence;
+        var low = 0;
+        var high = queue.length;
+        while (low < high) {
+            var middle = (low + high) >> 1;
+            if (queue[middle].due <= timer.due) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        queue.splice(low, 0, timer);
+        timers[timer.id] = timer;
+    }
+
+    function call(callback, args) {
+        try {
+            callback.apply(window, args);
+        } catch (e) {
+            realSetTimeout(function() { throw e; });
+        }
+    }
+
+    function addTimer(callback, delay, args, repeat) {
+        if (typeof callback !== 'function') {
+            callback = new Function(String(callback));
+        }
+        // Like the 1 ms clamp of browsers, also keeps a timer that rearms
+        // itself from stalling an advance at one instant
+        delay = Math.max(1, Number(delay) || 0);
+        var id = nextId++;
+        schedule({ id: id, due: elapsed + delay, delay: repeat ? delay : 0,
+                   callback: callback, args: args });
+        return id;
+    }
+
+    function clearTimer(id) {
+        var timer = timers[id];
+        if (timer) {
+            delete timers[id];
+            timer.cancelled = true;
+        }
+    }
+
+    function runFrame() {
+        frameTimer = 0;
+        var callbacks = frameCallbacks;
+        frameCallbacks = [];
+        var timestamp = performanceOrigin + elapsed;
+        for (var i = 0; i < callbacks.length; ++i) {
+            if (!callbacks[i].cancelled) {
+                delete timers[callbacks[i].id];
+                call(callbacks[i].callback, [timestamp]);
+            }
+        }
+    }
+
+    function VirtualDate() {
+        if (!(this instanceof VirtualDate)) {
+            return new RealDate(dateOrigin + elapsed).toString();
+        }
+        var args = arguments.length ? Array.prototype.slice.call(arguments)
+                                    : [dateOrigin + elapsed];
+        return new (Function.prototype.bind.apply(RealDate, [null].concat(args)))();
+    }
+    VirtualDate.prototype = RealDate.prototype;
+    VirtualDate.parse = RealDate.parse;
+    VirtualDate.UTC = RealDate.UTC;
+    VirtualDate.now = function() { return Math.floor(dateOrigin + elapsed); };
+    window.Date = VirtualDate;
+
+    Object.defineProperty(performance, 'now', {
+        value: function() { return performanceOrigin + elapsed; }
+    });
+    window.setTimeout = function(callback, delay) {
+        return addTimer(callback, delay, Array.prototype.slice.call(arguments, 2), false);
+    };
+    window.setInterval = function(callback, delay) {
+        return addTimer(callback, delay, Array.prototype.slice.call(arguments, 2), true);
+    };
+    window.clearTimeout = clearTimer;
+    window.clearInterval = clearTimer;
+    window.requestAnimationFrame = function(callback) {
+        var id = nextId++;
+        var entry = { id: id, callback: callback };
+        frameCallbacks.push(entry);
+        timers[id] = entry;
+        if (!frameTimer) {
+            var frame = (Math.floor(elapsed / FrameInterval) + 1) * FrameInterval;
+            frameTimer = nextId++;
+            schedule({ id: frameTimer, due: frame, delay: 0, callback: runFrame, args: [] });
+        }
+        return id;
+    };
+    window.cancelAnimationFrame = clearTimer;
+
+    var advances = [];
+    var current = null;
+    var running = false;
+    var channel = new MessageChannel();
+
+    // Runs the timers of the next virtual instant, or finishes the advance
+    function step() {
+        if (!current) {
+            current = advances.shift();
+            if (!current) {
+                running = false;
+                return;
+            }
+            current.target = elapsed + current.ms;
+        }
+        while (queue.length && queue[0].cancelled) {
+            queue.shift();
+        }
+        if (!queue.length || queue[0].due > current.target) {
+            elapsed = current.target;
+            handler.postMessage(current.id + ':' + elapsed);
+            current = null;
+        } else {
+            elapsed = Math.max(elapsed, queue[0].due);
+            // Only the timers due now, those they add run in the next step
+            var due = [];
+            while (queue.length && queue[0].due <= elapsed) {
+                due.push(queue.shift());
+            }
+            for (var i = 0; i < due.length; ++i) {
+                var timer = due[i];
+                if (timer.cancelled) {
+                    continue;
+                }
+                if (timer.delay) {
+                    timer.due = elapsed + timer.delay;
+                    schedule(timer);
+                } else {
+                    delete timers[timer.id];
+                }
+                call(timer.callback, timer.args);
+            }
+        }
+        channel.port2.postMessage(0);
+    }
+    channel.port1.onmessage = step;
+
+    Object.defineProperty(window, '__qnativewebvirtualtime', {
+        value: {
+            advance: function(ms, id) {
+                advances.push({ ms: Math.max(0, ms), id: id });
+                if (!running) {
+                    running = true;
+                    channel.port2.postMessage(0);
+                }
+            }
+        }
+    });
+})();
+)JS";
+
+QString jsStringLiteral(const QString &string)
+{
+    const QByteArray literal = QJsonDocument(QJsonArray{ string }).toJson(QJsonDocument::Compact);
+    return QString::fromUtf8(literal.mid(1, literal.size() - 2));
+}
+
+// Default download destinations of the downloads of all pages that still exist
+QSet<QString> &reservedDownloadDestinations()
+{
+    static QSet<QString> destinations;
+    return destinations;
+}
+
+} // namespace
 
 QNativeWebView::QNativeWebView(QWidget *parent, Qt::WindowFlags f)
-    : QWidget(parent, f)
-#ifdef Q_OS_WIN
-      ,
-      d_ptr(new QWebView2WebViewPrivate(this))
-#endif
-#ifdef Q_OS_LINUX
-      ,
-      d_ptr(new QLinuxWebViewPrivate(this))
-#endif
-#ifdef Q_OS_MACOS
-      ,
-      d_ptr(new QDarwinWebViewPrivate(this))
-#endif
+    : QWidget(parent, f), m_page(new QNativeWebPage(this)), d_ptr(m_page->d_ptr)
+{
+    initialize();
+}
+
+QNativeWebView::QNativeWebView(QNativeWebPage *page, QWidget *parent, Qt::WindowFlags f)
+    : QWidget(parent, f),
+      m_page(page ? page : new QNativeWebPage(this)),
+      d_ptr(m_page->d_ptr)
+{
+    m_page->setParent(this);
+    initialize();
+}
+
+QNativeWebView::~QNativeWebView() { }
+
+QNativeWebPage *QNativeWebView::page() const
+{
+    return m_page;
+}
+
+void QNativeWebView::initialize()
 {
     QVBoxLayout *layout = new QVBoxLayout(this);
     layout->setContentsMargins(0, 0, 0, 0);
@@ -49,15 +733,36 @@ QNativeWebView::QNativeWebView(QWidget *parent, Qt::WindowFlags f)
     connect(d_ptr, &QNativeWebViewPrivate::iconChanged, this, &QNativeWebView::iconChanged);
     connect(d_ptr, &QNativeWebViewPrivate::urlChanged, this, &QNativeWebView::urlChanged);
     connect(d_ptr, &QNativeWebViewPrivate::errorOccurred, this, &QNativeWebView::errorOccurred);
+    connect(d_ptr, &QNativeWebViewPrivate::downloadRequested, this,
+            &QNativeWebView::downloadRequested);
+    connect(d_ptr, &QNativeWebViewPrivate::renderProcessTerminated, this,
+            &QNativeWebView::renderProcessTerminated);
+    connect(d_ptr, &QNativeWebViewPrivate::renderProcessRecovered, this,
+            &QNativeWebView::renderProcessRecovered);
+    connect(d_ptr, &QNativeWebViewPrivate::metricsCollected, this,
+            &QNativeWebView::metricsCollected);
 }
 
-QNativeWebView::~QNativeWebView() { }
-
 QString QNativeWebView::errorString() const
 {
     return d_ptr->errorString();
 }
 
+QNativeWebSettings *QNativeWebView::settings() const
+{
+    return d_ptr->settings();
+}
+
+QNativeWebProfile *QNativeWebView::profile() const
+{
+    return d_ptr->profile();
+}
+
+QIcon QNativeWebView::icon() const
+{
+    return d_ptr->icon();
+}
+
 QString QNativeWebView::userAgent() const
 {
     return d_ptr->userAgent();
@@ -94,6 +799,162 @@ void QNativeWebView::evaluateJavaScript(const QString &scriptSource,
     d_ptr->evaluateJavaScript(scriptSource, callback);
 }
 
+void QNativeWebView::pageSource(const std::function<void(const QByteArray &)> &callback)
+{
+    d_ptr->pageSource(callback);
+}
+
+void QNativeWebView::plainText(const std::function<void(const QString &)> &callback)
+{
+    d_ptr->plainText(callback);
+}
+
+void QNativeWebView::setDownloadPolicy(const QNativeWebDownloadPolicy &policy)
+{
+    d_ptr->setDownloadPolicy(policy);
+}
+
+QList<QNativeWebDownload *> QNativeWebView::downloads() const
+{
+    return d_ptr->downloads();
+}
+
+QNativeWebDownloadStatistics QNativeWebView::downloadStatistics() const
+{
+    return d_ptr->downloadStatistics();
+}
+
+void QNativeWebView::setRenderProcessRecovery(int maxRestarts, int intervalMsecs)
+{
+    d_ptr->setRenderProcessRecovery(maxRestarts, intervalMsecs);
+}
+
+void QNativeWebView::setWebBridge(QNativeWebBridge *bridge)
+{
+    d_ptr->setWebBridge(bridge);
+}
+
+QNativeWebBridge *QNativeWebView::webBridge() const
+{
+    return d_ptr->webBridge();
+}
+
+void QNativeWebView::setNavigationPolicy(QNativeWebNavigationPolicy *policy)
+{
+    d_ptr->setNavigationPolicy(policy);
+}
+
+QNativeWebNavigationPolicy *QNativeWebView::navigationPolicy() const
+{
+    return d_ptr->navigationPolicy();
+}
+
+void QNativeWebView::postData(const QString &channel, const QByteArray &data, int chunkSize)
+{
+    d_ptr->postData(channel, data, chunkSize);
+}
+
+QNativeWebStreamReader *QNativeWebView::streamJavaScript(const QString &producer)
+{
+    return d_ptr->streamJavaScript(producer);
+}
+
+void QNativeWebView::setMetricsCollectionEnabled(bool enabled)
+{
+    d_ptr->setMetricsCollectionEnabled(enabled);
+}
+
+bool QNativeWebView::isMetricsCollectionEnabled() const
+{
+    return d_ptr->isMetricsCollectionEnabled();
+}
+
+QNativeWebPageMetrics QNativeWebView::metrics() const
+{
+    return d_ptr->metrics();
+}
+
+void QNativeWebView::setConsoleCapacity(int capacity)
+{
+    d_ptr->setConsoleCapacity(capacity);
+}
+
+int QNativeWebView::consoleCapacity() const
+{
+    return d_ptr->consoleCapacity();
+}
+
+QList<QNativeWebConsoleMessage> QNativeWebView::drainConsoleMessages()
+{
+    return d_ptr->drainConsoleMessages();
+}
+
+quint64 QNativeWebView::droppedConsoleMessages() const
+{
+    return d_ptr->droppedConsoleMessages();
+}
+
+void QNativeWebView::dumpConsoleMessages(int fd) const
+{
+    d_ptr->dumpConsoleMessages(fd);
+}
+
+void QNativeWebView::setQueryCacheEnabled(bool enabled)
+{
+    d_ptr->setQueryCacheEnabled(enabled);
+}
+
+bool QNativeWebView::isQueryCacheEnabled() const
+{
+    return d_ptr->isQueryCacheEnabled();
+}
+
+void QNativeWebView::evaluateCachedJavaScript(const QString &query,
+                                              const std::function<void(const QVariant &)> &callback)
+{
+    d_ptr->evaluateCachedJavaScript(query, callback);
+}
+
+QNativeWebQueryCacheStatistics QNativeWebView::queryCacheStatistics() const
+{
+    return d_ptr->queryCacheStatistics();
+}
+
+void QNativeWebView::resetQueryCacheStatistics()
+{
+    d_ptr->resetQueryCacheStatistics();
+}
+
+void QNativeWebView::setVirtualTimeEnabled(bool enabled)
+{
+    d_ptr->setVirtualTimeEnabled(enabled);
+}
+
+bool QNativeWebView::isVirtualTimeEnabled() const
+{
+    return d_ptr->isVirtualTimeEnabled();
+}
+
+void QNativeWebView::advanceVirtualTime(int msecs, const std::function<void(double)> &callback)
+{
+    d_ptr->advanceVirtualTime(msecs, callback);
+}
+
+bool QNativeWebView::startHarCapture(QIODevice *device)
+{
+    return d_ptr->startHarCapture(device);
+}
+
+void QNativeWebView::stopHarCapture()
+{
+    d_ptr->stopHarCapture();
+}
+
+bool QNativeWebView::isHarCapturing() const
+{
+    return d_ptr->isHarCapturing();
+}
+
 void QNativeWebView::load(const QUrl &url)
 {
     d_ptr->load(url);
@@ -123,3 +984,709 @@ void QNativeWebView::reload()
 {
     d_ptr->reload();
 }
+
+void QNativeWebViewPrivate::handleRenderProcessTerminated(
+        QNativeWebPage::RenderProcessTerminationReason reason)
+{
+    emit renderProcessTerminated(reason);
+    if (m_recoveryMaxRestarts <= 0 || reason == QNativeWebPage::RenderProcessTerminatedByApi) {
+        return;
+    }
+
+    // Only a limited number of restarts per interval, so a page that crashes the
+    // process on load can not keep it restarting
+    if (!m_recoveryClock.isValid()) {
+        m_recoveryClock.start();
+    }
+    const qint64 now = m_recoveryClock.elapsed();
+    while (!m_recoveryRestarts.isEmpty() && now - m_recoveryRestarts.first() > m_recoveryInterval) {
+        m_recoveryRestarts.removeFirst();
+    }
+    if (m_recoveryRestarts.size() >= m_recoveryMaxRestarts) {
+        qWarning() << "Render process restart budget exhausted, not recovering";
+        return;
+    }
+    m_recoveryRestarts.append(now);
+
+    m_downtime.start();
+    // Restart once the backend has finished reporting the termination
+    QTimer::singleShot(0, this, [this] {
+        if (m_downtime.isValid()) {
+            m_recoveryLoadPending = true;
+            recoverRenderProcess();
+        }
+    });
+}
+
+void QNativeWebViewPrivate::addMessageHandler(const QString &name, const MessageHandler &handler,
+                                              const QString &script)
+{
+    const bool registered = m_messageHandlers.contains(name);
+    MessageHandlerEntry &entry = m_messageHandlers[name];
+    entry.handler = handler;
+    if (!registered) {
+        registerMessageHandler(name);
+    }
+    if (entry.script != script) {
+        entry.script = script;
+        entry.native.reset();
+        applyUserContent();
+        // The current document was created without the script
+        if (!script.isEmpty()) {
+            evaluateJavaScript(script);
+        }
+    }
+}
+
+void QNativeWebViewPrivate::removeMessageHandler(const QString &name)
+{
+    auto it = m_messageHandlers.find(name);
+    if (it == m_messageHandlers.end()) {
+        return;
+    }
+    const bool hadScript = !it->script.isEmpty();
+    m_messageHandlers.erase(it);
+    unregisterMessageHandler(name);
+    if (hadScript) {
+        applyUserContent();
+    }
+}
+
+void QNativeWebViewPrivate::dispatchMessage(const QString &name, const QString &message)
+{
+    auto it = m_messageHandlers.constFind(name);
+    if (it != m_messageHandlers.constEnd() && it->handler) {
+        // The handler may remove itself
+        const MessageHandler handler = it->handler;
+        handler(message);
+    }
+}
+
+void QNativeWebViewPrivate::setWebBridge(QNativeWebBridge *bridge)
+{
+    if (m_bridge == bridge) {
+        return;
+    }
+    if (m_bridge) {
+        m_bridge->detach(this);
+    }
+    m_bridge = bridge;
+    if (m_bridge) {
+        m_bridge->attach(this);
+    }
+}
+
+void QNativeWebViewPrivate::enableDataChannel()
+{
+    if (!m_messageHandlers.contains(QLatin1String(DataHandlerName))) {
+        // The page acknowledges every pushed chunk before it gets the next
+        addMessageHandler(
+                QLatin1String(DataHandlerName),
+                [this](const QString &message) { sendPostedDataChunk(message.toInt()); },
+                QString::fromUtf8(DataScript));
+    }
+}
+
+void QNativeWebViewPrivate::postData(const QString &channel, const QByteArray &data,
+                                     int chunkSize)
+{
+    enableDataChannel();
+
+    PostedData posted;
+    posted.channel = channel;
+    posted.data = data;
+    posted.chunkSize = chunkSize > 0 ? chunkSize : qMax(data.size(), 1);
+    if (m_documentLoading) {
+        m_queuedPostedData.append(posted);
+    } else {
+        startPostedData(posted);
+    }
+}
+
+void QNativeWebViewPrivate::startPostedData(const PostedData &transfer)
+{
+    const int id = ++m_nextPostedData;
+    PostedData &posted = m_postedData[id];
+    posted = transfer;
+    posted.key = QByteArray::number(QRandomGenerator::global()->generate64(), 16);
+
+    const QString url = postedDataUrl(id, posted);
+    evaluateJavaScript(
+            QStringLiteral("window.qnativewebdata && qnativewebdata.__start(%1, %2, %3, %4)")
+                    .arg(QString::number(id), jsStringLiteral(posted.channel),
+                         QString::number(posted.data.size()), jsStringLiteral(url)));
+    if (url.isEmpty()) {
+        sendPostedDataChunk(id);
+    }
+}
+
+void QNativeWebViewPrivate::dropPostedData()
+{
+    m_documentLoading = true;
+    for (const PostedData &posted : qAsConst(m_postedData)) {
+        qWarning() << "Data posted to" << posted.channel
+                   << "was dropped, the document was replaced before it took all of it";
+    }
+    m_postedData.clear();
+}
+
+void QNativeWebViewPrivate::startQueuedPostedData()
+{
+    m_documentLoading = false;
+    const QList<PostedData> queued = m_queuedPostedData;
+    m_queuedPostedData.clear();
+    for (const PostedData &posted : queued) {
+        startPostedData(posted);
+    }
+}
+
+void QNativeWebViewPrivate::sendPostedDataChunk(int id)
+{
+    auto it = m_postedData.find(id);
+    if (it == m_postedData.end()) {
+        return;
+    }
+
+    const int offset = it->nextChunk++ * it->chunkSize;
+    const int size = qMin(it->chunkSize, it->data.size() - offset);
+    // Base64 of a view into the data, the chunk itself is not copied
+    const QByteArray chunk =
+            QByteArray::fromRawData(it->data.constData() + offset, qMax(size, 0)).toBase64();
+    evaluateJavaScript(QStringLiteral("window.qnativewebdata && qnativewebdata.__push(%1, '%2')")
+                               .arg(id)
+                               .arg(QString::fromLatin1(chunk)));
+    if (offset + size >= it->data.size()) {
+        m_postedData.erase(it);
+    }
+}
+
+void QNativeWebViewPrivate::setMetricsCollectionEnabled(bool enabled)
+{
+    if (enabled == m_metricsEnabled) {
+        return;
+    }
+    m_metricsEnabled = enabled;
+    if (enabled) {
+        addMessageHandler(
+                QLatin1String(MetricsHandlerName),
+                [this](const QString &message) { updateMetrics(message); },
+                QString::fromUtf8(MetricsScript));
+    } else {
+        removeMessageHandler(QLatin1String(MetricsHandlerName));
+        finishMetrics();
+    }
+}
+
+void QNativeWebViewPrivate::updateMetrics(const QString &report)
+{
+    const QJsonObject object = QJsonDocument::fromJson(report.toUtf8()).object();
+    const QString document = object.value(QLatin1String("document")).toString();
+    if (document.isEmpty() || document == m_retiredMetricsDocument) {
+        return;
+    }
+    // The first report of the next document, the previous one has sent its last
+    if (!m_metricsDocument.isEmpty() && document != m_metricsDocument) {
+        finishMetrics();
+    }
+
+    // Every report is a snapshot of the document's metrics so far
+    m_metricsDocument = document;
+    m_metrics.url = QUrl(object.value(QLatin1String("url")).toString());
+    m_metrics.firstContentfulPaint = object.value(QLatin1String("fcp")).toDouble(-1);
+    m_metrics.largestContentfulPaint = object.value(QLatin1String("lcp")).toDouble(-1);
+    m_metrics.cumulativeLayoutShift = object.value(QLatin1String("cls")).toDouble();
+    m_metrics.longTasks = object.value(QLatin1String("longTasks")).toInt();
+    m_metrics.longTaskTime = object.value(QLatin1String("longTaskTime")).toDouble();
+    const QJsonArray frames = object.value(QLatin1String("frames")).toArray();
+    m_metrics.frameTimeHistogram.resize(frames.size());
+    for (int i = 0; i < frames.size(); ++i) {
+        m_metrics.frameTimeHistogram[i] = frames.at(i).toInt();
+    }
+}
+
+void QNativeWebViewPrivate::finishMetrics()
+{
+    m_metricsRetiring = false;
+    if (m_metricsDocument.isEmpty()) {
+        return;
+    }
+    const QNativeWebPageMetrics metrics = m_metrics;
+    m_metrics = QNativeWebPageMetrics();
+    m_retiredMetricsDocument = m_metricsDocument;
+    m_metricsDocument.clear();
+    emit metricsCollected(metrics);
+}
+
+void QNativeWebViewPrivate::setConsoleCapacity(int capacity)
+{
+    capacity = qMax(0, capacity);
+    if (capacity == consoleCapacity()) {
+        return;
+    }
+    if (capacity == 0) {
+        removeMessageHandler(QLatin1String(ConsoleHandlerName));
+        m_console.reset();
+        return;
+    }
+    if (!m_console) {
+        addMessageHandler(
+                QLatin1String(ConsoleHandlerName),
+                [this](const QString &message) { appendConsoleMessages(message); },
+                QString::fromUtf8(ConsoleScript));
+    }
+    // Messages not drained yet are lost with the old ring
+    m_console.reset(new QNativeWebConsoleBuffer(capacity));
+}
+
+QList<QNativeWebConsoleMessage> QNativeWebViewPrivate::drainConsoleMessages()
+{
+    return m_console ? m_console->drain() : QList<QNativeWebConsoleMessage>();
+}
+
+void QNativeWebViewPrivate::appendConsoleMessages(const QString &batch)
+{
+    if (!m_console) {
+        return;
+    }
+    // [[level, timestamp, message, source, line, column], ...]
+    const QJsonArray entries = QJsonDocument::fromJson(batch.toUtf8()).array();
+    for (const QJsonValue &value : entries) {
+        const QJsonArray entry = value.toArray();
+        m_console->append(QNativeWebConsoleMessage::Level(qBound(0, entry.at(0).toInt(), 3)),
+                          qint64(entry.at(1).toDouble()), entry.at(2).toString().toUtf8(),
+                          entry.at(3).toString().toUtf8(), entry.at(4).toInt(),
+                          entry.at(5).toInt());
+    }
+}
+
+void QNativeWebViewPrivate::setQueryCacheEnabled(bool enabled)
+{
+    if (enabled == m_queryCacheEnabled) {
+        return;
+    }
+    m_queryCacheEnabled = enabled;
+    if (enabled) {
+        addMessageHandler(
+                QLatin1String(QueryHandlerName),
+                [this](const QString &message) { advanceDomEpoch(message); },
+                QString::fromUtf8(QueryScript));
+    } else {
+        removeMessageHandler(QLatin1String(QueryHandlerName));
+        resetQueryCache();
+    }
+}
+
+void QNativeWebViewPrivate::evaluateCachedJavaScript(
+        const QString &query, const std::function<void(const QVariant &)> &callback)
+{
+    if (!m_queryCacheEnabled) {
+        evaluateJavaScript(query, callback);
+        return;
+    }
+
+    const auto cached = m_queryCache.constFind(query);
+    if (cached != m_queryCache.cend()) {
+        ++m_queryCacheStatistics.hits;
+        if (callback) {
+            const QVariant result = *cached;
+            QMetaObject::invokeMethod(
+                    this, [callback, result] { callback(result); }, Qt::QueuedConnection);
+        }
+        return;
+    }
+
+    ++m_queryCacheStatistics.misses;
+    // The same query already on its way to the page answers every caller
+    QList<std::function<void(const QVariant &)>> &pending = m_pendingQueries[query];
+    pending.append(callback);
+    if (pending.size() > 1) {
+        return;
+    }
+
+    const QString script = QStringLiteral("(function() {\n"
+                                          "var hook = window.__qnativewebquery;\n"
+                                          "var result = (\n%1\n);\n"
+                                          "return [hook ? hook.arm() : '', result];\n"
+                                          "})()")
+                                   .arg(query);
+    QPointer<QNativeWebViewPrivate> self = this;
+    const int navigation = m_queryNavigation;
+    evaluateJavaScript(script, [self, query, navigation](const QVariant &value) {
+        if (!self) {
+            return;
+        }
+        const QVariantList pair = value.toList();
+        const QVariant result = pair.size() == 2 ? pair.at(1) : value;
+        // Results of the previous document are passed on but not cached
+        if (self->m_queryCacheEnabled && navigation == self->m_queryNavigation
+            && self->advanceDomEpoch(pair.value(0).toString())) {
+            self->m_queryCache.insert(query, result);
+        }
+        const QList<std::function<void(const QVariant &)>> callbacks =
+                self->m_pendingQueries.take(query);
+        for (const std::function<void(const QVariant &)> &callback : callbacks) {
+            if (callback) {
+                callback(result);
+            }
+        }
+    });
+}
+
+QNativeWebQueryCacheStatistics QNativeWebViewPrivate::queryCacheStatistics() const
+{
+    QNativeWebQueryCacheStatistics stats = m_queryCacheStatistics;
+    const quint64 lookups = stats.hits + stats.misses;
+    if (lookups > 0) {
+        stats.hitRate = double(stats.hits) / lookups;
+    }
+    return stats;
+}
+
+bool QNativeWebViewPrivate::advanceDomEpoch(const QString &epoch)
+{
+    // "<document>:<counter>"
+    const int colon = epoch.lastIndexOf(QLatin1Char(':'));
+    if (colon <= 0) {
+        return false;
+    }
+    const QString document = epoch.left(colon);
+    const qint64 counter = epoch.mid(colon + 1).toLongLong();
+    if (document == m_domDocument) {
+        if (counter < m_domEpoch) {
+            return false;
+        }
+        if (counter == m_domEpoch) {
+            return true;
+        }
+    }
+    if (!m_queryCache.isEmpty()) {
+        ++m_queryCacheStatistics.invalidations;
+        m_queryCache.clear();
+    }
+    m_domDocument = document;
+    m_domEpoch = counter;
+    return true;
+}
+
+void QNativeWebViewPrivate::resetQueryCache()
+{
+    ++m_queryNavigation;
+    m_queryCache.clear();
+    m_domDocument.clear();
+    m_domEpoch = -1;
+}
+
+void QNativeWebViewPrivate::setVirtualTimeEnabled(bool enabled)
+{
+    if (enabled == m_virtualTimeEnabled) {
+        return;
+    }
+    m_virtualTimeEnabled = enabled;
+    if (enabled) {
+        addMessageHandler(
+                QLatin1String(VirtualTimeHandlerName),
+                [this](const QString &message) { finishVirtualTimeAdvance(message); },
+                QString::fromUtf8(VirtualTimeScript));
+    } else {
+        removeMessageHandler(QLatin1String(VirtualTimeHandlerName));
+        // Their reports can not arrive anymore
+        failVirtualTimeAdvances();
+    }
+}
+
+void QNativeWebViewPrivate::advanceVirtualTime(int msecs,
+                                               const std::function<void(double)> &callback)
+{
+    if (!m_virtualTimeEnabled) {
+        if (callback) {
+            QMetaObject::invokeMethod(
+                    this, [callback] { callback(-1); }, Qt::QueuedConnection);
+        }
+        return;
+    }
+
+    const int id = ++m_lastVirtualTimeAdvance;
+    m_virtualTimeAdvances.insert(id, callback);
+    const QString script = QStringLiteral("(function() {\n"
+                                          "var clock = window.__qnativewebvirtualtime;\n"
+                                          "if (clock) clock.advance(%1, %2);\n"
+                                          "return !!clock;\n"
+                                          "})()")
+                                   .arg(qMax(0, msecs))
+                                   .arg(id);
+    QPointer<QNativeWebViewPrivate> self = this;
+    evaluateJavaScript(script, [self, id](const QVariant &result) {
+        // The document has no virtual clock, e.g. it was loaded before it was enabled
+        if (self && !result.toBool()) {
+            const std::function<void(double)> callback = self->m_virtualTimeAdvances.take(id);
+            if (callback) {
+                callback(-1);
+            }
+        }
+    });
+}
+
+void QNativeWebViewPrivate::finishVirtualTimeAdvance(const QString &report)
+{
+    // "<advance>:<virtual time>"
+    const int colon = report.indexOf(QLatin1Char(':'));
+    bool ok = false;
+    const int id = report.left(colon).toInt(&ok);
+    if (colon <= 0 || !ok) {
+        return;
+    }
+    const std::function<void(double)> callback = m_virtualTimeAdvances.take(id);
+    if (callback) {
+        callback(report.mid(colon + 1).toDouble());
+    }
+}
+
+void QNativeWebViewPrivate::failVirtualTimeAdvances()
+{
+    const QHash<int, std::function<void(double)>> advances = m_virtualTimeAdvances;
+    m_virtualTimeAdvances.clear();
+    for (const std::function<void(double)> &callback : advances) {
+        if (callback) {
+            callback(-1);
+        }
+    }
+}
+
+QNativeWebStreamReader *QNativeWebViewPrivate::streamJavaScript(const QString &producer)
+{
+    if (!m_messageHandlers.contains(QLatin1String(StreamHandlerName))) {
+        addMessageHandler(
+                QLatin1String(StreamHandlerName),
+                [this](const QString &message) { receiveStreamMessage(message); },
+                QString::fromUtf8(StreamScript));
+    }
+
+    const int id = ++m_lastStream;
+    QNativeWebStreamReader *reader = QNativeWebStreamReaderPrivate::create(this);
+    QNativeWebStreamReaderPrivate *d = QNativeWebStreamReaderPrivate::get(reader);
+    m_streams.insert(id, reader);
+    QPointer<QNativeWebViewPrivate> self = this;
+    d->creditHandler = [self, id](quint64 credit) {
+        if (self) {
+            self->evaluateJavaScript(
+                    QStringLiteral("window.__qnativewebstream && __qnativewebstream.grant(%1, %2)")
+                            .arg(id)
+                            .arg(credit));
+        }
+    };
+    d->cancelHandler = [self, id] {
+        if (self && self->m_streams.remove(id)) {
+            self->evaluateJavaScript(
+                    QStringLiteral("window.__qnativewebstream && __qnativewebstream.cancel(%1)")
+                            .arg(id));
+        }
+    };
+    d->releaseHandler = d->cancelHandler;
+
+    const QString script = QStringLiteral("(function() {\n"
+                                          "var streams = window.__qnativewebstream;\n"
+                                          "if (!streams) return 'unavailable';\n"
+                                          "streams.start(%1, (\n%2\n));\n"
+                                          "return 'started';\n"
+                                          "})()")
+                                   .arg(QString::number(id), producer);
+    // Anything else, such as the invalid result of a producer with a syntax
+    // error, means the stream never started
+    evaluateJavaScript(script, [self, id](const QVariant &result) {
+        if (!self || result.toString() == QLatin1String("started")) {
+            return;
+        }
+        if (QNativeWebStreamReader *reader = self->m_streams.take(id)) {
+            QNativeWebStreamReaderPrivate::get(reader)->finish(
+                    result.toString() == QLatin1String("unavailable")
+                            ? QStringLiteral("The page can not stream")
+                            : QStringLiteral("The producer could not be started"));
+        }
+    });
+    d->grantCredit();
+    return reader;
+}
+
+void QNativeWebViewPrivate::receiveStreamMessage(const QString &message)
+{
+    // "<id>:<type>[:<payload>]"
+    const int colon = message.indexOf(QLatin1Char(':'));
+    if (colon <= 0 || message.size() < colon + 2) {
+        return;
+    }
+    const int id = message.left(colon).toInt();
+    QNativeWebStreamReader *reader = m_streams.value(id);
+    if (!reader) {
+        return;
+    }
+    QNativeWebStreamReaderPrivate *d = QNativeWebStreamReaderPrivate::get(reader);
+    const QStringView payload = QStringView(message).mid(qMin(colon + 3, message.size()));
+    switch (message.at(colon + 1).unicode()) {
+    case 't':
+        d->append(payload.toUtf8());
+        break;
+    case 'b':
+        d->append(QByteArray::fromBase64(payload.toLatin1()));
+        break;
+    case 'e':
+        m_streams.remove(id);
+        d->finish();
+        break;
+    case 'x':
+        m_streams.remove(id);
+        d->finish(payload.isEmpty() ? QStringLiteral("The page failed the stream")
+                                    : payload.toString());
+        break;
+    default:
+        break;
+    }
+}
+
+void QNativeWebViewPrivate::failStreams()
+{
+    const QHash<int, QPointer<QNativeWebStreamReader>> streams = m_streams;
+    m_streams.clear();
+    for (const QPointer<QNativeWebStreamReader> &reader : streams) {
+        if (reader) {
+            QNativeWebStreamReaderPrivate::get(reader)->finish(
+                    QStringLiteral("The document was unloaded"));
+        }
+    }
+}
+
+bool QNativeWebViewPrivate::startHarCapture(QIODevice *device)
+{
+    stopHarCapture();
+    if (!device || !device->isWritable() || !captureResources(true)) {
+        return false;
+    }
+    m_har.reset(new QNativeWebHarWriter(device));
+    m_har->begin();
+    return true;
+}
+
+void QNativeWebViewPrivate::stopHarCapture()
+{
+    if (!m_har) {
+        return;
+    }
+    // Loads still in progress are left out
+    captureResources(false);
+    if (!m_harPage.isEmpty()) {
+        m_har->addPage(m_harPage);
+        m_harPage = QJsonObject();
+    }
+    m_har->finish();
+    m_har.reset();
+}
+
+void QNativeWebViewPrivate::startHarPage()
+{
+    if (!m_har) {
+        return;
+    }
+    if (!m_harPage.isEmpty()) {
+        m_har->addPage(m_harPage);
+    }
+    m_harPageTimer.start();
+    m_harPage = QJsonObject{
+        { QStringLiteral("startedDateTime"),
+          QDateTime::currentDateTime().toString(Qt::ISODateWithMs) },
+        { QStringLiteral("id"), QStringLiteral("page_%1").arg(++m_harPages) },
+        { QStringLiteral("title"), QString() },
+        { QStringLiteral("pageTimings"),
+          QJsonObject{ { QStringLiteral("onContentLoad"), -1 },
+                       { QStringLiteral("onLoad"), -1 } } }
+    };
+}
+
+void QNativeWebViewPrivate::addHarEntry(QJsonObject entry)
+{
+    if (!m_har) {
+        return;
+    }
+    if (!m_harPage.isEmpty()) {
+        entry.insert(QStringLiteral("pageref"), m_harPage.value(QLatin1String("id")));
+    }
+    m_har->addEntry(entry);
+}
+
+QString QNativeWebViewPrivate::downloadDestination(const QUrl &url,
+                                                  const QString &suggestedFileName) const
+{
+    if (m_downloadPolicy) {
+        return m_downloadPolicy(url, suggestedFileName);
+    }
+
+    QString fileName = QFileInfo(suggestedFileName).fileName();
+    if (fileName.isEmpty()) {
+        fileName = QFileInfo(url.path()).fileName();
+    }
+    if (fileName.isEmpty()) {
+        fileName = QStringLiteral("download");
+    }
+
+    const QDir dir(QStandardPaths::writableLocation(QStandardPaths::DownloadLocation));
+    const QFileInfo info(fileName);
+    QString path = dir.filePath(fileName);
+    for (int i = 1; QFileInfo::exists(path) || reservedDownloadDestinations().contains(path);
+         ++i) {
+        const QString suffix = info.completeSuffix();
+        path = dir.filePath(QStringLiteral("%1 (%2)%3")
+                                    .arg(info.baseName())
+                                    .arg(i)
+                                    .arg(suffix.isEmpty() ? QString() : "." + suffix));
+    }
+    reservedDownloadDestinations().insert(path);
+    return path;
+}
+
+void QNativeWebViewPrivate::releaseDownloadDestination(const QString &path)
+{
+    reservedDownloadDestinations().remove(path);
+}
+
+QList<QNativeWebDownload *> QNativeWebViewPrivate::downloads() const
+{
+    QList<QNativeWebDownload *> result;
+    for (const QPointer<QNativeWebDownload> &download : m_downloads) {
+        if (download) {
+            result.append(download);
+        }
+    }
+    return result;
+}
+
+QNativeWebDownloadStatistics QNativeWebViewPrivate::downloadStatistics() const
+{
+    QNativeWebDownloadStatistics stats;
+    for (const QPointer<QNativeWebDownload> &download : m_downloads) {
+        if (!download) {
+            continue;
+        }
+        stats.bytesReceived += download->receivedBytes();
+        switch (download->state()) {
+        case QNativeWebDownload::InProgress:
+            ++stats.active;
+            stats.bytesPerSecond += download->bytesPerSecond();
+            break;
+        case QNativeWebDownload::Completed:
+            ++stats.completed;
+            break;
+        case QNativeWebDownload::Cancelled:
+            ++stats.cancelled;
+            break;
+        case QNativeWebDownload::Failed:
+            ++stats.failed;
+            break;
+        }
+    }
+    return stats;
+}
+
+void QNativeWebViewPrivate::addDownload(QNativeWebDownload *download)
+{
+    m_downloads.removeAll(QPointer<QNativeWebDownload>());
+    m_downloads.append(download);
+    emit downloadRequested(download);
+}
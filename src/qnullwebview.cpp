@@ -0,0 +1,187 @@
+#include "private/qnullwebview.h"
+
+#include "qnativewebnullbackend.h"
+
+#include <algorithm>
+
+QNullWebViewPrivate::QNullWebViewPrivate(QNativeWebProfile *profile, QObject *parent)
+    : QNativeWebViewPrivate(profile, parent),
+      m_userAgent(QStringLiteral("Mozilla/5.0 (QNativeWebView null backend)"))
+{
+}
+
+void QNullWebViewPrivate::load(const QUrl &url)
+{
+    record(QStringLiteral("load"), { url });
+    // Like in a browser, a new entry drops the forward history
+    m_history.erase(m_history.begin() + (m_historyIndex + 1), m_history.end());
+    m_history.append(url);
+    ++m_historyIndex;
+    m_html.clear();
+    navigate();
+}
+
+void QNullWebViewPrivate::setHtml(const QString &html, const QUrl &baseUrl)
+{
+    record(QStringLiteral("setHtml"), { html, baseUrl });
+    m_history.erase(m_history.begin() + (m_historyIndex + 1), m_history.end());
+    m_history.append(baseUrl.isEmpty() ? QUrl(QStringLiteral("about:blank")) : baseUrl);
+    ++m_historyIndex;
+    m_html = html;
+    navigate();
+}
+
+void QNullWebViewPrivate::stop()
+{
+    record(QStringLiteral("stop"));
+    ++m_navigation;
+}
+
+void QNullWebViewPrivate::back()
+{
+    record(QStringLiteral("back"));
+    if (m_historyIndex > 0) {
+        --m_historyIndex;
+        navigate();
+    }
+}
+
+void QNullWebViewPrivate::forward()
+{
+    record(QStringLiteral("forward"));
+    if (m_historyIndex + 1 < m_history.size()) {
+        ++m_historyIndex;
+        navigate();
+    }
+}
+
+void QNullWebViewPrivate::reload()
+{
+    record(QStringLiteral("reload"));
+    if (m_historyIndex >= 0) {
+        navigate();
+    }
+}
+
+bool QNullWebViewPrivate::setUserAgent(const QString &userAgent)
+{
+    record(QStringLiteral("setUserAgent"), { userAgent });
+    m_userAgent = userAgent;
+    return true;
+}
+
+void QNullWebViewPrivate::allCookies(const std::function<void(const QJsonObject &)> &callback)
+{
+    record(QStringLiteral("allCookies"));
+    QMetaObject::invokeMethod(
+            this,
+            [this, callback] {
+                callback(QNativeWebProfilePrivate::get(m_profile)->cookiesToJson());
+            },
+            Qt::QueuedConnection);
+}
+
+bool QNullWebViewPrivate::setCookie(const QString &domain, const QString &name,
+                                    const QString &value)
+{
+    record(QStringLiteral("setCookie"), { domain, name, value });
+    // The profile's mirror is the null backend's cookie store
+    QNetworkCookie cookie(name.toUtf8(), value.toUtf8());
+    cookie.setDomain(domain);
+    cookie.setPath(QStringLiteral("/"));
+    QList<QNetworkCookie> cookies = m_profile->cookies();
+    cookies.erase(std::remove_if(cookies.begin(), cookies.end(),
+                                 [&cookie](const QNetworkCookie &other) {
+                                     return other.hasSameIdentifier(cookie);
+                                 }),
+                  cookies.end());
+    cookies.append(cookie);
+    QNativeWebProfilePrivate::get(m_profile)->setCookies(cookies);
+    return true;
+}
+
+void QNullWebViewPrivate::deleteCookie(const QString &domain, const QString &name)
+{
+    record(QStringLiteral("deleteCookie"), { domain, name });
+    QList<QNetworkCookie> cookies = m_profile->cookies();
+    cookies.erase(std::remove_if(cookies.begin(), cookies.end(),
+                                 [&domain, &name](const QNetworkCookie &cookie) {
+                                     return cookie.domain() == domain
+                                             && cookie.name() == name.toUtf8();
+                                 }),
+                  cookies.end());
+    QNativeWebProfilePrivate::get(m_profile)->setCookies(cookies);
+}
+
+void QNullWebViewPrivate::deleteAllCookies()
+{
+    record(QStringLiteral("deleteAllCookies"));
+    QNativeWebProfilePrivate::get(m_profile)->setCookies({});
+}
+
+void QNullWebViewPrivate::evaluateJavaScript(const QString &scriptSource,
+                                             const std::function<void(const QVariant &)> &callback)
+{
+    record(QStringLiteral("evaluateJavaScript"), { scriptSource });
+    if (!callback) {
+        return;
+    }
+    const QNativeWebNullBackend *backend = QNativeWebNullBackend::instance();
+    const QVariant result =
+            backend->m_scriptResults.value(scriptSource, backend->m_defaultScriptResult);
+    QMetaObject::invokeMethod(
+            this, [callback, result] { callback(result); }, Qt::QueuedConnection);
+}
+
+void QNullWebViewPrivate::pageSource(const std::function<void(const QByteArray &)> &callback)
+{
+    record(QStringLiteral("pageSource"));
+    const QByteArray source = m_html.toUtf8();
+    QMetaObject::invokeMethod(
+            this, [callback, source] { callback(source); }, Qt::QueuedConnection);
+}
+
+void QNullWebViewPrivate::setViewportSize(const QSize &size)
+{
+    record(QStringLiteral("setViewportSize"), { size });
+    m_viewportSize = size;
+}
+
+void QNullWebViewPrivate::snapshot(const std::function<void(const QImage &)> &callback)
+{
+    record(QStringLiteral("snapshot"));
+    QImage image(m_viewportSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QMetaObject::invokeMethod(
+            this, [callback, image] { callback(image); }, Qt::QueuedConnection);
+}
+
+void QNullWebViewPrivate::record(const QString &method, const QVariantList &arguments)
+{
+    QNativeWebNullBackend::instance()->record(parent(), method, arguments);
+}
+
+void QNullWebViewPrivate::navigate()
+{
+    const int navigation = ++m_navigation;
+    QMetaObject::invokeMethod(
+            this,
+            [this, navigation] {
+                if (navigation != m_navigation) {
+                    return;
+                }
+                const QUrl url = m_history.at(m_historyIndex);
+                const QNativeWebNullBackend::LoadResult result =
+                        QNativeWebNullBackend::instance()->m_loadResults.value(url);
+                m_error = result.ok ? QString() : QStringLiteral("Load failed");
+                emit loadStarted();
+                emit urlChanged(url);
+                if (!result.ok) {
+                    emit errorOccurred(m_error);
+                }
+                emit loadProgress(100);
+                emit titleChanged(result.title.isEmpty() ? url.toString() : result.title);
+                emit loadFinished(result.ok);
+            },
+            Qt::QueuedConnection);
+}
@@ -1,4 +1,5 @@
 #include "private/qwebview2webview.h"
+#include "private/qnativewebprofile_p.h"
 
 #include <QDebug>
 #include <QWindow>
@@ -12,6 +13,7 @@
 #include <QStandardPaths>
 #include <QJsonObject>
 #include <QDir>
+#include <QDateTime>
 
 #ifndef Q_ASSERT_SUCCEEDED
 #  define Q_ASSERT_SUCCEEDED(hr) \
@@ -51,8 +53,8 @@ QString WebErrorStatusToString(COREWEBVIEW2_WEB_ERROR_STATUS status)
     return QString("ERROR");
 }
 
-QWebView2WebViewPrivate::QWebView2WebViewPrivate(QObject *parent)
-    : QNativeWebViewPrivate(parent),
+QWebView2WebViewPrivate::QWebView2WebViewPrivate(QNativeWebProfile *profile, QObject *parent)
+    : QNativeWebViewPrivate(profile, parent),
       m_webviewController(nullptr),
       m_webview(nullptr),
       m_cookieManager(nullptr),
@@ -188,102 +190,99 @@ bool QWebView2WebViewPrivate::setUserAgent(const QString &userAgent)
     return false;
 }
 
-void QWebView2WebViewPrivate::allCookies(const std::function<void(const QJsonObject &)> &callback)
+static QNetworkCookie fromWebView2Cookie(ICoreWebView2Cookie *cookie)
 {
-    if (m_webview && m_cookieManager) {
-        std::function<void(const QJsonObject &)> cb = callback;
-        HRESULT hr = m_cookieManager->GetCookies(
-                L"",
-                Microsoft::WRL::Callback<ICoreWebView2GetCookiesCompletedHandler>(
-                        [this, cb](HRESULT result, ICoreWebView2CookieList *cookieList) -> HRESULT {
+    QNetworkCookie result;
+    wchar_t *string = nullptr;
+    if (SUCCEEDED(cookie->get_Name(&string))) {
+        result.setName(QString::fromWCharArray(string).toUtf8());
+        CoTaskMemFree(string);
+    }
+    if (SUCCEEDED(cookie->get_Value(&string))) {
+        result.setValue(QString::fromWCharArray(string).toUtf8());
+        CoTaskMemFree(string);
+    }
+    if (SUCCEEDED(cookie->get_Domain(&string))) {
+        result.setDomain(QString::fromWCharArray(string));
+        CoTaskMemFree(string);
+    }
+    if (SUCCEEDED(cookie->get_Path(&string))) {
+        result.setPath(QString::fromWCharArray(string));
+        CoTaskMemFree(string);
+    }
+    BOOL flag = FALSE;
+    if (SUCCEEDED(cookie->get_IsHttpOnly(&flag))) {
+        result.setHttpOnly(flag);
+    }
+    if (SUCCEEDED(cookie->get_IsSecure(&flag))) {
+        result.setSecure(flag);
+    }
+    double expires = 0;
+    if (SUCCEEDED(cookie->get_IsSession(&flag)) && !flag
+        && SUCCEEDED(cookie->get_Expires(&expires))) {
+        result.setExpirationDate(QDateTime::fromMSecsSinceEpoch(qint64(expires * 1000)));
+    }
+    return result;
+}
+
+void QWebView2WebViewPrivate::refreshCookies(const std::function<void()> &done)
+{
+    // WebView2 has no cookie change notification, the mirror is refreshed after
+    // navigations and cookie changes made through this API
+    if (!m_cookieManager) {
+        if (done) {
+            done();
+        }
+        return;
+    }
+
+    QPointer<QNativeWebProfile> profile = m_profile;
+    std::function<void()> callback = done;
+    HRESULT hr = m_cookieManager->GetCookies(
+            L"",
+            Microsoft::WRL::Callback<ICoreWebView2GetCookiesCompletedHandler>(
+                    [profile, callback](HRESULT result,
+                                        ICoreWebView2CookieList *cookieList) -> HRESULT {
+                        if (SUCCEEDED(result) && cookieList && profile) {
                             UINT count = 0;
                             cookieList->get_Count(&count);
-                            QJsonObject cookies;
+                            QList<QNetworkCookie> cookies;
                             for (UINT i = 0; i < count; ++i) {
                                 ComPtr<ICoreWebView2Cookie> cookie;
                                 if (SUCCEEDED(cookieList->GetValueAtIndex(i, &cookie))) {
-                                    wchar_t *domain = nullptr;
-                                    if (SUCCEEDED(cookie->get_Domain(&domain))) {
-                                        // domain
-                                        QString strDomain = QString::fromStdWString(domain);
-                                        CoTaskMemFree(domain);
-                                        if (!cookies.contains(strDomain)) {
-                                            cookies.insert(strDomain, QJsonObject());
-                                        }
-                                        // name
-                                        wchar_t *name = nullptr;
-                                        if (!SUCCEEDED(cookie->get_Name(&name))) {
-                                            continue;
-                                        }
-                                        QString strName = QString::fromStdWString(name);
-                                        CoTaskMemFree(name);
-
-                                        // value
-                                        QString strValue = "";
-                                        wchar_t *value = nullptr;
-                                        if (SUCCEEDED(cookie->get_Value(&value))) {
-                                            strValue = QString::fromStdWString(value);
-                                            CoTaskMemFree(value);
-                                        }
-
-                                        // path
-                                        QString strPath = "";
-                                        wchar_t *path = nullptr;
-                                        if (SUCCEEDED(cookie->get_Path(&path))) {
-                                            strPath = QString::fromStdWString(path);
-                                            CoTaskMemFree(path);
-                                        }
-
-                                        // expires
-                                        double expires = 0;
-                                        if (!SUCCEEDED(cookie->get_Expires(&expires))) {
-                                            expires = 0;
-                                        }
-
-                                        // httpOnly
-                                        BOOL httpOnly = FALSE;
-                                        if (SUCCEEDED(cookie->get_IsHttpOnly(&httpOnly))) {
-                                            httpOnly = FALSE;
-                                        }
-
-                                        // Secure
-                                        BOOL secure = FALSE;
-                                        if (SUCCEEDED(cookie->get_IsSecure(&secure))) {
-                                            secure = FALSE;
-                                        }
-
-                                        // Session
-                                        BOOL session = FALSE;
-                                        if (SUCCEEDED(cookie->get_IsSession(&session))) {
-                                            session = FALSE;
-                                        }
-
-                                        QJsonValueRef refDomain = cookies[strDomain];
-                                        QJsonObject jsonDomain = refDomain.toObject();
-                                        jsonDomain[strName] = QJsonObject{
-                                            { "value", strValue },
-                                            { "path", strPath },
-                                            { "expires", expires },
-                                            { "httpOnly", (bool)httpOnly },
-                                            { "secure", (bool)secure },
-                                            { "session", (bool)session },
-                                        };
-                                        refDomain = jsonDomain;
-                                    }
+                                    cookies.append(fromWebView2Cookie(cookie.Get()));
                                 }
                             }
-                            if (cb) {
-                                QMetaObject::invokeMethod(this, [cb, cookies] { cb(cookies); });
-                            }
-                            return S_OK;
-                        })
-                        .Get());
-        Q_ASSERT_SUCCEEDED(hr);
-    } else {
+                            QNativeWebProfilePrivate::get(profile)->setCookies(cookies);
+                        }
+                        if (callback) {
+                            callback();
+                        }
+                        return S_OK;
+                    })
+                    .Get());
+    Q_ASSERT_SUCCEEDED(hr);
+}
+
+void QWebView2WebViewPrivate::allCookies(const std::function<void(const QJsonObject &)> &callback)
+{
+    if (!m_webview || !m_cookieManager) {
         if (callback) {
             callback(QJsonObject());
         }
+        return;
     }
+
+    // The mirror builds each domain object once instead of copying it per cookie
+    QPointer<QNativeWebProfile> profile = m_profile;
+    refreshCookies([this, profile, callback] {
+        if (callback) {
+            const QJsonObject cookies = profile
+                    ? QNativeWebProfilePrivate::get(profile)->cookiesToJson()
+                    : QJsonObject();
+            QMetaObject::invokeMethod(this, [callback, cookies] { callback(cookies); });
+        }
+    });
 }
 
 bool QWebView2WebViewPrivate::setCookie(const QString &domain, const QString &name,
@@ -296,6 +295,7 @@ bool QWebView2WebViewPrivate::setCookie(const QString &domain, const QString &na
                                               (wchar_t *)domain.utf16(), L"", &cookie);
         if (SUCCEEDED(hr)) {
             hr = m_cookieManager->AddOrUpdateCookie(cookie.Get());
+            refreshCookies();
             return SUCCEEDED(hr);
         }
     }
@@ -340,6 +340,7 @@ void QWebView2WebViewPrivate::deleteCookie(const QString &domain, const QString
         hr = m_cookieManager->DeleteCookiesWithDomainAndPath((wchar_t *)name.utf16(),
                                                              (wchar_t *)domain.utf16(), L"");
         Q_ASSERT_SUCCEEDED(hr);
+        refreshCookies();
     }
 }
 
@@ -348,6 +349,7 @@ void QWebView2WebViewPrivate::deleteAllCookies()
     if (m_webview && m_cookieManager) {
         HRESULT hr = m_cookieManager->DeleteAllCookies();
         Q_ASSERT_SUCCEEDED(hr);
+        refreshCookies();
     }
 }
 
@@ -386,8 +388,9 @@ void QWebView2WebViewPrivate::evaluateJavaScript(
                             }
                         }
                         if (errorCode != S_OK) {
-                            QMetaObject::invokeMethod(
-                                    this, [cb, errorCode] { cb(qt_error_string(errorCode)); });
+                            qWarning() << "Failed to evaluate JavaScript:"
+                                       << qt_error_string(errorCode);
+                            QMetaObject::invokeMethod(this, [cb] { cb(QVariant()); });
                         } else {
                             QMetaObject::invokeMethod(this,
                                                       [cb, resultVariant] { cb(resultVariant); });
@@ -402,14 +405,20 @@ HRESULT
 QWebView2WebViewPrivate::onNavigationStarting(ICoreWebView2 *webview,
                                               ICoreWebView2NavigationStartingEventArgs *args)
 {
-    emit loadStarted();
-    emit loadProgress(25);
     wchar_t *uri;
     HRESULT hr = args->get_Uri(&uri);
     Q_ASSERT_SUCCEEDED(hr);
-    m_url = QString::fromStdWString(uri);
-    emit urlChanged(m_url);
+    const QUrl url(QString::fromStdWString(uri));
     CoTaskMemFree(uri);
+    if (!isNavigationAllowed(url)) {
+        args->put_Cancel(TRUE);
+        return S_OK;
+    }
+
+    emit loadStarted();
+    emit loadProgress(25);
+    m_url = url;
+    emit urlChanged(m_url);
     return S_OK;
 }
 
@@ -424,6 +433,7 @@ QWebView2WebViewPrivate::onNavigationCompleted(ICoreWebView2 *webview,
     Q_ASSERT_SUCCEEDED(hr);
 
     emit loadFinished(isSuccess);
+    refreshCookies();
 
     COREWEBVIEW2_WEB_ERROR_STATUS errorStatus;
     hr = args->get_WebErrorStatus(&errorStatus);
@@ -442,14 +452,13 @@ HRESULT
 QWebView2WebViewPrivate::onWebResourceRequested(ICoreWebView2 *webview,
                                                 ICoreWebView2WebResourceRequestedEventArgs *args)
 {
-    /*
     ComPtr<ICoreWebView2WebResourceRequest> request;
     ComPtr<ICoreWebView2WebResourceResponse> response;
     HRESULT hr = args->get_Request(&request);
     Q_ASSERT_SUCCEEDED(hr);
     wchar_t *uri;
     hr = request->get_Uri(&uri);
-    std::wstring_view source(uri);
+    Q_ASSERT_SUCCEEDED(hr);
 
     if (!m_settings->allowFileAccess()) {
         ComPtr<ICoreWebView2Environment> environment;
@@ -458,17 +467,113 @@ QWebView2WebViewPrivate::onWebResourceRequested(ICoreWebView2 *webview,
         webview2->get_Environment(&environment);
 
         hr = environment->CreateWebResourceResponse(nullptr, 403, L"Access Denied", L"", &response);
-        Q_ASSERT_SUCCEEDED(hr)
+        Q_ASSERT_SUCCEEDED(hr);
         hr = args->put_Response(response.Get());
-        Q_ASSERT_SUCCEEDED(hr)
+        Q_ASSERT_SUCCEEDED(hr);
     }
 
     CoTaskMemFree(uri);
-    */
 
     return S_OK;
 }
 
+void QWebView2WebViewPrivate::applySettings()
+{
+    if (m_webview) {
+        ComPtr<ICoreWebView2Settings> settings;
+        HRESULT hr = m_webview->get_Settings(&settings);
+        Q_ASSERT_SUCCEEDED(hr);
+        hr = settings->put_IsScriptEnabled(m_settings->javaScriptEnabled());
+        Q_ASSERT_SUCCEEDED(hr);
+    }
+}
+
+void QWebView2WebViewPrivate::applyUserContent()
+{
+    if (!m_webview) {
+        return;
+    }
+
+    for (const QString &id : qAsConst(m_userScriptIds)) {
+        m_webview->RemoveScriptToExecuteOnDocumentCreated((wchar_t *)id.utf16());
+    }
+    m_userScriptIds.clear();
+    const int generation = ++m_userContentGeneration;
+
+    // WebView2 runs these scripts in the top frame when a document is created
+    QPointer<QWebView2WebViewPrivate> thisPtr = this;
+    auto addScript = [this, thisPtr, generation](const QString &source) {
+        const HRESULT hr = m_webview->AddScriptToExecuteOnDocumentCreated(
+                (wchar_t *)source.utf16(),
+                Microsoft::WRL::Callback<
+                        ICoreWebView2AddScriptToExecuteOnDocumentCreatedCompletedHandler>(
+                        [thisPtr, generation](HRESULT result, LPCWSTR id) -> HRESULT {
+                            if (FAILED(result) || !thisPtr) {
+                                return S_OK;
+                            }
+                            // Content changed again before the id arrived
+                            if (generation != thisPtr->m_userContentGeneration) {
+                                thisPtr->m_webview->RemoveScriptToExecuteOnDocumentCreated(id);
+                            } else {
+                                thisPtr->m_userScriptIds.append(QString::fromWCharArray(id));
+                            }
+                            return S_OK;
+                        })
+                        .Get());
+        Q_ASSERT_SUCCEEDED(hr);
+    };
+
+    // WebView2 has a single message channel; the shim gives page scripts the
+    // window.webkit.messageHandlers interface of the other backends and prefixes
+    // every message with the handler name
+    addScript(QStringLiteral(
+            "(function() {\n"
+            "    if (!window.chrome || !window.chrome.webview || window.webkit) return;\n"
+            "    var webview = window.chrome.webview;\n"
+            "    window.webkit = { messageHandlers: new Proxy({}, { get: function(t, name) {\n"
+            "        return { postMessage: function(message) {\n"
+            "            webview.postMessage(String(name) + ':' + String(message));\n"
+            "        } };\n"
+            "    } }) };\n"
+            "})();"));
+    for (const MessageHandlerEntry &entry : qAsConst(m_messageHandlers)) {
+        if (!entry.script.isEmpty()) {
+            addScript(entry.script);
+        }
+    }
+
+    for (const QNativeWebUserContent &content :
+         QNativeWebProfilePrivate::get(m_profile)->userContent) {
+        QString source = content.styleSheet
+                ? QNativeWebProfilePrivate::styleSheetScript(content.source)
+                : content.source;
+        if (!content.styleSheet && content.injectionTime == QNativeWebProfile::DocumentEnd) {
+            source = QStringLiteral("document.addEventListener('DOMContentLoaded', function() {\n"
+                                    "%1\n});")
+                             .arg(source);
+        }
+        addScript(source);
+    }
+}
+
+HRESULT QWebView2WebViewPrivate::onWebMessageReceived(
+        ICoreWebView2 *webview, ICoreWebView2WebMessageReceivedEventArgs *args)
+{
+    Q_UNUSED(webview);
+    wchar_t *raw = nullptr;
+    // Fails for messages that were not posted as strings
+    if (FAILED(args->TryGetWebMessageAsString(&raw))) {
+        return S_OK;
+    }
+    const QString message = QString::fromWCharArray(raw);
+    CoTaskMemFree(raw);
+    const int separator = message.indexOf(QLatin1Char(':'));
+    if (separator > 0) {
+        dispatchMessage(message.left(separator), message.mid(separator + 1));
+    }
+    return S_OK;
+}
+
 HRESULT QWebView2WebViewPrivate::onContentLoading(ICoreWebView2 *webview,
                                                   ICoreWebView2ContentLoadingEventArgs *args)
 {
@@ -504,6 +609,23 @@ QWebView2WebViewPrivate::onNewWindowRequested(ICoreWebView2 *webview,
     return S_OK;
 }
 
+HRESULT QWebView2WebViewPrivate::onProcessFailed(ICoreWebView2 *webview,
+                                                 ICoreWebView2ProcessFailedEventArgs *args)
+{
+    Q_UNUSED(webview);
+    COREWEBVIEW2_PROCESS_FAILED_KIND kind;
+    HRESULT hr = args->get_ProcessFailedKind(&kind);
+    Q_ASSERT_SUCCEEDED(hr);
+    // An unresponsive renderer is left alone, a dead browser process would need a new
+    // controller and is only reported
+    if (kind == COREWEBVIEW2_PROCESS_FAILED_KIND_RENDER_PROCESS_EXITED) {
+        handleRenderProcessTerminated(QNativeWebPage::RenderProcessCrashed);
+    } else if (kind == COREWEBVIEW2_PROCESS_FAILED_KIND_BROWSER_PROCESS_EXITED) {
+        emit renderProcessTerminated(QNativeWebPage::RenderProcessCrashed);
+    }
+    return S_OK;
+}
+
 void QWebView2WebViewPrivate::updateWindowGeometry()
 {
     if (m_webviewController) {
@@ -550,18 +672,22 @@ void QWebView2WebViewPrivate::initialize()
         Q_ASSERT_SUCCEEDED(hr);
         hr = webview2->get_CookieManager(&m_cookieManager);
         Q_ASSERT_SUCCEEDED(hr);
+        refreshCookies();
 
         // Add a few settings for the webview
         ComPtr<ICoreWebView2Settings> settings;
         hr = m_webview->get_Settings(&settings);
         Q_ASSERT_SUCCEEDED(hr);
-        hr = settings->put_IsScriptEnabled(TRUE /*m_settings->javaScriptEnabled()*/);
+        hr = settings->put_IsScriptEnabled(m_settings->javaScriptEnabled());
         Q_ASSERT_SUCCEEDED(hr);
         hr = settings->put_AreDefaultScriptDialogsEnabled(TRUE);
         Q_ASSERT_SUCCEEDED(hr);
         hr = settings->put_IsWebMessageEnabled(TRUE);
         Q_ASSERT_SUCCEEDED(hr);
 
+        // Scripts have to be registered before the first navigation
+        applyUserContent();
+
         QMetaObject::invokeMethod(this, "updateWindowGeometry", Qt::QueuedConnection);
 
         // Schedule an async task to navigate to the url
@@ -645,6 +771,28 @@ void QWebView2WebViewPrivate::initialize()
                 &token);
         Q_ASSERT_SUCCEEDED(hr);
 
+        // add_WebMessageReceived
+        hr = m_webview->add_WebMessageReceived(
+                Microsoft::WRL::Callback<ICoreWebView2WebMessageReceivedEventHandler>(
+                        [this](ICoreWebView2 *webview,
+                               ICoreWebView2WebMessageReceivedEventArgs *args) -> HRESULT {
+                            return this->onWebMessageReceived(webview, args);
+                        })
+                        .Get(),
+                &token);
+        Q_ASSERT_SUCCEEDED(hr);
+
+        // add_ProcessFailed
+        hr = m_webview->add_ProcessFailed(
+                Microsoft::WRL::Callback<ICoreWebView2ProcessFailedEventHandler>(
+                        [this](ICoreWebView2 *webview,
+                               ICoreWebView2ProcessFailedEventArgs *args) -> HRESULT {
+                            return this->onProcessFailed(webview, args);
+                        })
+                        .Get(),
+                &token);
+        Q_ASSERT_SUCCEEDED(hr);
+
         // add_NewWindowRequested
         hr = m_webview->add_NewWindowRequested(
                 Microsoft::WRL::Callback<ICoreWebView2NewWindowRequestedEventHandler>(
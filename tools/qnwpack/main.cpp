@@ -0,0 +1,37 @@
+#include "qnativewebassetpack.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("qnwpack");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Packs a directory of web assets for QNativeWebAssetPack");
+    parser.addHelpOption();
+    parser.addPositionalArgument("source", "Directory with the assets");
+    parser.addPositionalArgument("pack", "Asset pack file to write");
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 2) {
+        parser.showHelp(1);
+    }
+
+    QString error;
+    if (!QNativeWebAssetPack::build(arguments.at(0), arguments.at(1), &error)) {
+        QTextStream(stderr) << "qnwpack: " << error << '\n';
+        return 1;
+    }
+
+    QNativeWebAssetPack pack;
+    if (!pack.open(arguments.at(1))) {
+        QTextStream(stderr) << "qnwpack: " << pack.errorString() << '\n';
+        return 1;
+    }
+    QTextStream(stdout) << "Packed " << pack.count() << " assets into " << arguments.at(1) << '\n';
+    return 0;
+}